@@ -0,0 +1,15 @@
+/*
+ * Asp benchmark application script context.
+ */
+
+#ifndef ASP_BENCH_CONTEXT_H
+#define ASP_BENCH_CONTEXT_H
+
+#include <string>
+
+typedef struct
+{
+    std::string output; /* Printed output. */
+} BenchAspContext;
+
+#endif
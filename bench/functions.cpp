@@ -0,0 +1,70 @@
+//
+// Asp benchmark application functions implementation.
+//
+
+#include "asp.h"
+#include "bench.h"
+#include "context.h"
+
+static AspRunResult asp_print1(AspEngine *, AspDataEntry *);
+
+/* print(*values, sep, end)
+ * Append values to the run's captured output rather than printing them, so
+ * that console output does not contribute to the measured time.
+ * Separate individual items with the sep value and finish with the end value.
+ */
+extern "C" AspRunResult asp_print
+    (AspEngine *engine,
+     AspDataEntry *values, /* iterable group */
+     AspDataEntry *sep, AspDataEntry *end,
+     AspDataEntry **returnValue)
+{
+    AspRunResult result = AspRunResult_OK;
+
+    int32_t argCount;
+    result = AspCount(engine, values, &argCount);
+    if (result != AspRunResult_OK)
+        return result;
+    for (int32_t i = 0; i < argCount; i++)
+    {
+        if (i != 0)
+        {
+            result = asp_print1(engine, sep);
+            if (result != AspRunResult_OK)
+                return result;
+        }
+
+        AspDataEntry *value = AspElement(engine, values, i);
+        result = asp_print1(engine, value);
+        if (result != AspRunResult_OK)
+            return result;
+    }
+
+    return asp_print1(engine, end);
+}
+
+static AspRunResult asp_print1
+    (AspEngine *engine, AspDataEntry *value)
+{
+    auto context = static_cast<BenchAspContext *>(AspContext(engine));
+
+    AspDataEntry *valueString = AspToString(engine, value);
+    if (valueString == nullptr)
+        return AspRunResult_OutOfDataMemory;
+
+    size_t size;
+    AspStringValue(engine, valueString, &size, nullptr, 0, 0);
+    char buffer[16];
+    for (size_t index = 0; index < size; index += sizeof buffer)
+    {
+        size_t bufferLen = sizeof buffer;
+        if (index + sizeof buffer > size)
+            bufferLen = size - index;
+        AspStringValue
+            (engine, valueString, nullptr, buffer, index, sizeof buffer);
+        context->output.append(buffer, bufferLen);
+    }
+
+    AspUnref(engine, valueString);
+    return AspRunResult_OK;
+}
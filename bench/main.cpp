@@ -0,0 +1,407 @@
+//
+// Asp benchmark runner main.
+//
+
+#include "asp.h"
+#include "asp-info.h"
+#include "bench.h"
+#include "context.h"
+#include <chrono>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+
+using namespace std;
+
+static const size_t DEFAULT_DATA_ENTRY_COUNT = 16384;
+static const unsigned DEFAULT_RUN_COUNT = 3;
+static const uint32_t RUN_STEP_LIMIT = 10000;
+
+// Engine configuration shared by all benchmark runs.
+struct BenchConfig
+{
+    size_t dataEntryCount = DEFAULT_DATA_ENTRY_COUNT;
+    size_t codeByteCount = 0, codePageByteCount = 0;
+    unsigned runCount = DEFAULT_RUN_COUNT;
+};
+
+// The outcome of one run of a benchmark script. Apart from the time, the
+// outcome is the same for every run of a given script.
+struct BenchRun
+{
+    string error;
+    AspRunResult result = AspRunResult_OK;
+    string output;
+    unsigned long long instructionCount = 0;
+    double time = 0.0;
+    size_t codePageReadCount = 0;
+    size_t lowFreeCount = 0;
+};
+
+static void Usage();
+static bool RunScript
+    (const BenchConfig &, const string &fileName, BenchRun &);
+static AspRunResult LoadCodePage
+    (void *, uint32_t offset, size_t *size, void *codePage);
+static string BenchName(const string &fileName);
+static string JsonString(const string &);
+
+int main(int argc, char **argv)
+{
+    // Process command line options.
+    BenchConfig config;
+    string outputFileName;
+    for (; argc >= 2 && argv[1][0] == '-'; argc--, argv++)
+    {
+        string option = argv[1] + 1;
+        if (option == "-")
+        {
+            argc--; argv++;
+            break;
+        }
+
+        if (option == "h" || option == "?")
+        {
+            Usage();
+            return 0;
+        }
+        if (argc < 3)
+        {
+            cerr << "Missing value for option -" << option << endl;
+            return 1;
+        }
+        string value = (++argv)[1];
+        argc--;
+        if (option == "d")
+            config.dataEntryCount = static_cast<size_t>(atoi(value.c_str()));
+        else if (option == "c")
+            config.codeByteCount = static_cast<size_t>(atoi(value.c_str()));
+        else if (option == "p")
+            config.codePageByteCount =
+                static_cast<size_t>(atoi(value.c_str()));
+        else if (option == "r")
+        {
+            config.runCount = static_cast<unsigned>(atoi(value.c_str()));
+            if (config.runCount == 0)
+                config.runCount = 1;
+        }
+        else if (option == "o")
+            outputFileName = value;
+        else
+        {
+            cerr << "Invalid option: -" << option << endl;
+            Usage();
+            return 1;
+        }
+    }
+    if (argc < 2)
+    {
+        cerr << "No benchmark scripts specified" << endl;
+        Usage();
+        return 1;
+    }
+    if (config.codePageByteCount != 0 && config.codeByteCount == 0)
+    {
+        cerr << "Code page size requires a code size" << endl;
+        return 1;
+    }
+
+    // Run each script the requested number of times, keeping the fastest
+    // run, and report the results as a JSON object.
+    ostringstream report;
+    uint8_t engineVersion[4];
+    AspEngineVersion(engineVersion);
+    report
+        << "{\n"
+        << "  \"engine_version\": \""
+        << static_cast<unsigned>(engineVersion[0]) << '.'
+        << static_cast<unsigned>(engineVersion[1]) << '.'
+        << static_cast<unsigned>(engineVersion[2]) << '.'
+        << static_cast<unsigned>(engineVersion[3]) << "\",\n"
+        << "  \"data_entry_count\": " << config.dataEntryCount << ",\n"
+        << "  \"code_size\": " << config.codeByteCount << ",\n"
+        << "  \"code_page_size\": " << config.codePageByteCount << ",\n"
+        << "  \"run_count\": " << config.runCount << ",\n"
+        << "  \"benchmarks\": [";
+    bool failed = false;
+    for (int i = 1; i < argc; i++)
+    {
+        string fileName = argv[i];
+        BenchRun bestRun;
+        for (unsigned runIndex = 0; runIndex < config.runCount; runIndex++)
+        {
+            BenchRun run;
+            if (!RunScript(config, fileName, run))
+            {
+                bestRun = run;
+                break;
+            }
+            if (runIndex == 0 || run.time < bestRun.time)
+                bestRun = run;
+        }
+
+        report
+            << (i == 1 ? "" : ",") << "\n    {\n"
+            << "      \"name\": " << JsonString(BenchName(fileName)) << ",\n";
+        if (!bestRun.error.empty())
+        {
+            failed = true;
+            report
+                << "      \"error\": " << JsonString(bestRun.error) << "\n"
+                << "    }";
+            continue;
+        }
+        if (bestRun.result != AspRunResult_Complete)
+            failed = true;
+        double instructionRate = bestRun.time > 0.0 ?
+            bestRun.instructionCount / bestRun.time : 0.0;
+        report
+            << "      \"result\": " << JsonString
+                (AspRunResultToString(static_cast<int>(bestRun.result)))
+            << ",\n"
+            << "      \"output\": " << JsonString(bestRun.output) << ",\n"
+            << "      \"instruction_count\": " << bestRun.instructionCount
+            << ",\n"
+            << fixed
+            << "      \"wall_time\": " << setprecision(6) << bestRun.time
+            << ",\n"
+            << "      \"instructions_per_second\": " << setprecision(0)
+            << instructionRate << ",\n"
+            << "      \"code_page_read_count\": "
+            << bestRun.codePageReadCount << ",\n"
+            << "      \"low_free_count\": " << bestRun.lowFreeCount << "\n"
+            << "    }";
+    }
+    report << "\n  ]\n}\n";
+
+    if (outputFileName.empty())
+        cout << report.str();
+    else
+    {
+        ofstream outputFile(outputFileName);
+        outputFile << report.str();
+        if (!outputFile)
+        {
+            cerr
+                << "Error writing " << outputFileName
+                << ": " << strerror(errno) << endl;
+            return 2;
+        }
+    }
+
+    return failed ? 2 : 0;
+}
+
+static void Usage()
+{
+    cerr
+        << "Usage:      bench-engine [OPTION]... [--] SCRIPT...\n"
+        << "\n"
+        << "Run each Asp script executable SCRIPT (*.aspe) in turn and report"
+        << " the\n"
+        << "instruction count, the wall time and instruction rate of the"
+        << " fastest run,\n"
+        << "the number of code page reads, and the low free count, as JSON.\n"
+        << "\n"
+        << "Options:\n"
+        << "-h          Print usage information.\n"
+        << "-d n        Data entry count, where each entry is "
+        << AspDataEntrySize() << " bytes."
+        << " Default is " << DEFAULT_DATA_ENTRY_COUNT << ".\n"
+        << "-c n        Code size, in bytes. The default is 0, which runs the"
+        << " code directly\n"
+        << "            from a copy of the whole SCRIPT file.\n"
+        << "-p n        Code page size, in bytes. The default is 0, which"
+        << " disables paging\n"
+        << "            mode. Requires -c.\n"
+        << "-r n        Number of times to run each script. Default is "
+        << DEFAULT_RUN_COUNT << ".\n"
+        << "-o file     Write the report to file instead of standard"
+        << " output.\n";
+}
+
+static bool RunScript
+    (const BenchConfig &config, const string &fileName, BenchRun &run)
+{
+    BenchAspContext context;
+    AspEngine engine;
+    auto code = unique_ptr<char[]>
+        (config.codeByteCount == 0 ?
+         nullptr : new char[config.codeByteCount]);
+    size_t dataByteSize = config.dataEntryCount * AspDataEntrySize();
+    auto data = unique_ptr<char[]>(new char[dataByteSize]);
+    AspRunResult initializeResult = AspInitialize
+        (&engine, code.get(), config.codeByteCount, data.get(), dataByteSize,
+         &AspAppSpec_bench, &context);
+    if (initializeResult != AspRunResult_OK)
+    {
+        run.error = string("Initialize error: ") +
+            AspRunResultToString(static_cast<int>(initializeResult));
+        return false;
+    }
+
+    // Load the executable in the way requested. Loading is not timed.
+    struct FileCloser
+    {
+        void operator()(FILE *file) const
+        {
+            fclose(file);
+        }
+    };
+    auto file = unique_ptr<FILE, FileCloser>(fopen(fileName.c_str(), "rb"));
+    if (file == nullptr)
+    {
+        run.error = "Error opening " + fileName + ": " + strerror(errno);
+        return false;
+    }
+    auto externalCode = unique_ptr<char[]>();
+    AspAddCodeResult loadResult = AspAddCodeResult_OK;
+    if (config.codeByteCount == 0)
+    {
+        long fileSize = -1;
+        if (fseek(file.get(), 0, SEEK_END) == 0)
+            fileSize = ftell(file.get());
+        rewind(file.get());
+        if (fileSize <= 0)
+        {
+            run.error = "Error determining size of " + fileName;
+            return false;
+        }
+        auto codeSize = static_cast<size_t>(fileSize);
+        externalCode.reset(new char[codeSize]);
+        if (fread(externalCode.get(), codeSize, 1, file.get()) != 1)
+        {
+            run.error = "Error reading " + fileName;
+            return false;
+        }
+        loadResult = AspSealCode(&engine, externalCode.get(), codeSize);
+    }
+    else if (config.codePageByteCount == 0)
+    {
+        char buffer[BUFSIZ];
+        size_t readCount;
+        while (loadResult == AspAddCodeResult_OK &&
+               (readCount = fread
+                    (buffer, 1, sizeof buffer, file.get())) != 0)
+            loadResult = AspAddCode(&engine, buffer, readCount);
+        if (loadResult == AspAddCodeResult_OK)
+            loadResult = AspSeal(&engine);
+    }
+    else
+    {
+        size_t codePageCount =
+            config.codeByteCount / config.codePageByteCount;
+        AspRunResult pagingResult =
+            codePageCount == 0 || codePageCount > UINT16_MAX ?
+            AspRunResult_InitializationError :
+            AspSetCodePaging
+                (&engine, static_cast<uint16_t>(codePageCount),
+                 config.codePageByteCount, LoadCodePage);
+        if (pagingResult != AspRunResult_OK)
+        {
+            run.error = string("Error initializing code paging: ") +
+                AspRunResultToString(static_cast<int>(pagingResult));
+            return false;
+        }
+        loadResult = AspPageCode(&engine, file.get());
+    }
+    if (loadResult != AspAddCodeResult_OK)
+    {
+        run.error = string("Load error: ") +
+            AspAddCodeResultToString(static_cast<int>(loadResult));
+        return false;
+    }
+
+    // Run the script to completion.
+    auto startTime = chrono::steady_clock::now();
+    AspRunResult runResult = AspRunResult_OK;
+    while (runResult == AspRunResult_OK)
+    {
+        uint32_t stepCount;
+        runResult = AspRun(&engine, RUN_STEP_LIMIT, &stepCount);
+        run.instructionCount += stepCount;
+    }
+    run.time = chrono::duration<double>
+        (chrono::steady_clock::now() - startTime).count();
+
+    run.result = runResult;
+    run.output = context.output;
+    run.codePageReadCount = AspCodePageReadCount(&engine, false);
+    run.lowFreeCount = AspLowFreeCount(&engine);
+    return true;
+}
+
+static AspRunResult LoadCodePage
+    (void *id, uint32_t offset, size_t *size, void *codePage)
+{
+    auto file = static_cast<FILE *>(id);
+
+    int result = fseek(file, (long)offset, SEEK_SET);
+    if (result != 0)
+        return ferror(file) != 0 ?
+            AspRunResult_Application : AspRunResult_BeyondEndOfCode;
+
+    size_t readCount = fread(codePage, 1, *size, file);
+    if (ferror(file) != 0)
+        return AspRunResult_Application;
+    *size = readCount;
+
+    return AspRunResult_OK;
+}
+
+static string BenchName(const string &fileName)
+{
+    // Strip any directory and the executable suffix.
+    static const string executableSuffix = ".aspe";
+    auto nameIndex = fileName.find_last_of("/\\");
+    string name = nameIndex == string::npos ?
+        fileName : fileName.substr(nameIndex + 1);
+    if (name.size() > executableSuffix.size() &&
+        name.compare
+            (name.size() - executableSuffix.size(), string::npos,
+             executableSuffix) == 0)
+        name.erase(name.size() - executableSuffix.size());
+    return name;
+}
+
+static string JsonString(const string &s)
+{
+    ostringstream result;
+    result << '"';
+    for (auto c: s)
+    {
+        switch (c)
+        {
+            case '"':
+                result << "\\\"";
+                break;
+            case '\\':
+                result << "\\\\";
+                break;
+            case '\n':
+                result << "\\n";
+                break;
+            case '\t':
+                result << "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                    result
+                        << "\\u" << hex << setfill('0') << setw(4)
+                        << static_cast<unsigned>(c) << dec;
+                else
+                    result << c;
+                break;
+        }
+    }
+    result << '"';
+    return result.str();
+}
@@ -14,6 +14,14 @@
 
 using namespace std;
 
+static Instruction *NewLoadVariableInstruction
+    (const Statement *, int32_t symbol, bool address, const string &comment);
+static void EmitCondition(Executable &, const Expression *);
+static void EmitJumpIfFalse
+    (Executable &, const Expression *condition,
+     const Executable::Location &, const string &comment,
+     const SourceLocation &);
+
 void Block::Emit(Executable &executable) const
 {
     for (const auto &statement: statements)
@@ -35,12 +43,35 @@ void AssignmentStatement::Emit(Executable &executable) const
 
 void AssignmentStatement::Emit1(Executable &executable, bool top) const
 {
+    // An assignment of a binary operation whose left operand is the target
+    // variable (e.g., x = x + y) is performed like an augmented assignment.
+    auto variableExpression = dynamic_cast<const VariableExpression *>
+        (targetExpression);
+    auto binaryExpression = dynamic_cast<const BinaryExpression *>
+        (valueExpression);
+    if (top && assignmentTokenType == TOKEN_ASSIGN &&
+        variableExpression != nullptr && binaryExpression != nullptr &&
+        binaryExpression->UpdatesVariable(variableExpression->Name()))
+    {
+        binaryExpression->EmitUpdate(executable, *targetExpression);
+        return;
+    }
+
     if (assignmentTokenType != TOKEN_ASSIGN)
         targetExpression->Emit(executable, Expression::EmitType::Value);
 
+    // An integer constant operand of an augmented assignment is made part
+    // of the instruction that performs the operation.
+    auto constantExpression = dynamic_cast<const ConstantExpression *>
+        (valueExpression);
+    bool immediate =
+        assignmentTokenType != TOKEN_ASSIGN &&
+        constantExpression != nullptr &&
+        constantExpression->GetType() == ConstantExpression::Type::Integer;
+
     if (valueAssignmentStatement != nullptr)
         valueAssignmentStatement->Emit1(executable, false);
-    else
+    else if (!immediate)
         valueExpression->Emit(executable);
 
     if (assignmentTokenType != TOKEN_ASSIGN)
@@ -71,14 +102,42 @@ void AssignmentStatement::Emit1(Executable &executable, bool top) const
                 << assignmentTokenType;
             ThrowError(oss.str());
         }
+        // Unless the operation takes an immediate operand, combine it with
+        // the assignment, which allows the engine to update the target's
+        // value in place where possible.
+        bool combine =
+            top && !immediate &&
+            dynamic_cast<const TupleExpression *>(targetExpression) == nullptr;
+        if (combine)
+        {
+            targetExpression->Emit(executable, Expression::EmitType::Address);
+            ostringstream oss;
+            oss
+                << "Perform binary operation 0x"
+                << hex << uppercase << setfill('0')
+                << setw(2) << static_cast<unsigned>(iter->second)
+                << " and assign";
+            executable.Insert
+                (new SetOperationInstruction(iter->second, oss.str()),
+                 sourceLocation);
+            return;
+        }
+
         ostringstream oss;
         oss
             << "Perform binary operation 0x"
             << hex << uppercase << setfill('0')
             << setw(2) << static_cast<unsigned>(iter->second);
-        executable.Insert
-            (new BinaryInstruction(iter->second, oss.str()),
-             sourceLocation);
+        if (immediate)
+            executable.Insert
+                (new BinaryImmediateInstruction
+                    (iter->second, constantExpression->GetInteger(),
+                     oss.str()),
+                 sourceLocation);
+        else
+            executable.Insert
+                (new BinaryInstruction(iter->second, oss.str()),
+                 sourceLocation);
     }
 
     targetExpression->Emit(executable, Expression::EmitType::Address);
@@ -489,7 +548,7 @@ void AssertStatement::Emit(Executable &executable) const
 
 void IfStatement::Emit(Executable &executable) const
 {
-    conditionExpression->Emit(executable);
+    EmitCondition(executable, conditionExpression);
 
     auto elseLocation = executable.Insert
         (new NullInstruction, sourceLocation);
@@ -497,10 +556,9 @@ void IfStatement::Emit(Executable &executable) const
         (new NullInstruction, sourceLocation);
 
     executable.PushLocation(elseLocation);
-    executable.Insert
-        (new ConditionalJumpInstruction
-            (false, elseLocation, "Jump if false to else"),
-         sourceLocation);
+    EmitJumpIfFalse
+        (executable, conditionExpression,
+         elseLocation, "Jump if false to else", sourceLocation);
     trueBlock->Emit(executable);
     if (falseBlock != nullptr || elsePart != nullptr)
         executable.Insert
@@ -538,7 +596,7 @@ void WhileStatement::Emit(Executable &executable) const
 
     continueLocation = executable.Insert
         (new NullInstruction, sourceLocation);
-    conditionExpression->Emit(executable);
+    EmitCondition(executable, conditionExpression);
 
     auto elseLocation = executable.Insert
         (new NullInstruction, sourceLocation);
@@ -546,10 +604,9 @@ void WhileStatement::Emit(Executable &executable) const
         (new NullInstruction, sourceLocation);
 
     executable.PushLocation(elseLocation);
-    executable.Insert
-        (new ConditionalJumpInstruction
-            (false, elseLocation, "Jump if false to else"),
-         sourceLocation);
+    EmitJumpIfFalse
+        (executable, conditionExpression,
+         elseLocation, "Jump if false to else", sourceLocation);
     if (falseBlock != nullptr)
     {
         auto loopedExpression = new VariableExpression
@@ -727,6 +784,8 @@ void DefStatement::Emit(Executable &executable) const
     executable.PopLocation();
 
     executable.PushLocation(defineLocation);
+    auto bodyLocation = executable.Insert
+        (new NullInstruction, sourceLocation);
     try
     {
         block->Emit(executable);
@@ -749,6 +808,21 @@ void DefStatement::Emit(Executable &executable) const
     }
     executable.PopLocation();
 
+    // Now that the body has assigned all the variable slots it uses, have
+    // the function reserve them on entry.
+    if (!localSlots.empty())
+    {
+        executable.PushLocation(bodyLocation);
+        executable.Insert
+            (new ReserveSlotsInstruction
+                (static_cast<uint8_t>(localSlots.size()),
+                 "Reserve local variable slots"),
+             sourceLocation);
+        executable.PopLocation();
+    }
+
+    executable.MarkFunctionLocation(name, entryLocation, defineLocation);
+
     parameterList->Emit(executable);
     executable.Insert
         (new PushCodeAddressInstruction(entryLocation, "Push code address"),
@@ -771,7 +845,7 @@ void ConditionalExpression::Emit
     else if (emitType == EmitType::Delete)
         ThrowError("Cannot delete value expression");
 
-    conditionExpression->Emit(executable);
+    EmitCondition(executable, conditionExpression);
 
     auto falseLocation = executable.Insert
         (new NullInstruction, sourceLocation);
@@ -779,10 +853,9 @@ void ConditionalExpression::Emit
         (new NullInstruction, sourceLocation);
 
     executable.PushLocation(falseLocation);
-    executable.Insert
-        (new ConditionalJumpInstruction
-            (false, falseLocation, "Jump if false to false expression"),
-         sourceLocation);
+    EmitJumpIfFalse
+        (executable, conditionExpression,
+         falseLocation, "Jump if false to false expression", sourceLocation);
     trueExpression->Emit(executable);
     executable.Insert
         (new JumpInstruction(endLocation, "Jump to end"),
@@ -851,8 +924,83 @@ void BinaryExpression::Emit
     else if (emitType == EmitType::Delete)
         ThrowError("Cannot delete value expression");
 
+    EmitOperands(executable);
+
+    auto opCode = OpCode();
+    ostringstream oss;
+    oss
+        << "Perform binary operation 0x"
+        << hex << uppercase << setfill('0')
+        << setw(2) << static_cast<unsigned>(opCode);
+    int32_t value;
+    if (ImmediateOperand(value))
+        executable.Insert
+            (new BinaryImmediateInstruction(opCode, value, oss.str()),
+             sourceLocation);
+    else
+        executable.Insert
+            (new BinaryInstruction(opCode, oss.str()),
+             sourceLocation);
+}
+
+void BinaryExpression::EmitOperands(Executable &executable) const
+{
+    // An integer constant right operand is made part of the instruction
+    // that performs the operation rather than being pushed separately.
+    leftExpression->Emit(executable);
+    int32_t value;
+    if (!ImmediateOperand(value))
+        rightExpression->Emit(executable);
+}
+
+void BinaryExpression::EmitJumpIfFalse
+    (Executable &executable, const Executable::Location &targetLocation,
+     const string &comment) const
+{
+    auto opCode = OpCode();
+    int32_t value;
+    if (ImmediateOperand(value))
+        executable.Insert
+            (new BinaryJumpInstruction(opCode, value, targetLocation, comment),
+             sourceLocation);
+    else
+        executable.Insert
+            (new BinaryJumpInstruction(opCode, targetLocation, comment),
+             sourceLocation);
+}
+
+bool BinaryExpression::UpdatesVariable(const string &name) const
+{
+    // Operations with an integer constant right operand are left to the
+    // instruction that takes the operand as part of the instruction.
+    auto variableExpression = dynamic_cast<const VariableExpression *>
+        (leftExpression);
+    int32_t value;
+    return
+        variableExpression != nullptr &&
+        variableExpression->Name() == name &&
+        !ImmediateOperand(value);
+}
+
+void BinaryExpression::EmitUpdate
+    (Executable &executable, const Expression &targetExpression) const
+{
     leftExpression->Emit(executable);
     rightExpression->Emit(executable);
+    targetExpression.Emit(executable, EmitType::Address);
+
+    auto opCode = OpCode();
+    ostringstream oss;
+    oss
+        << "Perform binary operation 0x"
+        << hex << uppercase << setfill('0')
+        << setw(2) << static_cast<unsigned>(opCode) << " and assign";
+    executable.Insert
+        (new SetOperationInstruction(opCode, oss.str()), sourceLocation);
+}
+
+uint8_t BinaryExpression::OpCode() const
+{
     static map<int, uint8_t> opCodes =
     {
         {TOKEN_BAR, OpCode_OR},
@@ -889,14 +1037,29 @@ void BinaryExpression::Emit
             << operatorTokenType;
         ThrowError(oss.str());
     }
-    ostringstream oss;
-    oss
-        << "Perform binary operation 0x"
-        << hex << uppercase << setfill('0')
-        << setw(2) << static_cast<unsigned>(iter->second);
-    executable.Insert
-        (new BinaryInstruction(iter->second, oss.str()),
-         sourceLocation);
+    return iter->second;
+}
+
+bool BinaryExpression::ImmediateOperand(int32_t &value) const
+{
+    // Membership and identity operations require an actual object for the
+    // right operand.
+    switch (operatorTokenType)
+    {
+        case TOKEN_NOT_IN:
+        case TOKEN_IN:
+        case TOKEN_IS_NOT:
+        case TOKEN_IS:
+            return false;
+    }
+
+    auto constantExpression = dynamic_cast<const ConstantExpression *>
+        (rightExpression);
+    if (constantExpression == nullptr ||
+        constantExpression->GetType() != ConstantExpression::Type::Integer)
+        return false;
+    value = constantExpression->GetInteger();
+    return true;
 }
 
 void UnaryExpression::Emit
@@ -950,7 +1113,8 @@ void TargetExpression::Emit
         ostringstream oss;
         oss << "Push address of variable " << name;
         executable.Insert
-            (new LoadInstruction(symbol, true, oss.str()),
+            (NewLoadVariableInstruction
+                (Expression::Parent(), symbol, true, oss.str()),
              sourceLocation);
     }
     else
@@ -1092,8 +1256,8 @@ void VariableExpression::Emit
         << "Push " << (emitType == EmitType::Address ? "address" : "value")
         << " of variable " << name;
     executable.Insert
-        (new LoadInstruction
-            (symbol, emitType == EmitType::Address, oss.str()),
+        (NewLoadVariableInstruction
+            (Parent(), symbol, emitType == EmitType::Address, oss.str()),
          sourceLocation);
 }
 
@@ -1267,3 +1431,47 @@ void ConstantExpression::Emit
             break;
     }
 }
+
+static Instruction *NewLoadVariableInstruction
+    (const Statement *statement, int32_t symbol, bool address,
+     const string &comment)
+{
+    // Within a function, refer to the variable via a local slot so that
+    // the engine can avoid repeated namespace lookups. The symbol is
+    // retained for the cases where the variable is not (yet) local.
+    const DefStatement *parentDef =
+        statement != nullptr ? statement->ParentDef() : nullptr;
+    uint8_t slot;
+    if (parentDef != nullptr && parentDef->LocalSlot(symbol, slot))
+        return new LoadLocalInstruction(slot, symbol, address, comment);
+
+    return new LoadInstruction(symbol, address, comment);
+}
+
+static void EmitCondition
+    (Executable &executable, const Expression *conditionExpression)
+{
+    // Defer a binary operation so that it can be combined with the
+    // subsequent conditional jump.
+    auto binaryExpression = dynamic_cast<const BinaryExpression *>
+        (conditionExpression);
+    if (binaryExpression != nullptr)
+        binaryExpression->EmitOperands(executable);
+    else
+        conditionExpression->Emit(executable);
+}
+
+static void EmitJumpIfFalse
+    (Executable &executable, const Expression *conditionExpression,
+     const Executable::Location &targetLocation, const string &comment,
+     const SourceLocation &sourceLocation)
+{
+    auto binaryExpression = dynamic_cast<const BinaryExpression *>
+        (conditionExpression);
+    if (binaryExpression != nullptr)
+        binaryExpression->EmitJumpIfFalse(executable, targetLocation, comment);
+    else
+        executable.Insert
+            (new ConditionalJumpInstruction(false, targetLocation, comment),
+             sourceLocation);
+}
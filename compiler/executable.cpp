@@ -11,7 +11,7 @@
 
 using namespace std;
 
-static const string SourceInfoVersion = "\x01";
+static const string SourceInfoVersion = "\x02";
 
 static void WriteItem(ostream &, const string &);
 static void WriteItem(ostream &, uint32_t);
@@ -34,6 +34,26 @@ void Executable::SetCheckValue(uint32_t checkValue)
     this->checkValue = checkValue;
 }
 
+void Executable::SetOptimize(bool optimize)
+{
+    this->optimize = optimize;
+}
+
+void Executable::SetPageSize(size_t pageSize)
+{
+    this->pageSize = pageSize;
+}
+
+void Executable::SetPageCount(size_t pageCount)
+{
+    this->pageCount = pageCount;
+}
+
+void Executable::SetPageTrace(const vector<uint32_t> &pageTrace)
+{
+    this->pageTrace = pageTrace;
+}
+
 int32_t Executable::Symbol(const string &name) const
 {
     return symbolTable.Symbol(name);
@@ -82,9 +102,56 @@ unsigned Executable::ModuleOffset(const string &name) const
     return moduleLocations.find(symbol)->second.second;
 }
 
+void Executable::MarkFunctionLocation
+    (const string &name, const Location &entry, const Location &end)
+{
+    functionLocations.emplace_back(entry, end);
+    functionSymbols.push_back(Symbol(name));
+}
+
 void Executable::Finalize()
 {
+    // Apply peephole optimizations while instructions may still be
+    // rearranged freely.
+    if (optimize)
+        Optimize();
+
+    // Note which module or function each instruction belongs to while the
+    // code remains in its original order.
+    AssignCodeOwners();
+
+    // Arrange the code to suit the code page size if one is given. Any
+    // page trace refers to the layout as originally generated. Jumps left
+    // redundant by the new arrangement are then removed.
+    if (pageSize != 0)
+    {
+        AssignOffsets();
+        ResolvePageTrace();
+        Layout();
+        if (optimize)
+            Optimize();
+    }
+
     // Assign offsets to each instruction.
+    auto offset = AssignOffsets();
+
+    // Check final code size.
+    if (offset > MaxCodeSize)
+        throw string("Code too large");
+
+    // Fix up target locations.
+    for (const auto &instructionInfo: instructions)
+    {
+        const auto &instruction = instructionInfo.instruction;
+
+        if (!instruction->Fixed())
+            instruction->Fix
+                (instruction->TargetLocation()->instruction->Offset());
+    }
+}
+
+unsigned Executable::AssignOffsets()
+{
     unsigned offset = 0;
     for (auto instructionIter = instructions.begin();
          instructionIter != instructions.end(); instructionIter++)
@@ -104,18 +171,49 @@ void Executable::Finalize()
         offset += instruction->Size();
     }
 
-    // Check final code size.
-    if (offset > MaxCodeSize)
-        throw string("Code too large");
+    return offset;
+}
 
-    // Fix up target locations.
+void Executable::AssignCodeOwners()
+{
+    // Each function's code lies between its entry and end locations, and
+    // each module's code follows its entry location, except for the code of
+    // any functions nested within.
+    map<const InstructionInfo *, size_t> functionEntries, functionEnds;
+    codeOwners.clear();
+    for (size_t i = 0; i < functionLocations.size(); i++)
+    {
+        const auto &entry = functionLocations[i].first;
+        functionEntries[&*entry] = codeOwners.size();
+        functionEnds[&*functionLocations[i].second] = codeOwners.size();
+        codeOwners.emplace_back
+            (functionSymbols[i], entry->sourceLocation.line);
+    }
+    map<const InstructionInfo *, size_t> moduleEntries;
+    for (const auto &moduleLocation: moduleLocations)
+    {
+        moduleEntries[&*moduleLocation.second.first] = codeOwners.size();
+        codeOwners.emplace_back(moduleLocation.first, 0U);
+    }
+
+    codeOwnerIndices.clear();
+    vector<size_t> ownerStack;
     for (const auto &instructionInfo: instructions)
     {
-        const auto &instruction = instructionInfo.instruction;
+        if (functionEnds.count(&instructionInfo) != 0)
+            ownerStack.pop_back();
+        auto entryIter = functionEntries.find(&instructionInfo);
+        if (entryIter != functionEntries.end())
+            ownerStack.push_back(entryIter->second);
+        auto moduleIter = moduleEntries.find(&instructionInfo);
+        if (moduleIter != moduleEntries.end())
+        {
+            ownerStack.clear();
+            ownerStack.push_back(moduleIter->second);
+        }
 
-        if (!instruction->Fixed())
-            instruction->Fix
-                (instruction->TargetLocation()->instruction->Offset());
+        if (!ownerStack.empty())
+            codeOwnerIndices[&instructionInfo] = ownerStack.back();
     }
 }
 
@@ -305,6 +403,50 @@ void Executable::WriteSourceInfo(ostream &os) const
 
     // Terminate the symbol names list.
     os.put('\0');
+
+    // Write the code address ranges of each module and function, giving the
+    // name symbol and the line on which the function is defined (zero for a
+    // module).
+    auto ownerIndex = SIZE_MAX;
+    uint32_t rangeStart = 0, rangeEnd = 0;
+    for (auto iter = instructions.begin(); ; iter++)
+    {
+        auto nextOwnerIndex = SIZE_MAX;
+        if (iter != instructions.end())
+        {
+            if (iter->instruction->Size() == 0)
+                continue;
+            auto ownerIndexIter = codeOwnerIndices.find(&*iter);
+            if (ownerIndexIter != codeOwnerIndices.end())
+                nextOwnerIndex = ownerIndexIter->second;
+            if (nextOwnerIndex == ownerIndex)
+            {
+                rangeEnd += iter->instruction->Size();
+                continue;
+            }
+        }
+
+        if (ownerIndex != SIZE_MAX)
+        {
+            const auto &owner = codeOwners[ownerIndex];
+            WriteItem(os, rangeStart);
+            WriteItem(os, rangeEnd);
+            WriteItem(os, static_cast<uint32_t>(owner.first));
+            WriteItem(os, static_cast<uint32_t>(owner.second));
+        }
+        if (iter == instructions.end())
+            break;
+
+        ownerIndex = nextOwnerIndex;
+        rangeStart = iter->instruction->Offset();
+        rangeEnd = rangeStart + iter->instruction->Size();
+    }
+
+    // Terminate the code address ranges list.
+    WriteItem(os, UINT32_MAX);
+    WriteItem(os, UINT32_MAX);
+    WriteItem(os, 0);
+    WriteItem(os, 0);
 }
 
 static void WriteItem(ostream &os, const string &s)
@@ -11,7 +11,10 @@
 #include <map>
 #include <stack>
 #include <list>
+#include <set>
 #include <string>
+#include <vector>
+#include <cstddef>
 #include <cstdint>
 #include <utility>
 
@@ -37,6 +40,14 @@ class Executable
         // Check value method.
         void SetCheckValue(std::uint32_t);
 
+        // Optimization method.
+        void SetOptimize(bool);
+
+        // Page layout methods.
+        void SetPageSize(std::size_t);
+        void SetPageCount(std::size_t);
+        void SetPageTrace(const std::vector<std::uint32_t> &);
+
         // Symbol methods.
         std::int32_t Symbol(const std::string &name) const;
         std::int32_t TemporarySymbol() const;
@@ -54,6 +65,11 @@ class Executable
         void MarkModuleLocation(const std::string &name, const Location &);
         unsigned ModuleOffset(const std::string &name) const;
 
+        // Function location method.
+        void MarkFunctionLocation
+            (const std::string &name,
+             const Location &entry, const Location &end);
+
         // Finalize method.
         void Finalize();
 
@@ -61,6 +77,7 @@ class Executable
         void Write(std::ostream &) const;
         void WriteListing(std::ostream &) const;
         void WriteSourceInfo(std::ostream &) const;
+        void WriteLayoutReport(std::ostream &) const;
 
     protected:
 
@@ -68,15 +85,73 @@ class Executable
         Executable(const Executable &) = delete;
         Executable &operator =(const Executable &) = delete;
 
+        // Optimization methods.
+        using InstructionSet = std::set<const InstructionInfo *>;
+        void Optimize();
+        InstructionSet TargetInstructions() const;
+        Location Resolve(Location);
+        Location NextInstruction
+            (Location, const InstructionSet *targets = nullptr);
+        void Replace(const Location &, Instruction *);
+        bool ShortenJumpChains();
+        bool RemoveRedundantJumps();
+        bool RemoveUnreachableCode(const InstructionSet &targets);
+        bool CombineInstructions(const InstructionSet &targets);
+
+        // Offset assignment method.
+        unsigned AssignOffsets();
+
+        // Code owner assignment method.
+        void AssignCodeOwners();
+
+        // Page layout methods.
+        struct LayoutUnit;
+        using UnitOrder = std::vector<std::size_t>;
+        struct UnitAddress;
+        void Layout();
+        void ResolvePageTrace();
+        UnitOrder PackUnits
+            (const std::vector<LayoutUnit> &, const UnitOrder &) const;
+        UnitOrder ChainUnits
+            (const std::vector<LayoutUnit> &, const UnitOrder &,
+             const std::vector<UnitAddress> &) const;
+        std::vector<unsigned> UnitOffsets
+            (const std::vector<LayoutUnit> &, const UnitOrder &) const;
+        unsigned SpanningFunctionCount
+            (const std::vector<LayoutUnit> &, const UnitOrder &) const;
+        std::size_t PageReadCount
+            (const std::vector<LayoutUnit> &, const UnitOrder &,
+             const std::vector<UnitAddress> &) const;
+        unsigned SpanningFunctionCount() const;
+        std::size_t PageReadCount(bool laidOut) const;
+
+        // Traced code address, relative to the instruction containing it.
+        struct TracedAddress
+        {
+            const InstructionInfo *instructionInfo;
+            std::uint32_t originalAddress, delta, originalSize;
+            std::size_t unitIndex;
+        };
+
     private:
 
         // Data.
         std::uint32_t checkValue = 0;
+        bool optimize = true;
         SymbolTable &symbolTable;
         std::list<InstructionInfo> instructions;
         Location currentLocation = instructions.end();
         std::stack<Location> locationStack;
         std::map<unsigned, std::pair<Location, unsigned> > moduleLocations;
+        std::vector<std::pair<Location, Location> > functionLocations;
+        std::vector<std::int32_t> functionSymbols;
+        std::vector<std::pair<std::int32_t, unsigned> > codeOwners;
+        std::map<const InstructionInfo *, std::size_t> codeOwnerIndices;
+        std::size_t pageSize = 0, pageCount = 1;
+        std::vector<std::uint32_t> pageTrace;
+        std::vector<TracedAddress> tracedAddresses;
+        std::map<const InstructionInfo *, std::size_t> functionIndices;
+        unsigned originalSpanningFunctionCount = 0;
 };
 
 #endif
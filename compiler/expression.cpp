@@ -155,7 +155,9 @@ void TargetExpression::Add(TargetExpression *targetExpression)
 
 void TargetExpression::Parent(const Statement *statement)
 {
-    parentStatement = statement;
+    Expression::Parent(statement);
+    for (auto &targetExpression: targetExpressions)
+        targetExpression->Parent(statement);
 }
 
 Argument::Argument
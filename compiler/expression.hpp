@@ -99,8 +99,21 @@ class BinaryExpression : public Expression
 
         void Emit(Executable &, EmitType) const override;
 
+        // Support for fusing the operation with a conditional jump.
+        void EmitOperands(Executable &) const;
+        void EmitJumpIfFalse
+            (Executable &, const Executable::Location &,
+             const std::string &comment) const;
+
+        // Support for assigning the result to the left operand variable.
+        bool UpdatesVariable(const std::string &name) const;
+        void EmitUpdate(Executable &, const Expression &target) const;
+
     private:
 
+        std::uint8_t OpCode() const;
+        bool ImmediateOperand(std::int32_t &) const;
+
         int operatorTokenType;
         Expression *leftExpression, *rightExpression;
 };
@@ -139,7 +152,6 @@ class TargetExpression : public Expression
 
     private:
 
-        const Statement *parentStatement = nullptr;
         std::string name;
         std::list<TargetExpression *> targetExpressions;
 };
@@ -439,6 +451,11 @@ class ConstantExpression : public Expression
             return type;
         }
 
+        std::int32_t GetInteger() const
+        {
+            return type == Type::Integer ? i : 0;
+        }
+
         friend Expression *FoldUnaryExpression
             (int operatorTokenType, Expression *);
         friend Expression *FoldBinaryExpression
@@ -10,6 +10,8 @@
 
 using namespace std;
 
+static const char *Mnemonic(uint8_t opCode);
+
 static inline char Byte(uint64_t value, unsigned index)
 {
     return (value >> (index << 3)) & 0xFF;
@@ -43,6 +45,11 @@ uint32_t Instruction::Offset() const
     return offset;
 }
 
+void Instruction::TargetLocation(const Executable::Location &targetLocation)
+{
+    this->targetLocation = targetLocation;
+}
+
 Executable::Location Instruction::TargetLocation() const
 {
     return targetLocation;
@@ -179,82 +186,7 @@ SimpleInstruction::SimpleInstruction
 
 void SimpleInstruction::PrintCode(ostream &os) const
 {
-    static map<uint8_t, string> mnemonics =
-    {
-        {OpCode_PUSHN, "PUSHN"},
-        {OpCode_PUSHE, "PUSHE"},
-        {OpCode_PUSHF, "PUSHF"},
-        {OpCode_PUSHT, "PUSHT"},
-        {OpCode_PUSHTU, "PUSHTU"},
-        {OpCode_PUSHLI, "PUSHLI"},
-        {OpCode_PUSHSE, "PUSHSE"},
-        {OpCode_PUSHDI, "PUSHDI"},
-        {OpCode_PUSHAL, "PUSHAL"},
-        {OpCode_PUSHPL, "PUSHPL"},
-        {OpCode_PUSHCA, "PUSHCA"},
-        {OpCode_POP, "POP"},
-        {OpCode_LNOT, "LNOT"},
-        {OpCode_POS, "POS"},
-        {OpCode_NEG, "NEG"},
-        {OpCode_NOT, "NOT"},
-        {OpCode_OR, "OR"},
-        {OpCode_XOR, "XOR"},
-        {OpCode_AND, "AND"},
-        {OpCode_LSH, "LSH"},
-        {OpCode_RSH, "RSH"},
-        {OpCode_ADD, "ADD"},
-        {OpCode_SUB, "SUB"},
-        {OpCode_MUL, "MUL"},
-        {OpCode_DIV, "DIV"},
-        {OpCode_FDIV, "FDIV"},
-        {OpCode_MOD, "MOD"},
-        {OpCode_POW, "POW"},
-        {OpCode_NE, "NE"},
-        {OpCode_EQ, "EQ"},
-        {OpCode_LT, "LT"},
-        {OpCode_LE, "LE"},
-        {OpCode_GT, "GT"},
-        {OpCode_GE, "GE"},
-        {OpCode_NIN, "NIN"},
-        {OpCode_IN, "IN"},
-        {OpCode_NIS, "NIS"},
-        {OpCode_IS, "IS"},
-        {OpCode_SET, "SET"},
-        {OpCode_SETP, "SETP"},
-        {OpCode_ERASE, "ERASE"},
-        {OpCode_SITER, "SITER"},
-        {OpCode_TITER, "TITER"},
-        {OpCode_NITER, "NITER"},
-        {OpCode_DITER, "DITER"},
-        {OpCode_NOOP, "NOOP"},
-        {OpCode_JMPF, "JMPF"},
-        {OpCode_JMPT, "JMPT"},
-        {OpCode_JMP, "JMP"},
-        {OpCode_LOR, "LOR"},
-        {OpCode_LAND, "LAND"},
-        {OpCode_CALL, "CALL"},
-        {OpCode_RET, "RET"},
-        {OpCode_XMOD, "XMOD"},
-        {OpCode_MKFUN, "MKFUN"},
-        {OpCode_MKKVP, "MKKVP"},
-        {OpCode_MKR0, "MKR0"},
-        {OpCode_MKRS, "MKRS"},
-        {OpCode_MKRE, "MKRE"},
-        {OpCode_MKRSE, "MKRSE"},
-        {OpCode_MKRT, "MKRT"},
-        {OpCode_MKRST, "MKRST"},
-        {OpCode_MKRET, "MKRET"},
-        {OpCode_MKR, "MKR"},
-        {OpCode_INS, "INS"},
-        {OpCode_INSP, "INSP"},
-        {OpCode_BLD, "BLD"},
-        {OpCode_IDX, "IDX"},
-        {OpCode_IDXA, "IDXA"},
-        {OpCode_ABORT, "ABORT"},
-        {OpCode_END, "END"},
-    };
-    auto iter = mnemonics.find(OpCode());
-    os << (iter != mnemonics.end() ? iter->second : "???");
+    os << Mnemonic(OpCode());
 }
 
 PushNoneInstruction::PushNoneInstruction(const string &comment) :
@@ -486,6 +418,81 @@ BinaryInstruction::BinaryInstruction
 {
 }
 
+BinaryImmediateInstruction::BinaryImmediateInstruction
+    (uint8_t operation, int32_t value, const string &comment) :
+    Instruction
+        (OperandSize(value) <= 1 ? OpCode_BINI1 :
+         OperandSize(value) == 2 ? OpCode_BINI2 : OpCode_BINI4,
+         comment),
+    operation(operation),
+    value(value)
+{
+}
+
+unsigned BinaryImmediateInstruction::OperandsSize() const
+{
+    return 1U + max(1U, OperandSize(value));
+}
+
+void BinaryImmediateInstruction::WriteOperands(ostream &os) const
+{
+    WriteField(os, operation, 1);
+    uint32_t uValue = *reinterpret_cast<const uint32_t *>(&value);
+    WriteField(os, uValue, OperandsSize() - 1U);
+}
+
+void BinaryImmediateInstruction::PrintCode(ostream &os) const
+{
+    os << "BINI " << Mnemonic(operation) << ' ' << value;
+}
+
+BinaryJumpInstruction::BinaryJumpInstruction
+    (uint8_t operation, const Executable::Location &targetLocation,
+     const string &comment) :
+    Instruction(OpCode_BJMPF, targetLocation, comment),
+    operation(operation),
+    value(0)
+{
+}
+
+BinaryJumpInstruction::BinaryJumpInstruction
+    (uint8_t operation, int32_t value,
+     const Executable::Location &targetLocation,
+     const string &comment) :
+    Instruction
+        (OperandSize(value) <= 1 ? OpCode_BIJMPF1 :
+         OperandSize(value) == 2 ? OpCode_BIJMPF2 : OpCode_BIJMPF4,
+         targetLocation, comment),
+    operation(operation),
+    value(value)
+{
+}
+
+unsigned BinaryJumpInstruction::OperandsSize() const
+{
+    return
+        OpCode() == OpCode_BJMPF ? 1U :
+        1U + max(1U, OperandSize(value));
+}
+
+void BinaryJumpInstruction::WriteOperands(ostream &os) const
+{
+    WriteField(os, operation, 1);
+    if (OpCode() != OpCode_BJMPF)
+    {
+        uint32_t uValue = *reinterpret_cast<const uint32_t *>(&value);
+        WriteField(os, uValue, OperandsSize() - 1U);
+    }
+}
+
+void BinaryJumpInstruction::PrintCode(ostream &os) const
+{
+    if (OpCode() == OpCode_BJMPF)
+        os << "BJMPF " << Mnemonic(operation);
+    else
+        os << "BIJMPF " << Mnemonic(operation) << ' ' << value;
+}
+
 LogicalInstruction::LogicalInstruction
     (uint8_t opCode, const Executable::Location &location,
      const string &comment) :
@@ -513,6 +520,11 @@ LoadInstruction::LoadInstruction
 {
 }
 
+int32_t LoadInstruction::Symbol() const
+{
+    return symbol;
+}
+
 unsigned LoadInstruction::OperandsSize() const
 {
     return
@@ -538,11 +550,95 @@ void LoadInstruction::PrintCode(ostream &os) const
         os << ' ' << symbol;
 }
 
+ReserveSlotsInstruction::ReserveSlotsInstruction
+    (uint8_t count, const string &comment) :
+    Instruction(OpCode_SLOTS, comment),
+    count(count)
+{
+}
+
+unsigned ReserveSlotsInstruction::OperandsSize() const
+{
+    return 1U;
+}
+
+void ReserveSlotsInstruction::WriteOperands(ostream &os) const
+{
+    WriteField(os, count, 1);
+}
+
+void ReserveSlotsInstruction::PrintCode(ostream &os) const
+{
+    os << "SLOTS " << (unsigned)count;
+}
+
+LoadLocalInstruction::LoadLocalInstruction
+    (uint8_t slot, int32_t symbol, bool address, const string &comment) :
+    Instruction
+        (address ?
+            (OperandSize(symbol) <= 1 ? OpCode_LDLA1 :
+             OperandSize(symbol) == 2 ? OpCode_LDLA2 : OpCode_LDLA4) :
+            (OperandSize(symbol) <= 1 ? OpCode_LDL1 :
+             OperandSize(symbol) == 2 ? OpCode_LDL2 : OpCode_LDL4),
+         comment),
+    slot(slot),
+    symbol(symbol)
+{
+}
+
+int32_t LoadLocalInstruction::Symbol() const
+{
+    return symbol;
+}
+
+unsigned LoadLocalInstruction::OperandsSize() const
+{
+    return 1U + max(1U, OperandSize(symbol));
+}
+
+void LoadLocalInstruction::WriteOperands(ostream &os) const
+{
+    WriteField(os, slot, 1);
+    uint32_t uSymbol = *reinterpret_cast<const uint32_t *>(&symbol);
+    WriteField(os, uSymbol, OperandsSize() - 1U);
+}
+
+void LoadLocalInstruction::PrintCode(ostream &os) const
+{
+    bool address =
+        OpCode() == OpCode_LDLA1 ||
+        OpCode() == OpCode_LDLA2 ||
+        OpCode() == OpCode_LDLA4;
+    os << (address ? "LDLA" : "LDL") << ' ' << (unsigned)slot << ' ' << symbol;
+}
+
 SetInstruction::SetInstruction(bool pop, const string &comment) :
     SimpleInstruction(pop ? OpCode_SETP : OpCode_SET, comment)
 {
 }
 
+SetOperationInstruction::SetOperationInstruction
+    (uint8_t operation, const string &comment) :
+    Instruction(OpCode_SETOP, comment),
+    operation(operation)
+{
+}
+
+unsigned SetOperationInstruction::OperandsSize() const
+{
+    return 1U;
+}
+
+void SetOperationInstruction::WriteOperands(ostream &os) const
+{
+    WriteField(os, operation, 1);
+}
+
+void SetOperationInstruction::PrintCode(ostream &os) const
+{
+    os << "SETOP " << Mnemonic(operation);
+}
+
 DeleteInstruction::DeleteInstruction
     (int32_t symbol, const string &comment) :
     Instruction
@@ -911,3 +1007,85 @@ EndInstruction::EndInstruction(const string &comment) :
     SimpleInstruction(OpCode_END, comment)
 {
 }
+
+static const char *Mnemonic(uint8_t opCode)
+{
+    static const map<uint8_t, const char *> mnemonics =
+    {
+        {OpCode_PUSHN, "PUSHN"},
+        {OpCode_PUSHE, "PUSHE"},
+        {OpCode_PUSHF, "PUSHF"},
+        {OpCode_PUSHT, "PUSHT"},
+        {OpCode_PUSHTU, "PUSHTU"},
+        {OpCode_PUSHLI, "PUSHLI"},
+        {OpCode_PUSHSE, "PUSHSE"},
+        {OpCode_PUSHDI, "PUSHDI"},
+        {OpCode_PUSHAL, "PUSHAL"},
+        {OpCode_PUSHPL, "PUSHPL"},
+        {OpCode_PUSHCA, "PUSHCA"},
+        {OpCode_POP, "POP"},
+        {OpCode_LNOT, "LNOT"},
+        {OpCode_POS, "POS"},
+        {OpCode_NEG, "NEG"},
+        {OpCode_NOT, "NOT"},
+        {OpCode_OR, "OR"},
+        {OpCode_XOR, "XOR"},
+        {OpCode_AND, "AND"},
+        {OpCode_LSH, "LSH"},
+        {OpCode_RSH, "RSH"},
+        {OpCode_ADD, "ADD"},
+        {OpCode_SUB, "SUB"},
+        {OpCode_MUL, "MUL"},
+        {OpCode_DIV, "DIV"},
+        {OpCode_FDIV, "FDIV"},
+        {OpCode_MOD, "MOD"},
+        {OpCode_POW, "POW"},
+        {OpCode_NE, "NE"},
+        {OpCode_EQ, "EQ"},
+        {OpCode_LT, "LT"},
+        {OpCode_LE, "LE"},
+        {OpCode_GT, "GT"},
+        {OpCode_GE, "GE"},
+        {OpCode_NIN, "NIN"},
+        {OpCode_IN, "IN"},
+        {OpCode_NIS, "NIS"},
+        {OpCode_IS, "IS"},
+        {OpCode_ORDER, "ORDER"},
+        {OpCode_SET, "SET"},
+        {OpCode_SETP, "SETP"},
+        {OpCode_SETOP, "SETOP"},
+        {OpCode_ERASE, "ERASE"},
+        {OpCode_SITER, "SITER"},
+        {OpCode_TITER, "TITER"},
+        {OpCode_NITER, "NITER"},
+        {OpCode_DITER, "DITER"},
+        {OpCode_NOOP, "NOOP"},
+        {OpCode_JMPF, "JMPF"},
+        {OpCode_JMPT, "JMPT"},
+        {OpCode_JMP, "JMP"},
+        {OpCode_LOR, "LOR"},
+        {OpCode_LAND, "LAND"},
+        {OpCode_CALL, "CALL"},
+        {OpCode_RET, "RET"},
+        {OpCode_XMOD, "XMOD"},
+        {OpCode_MKFUN, "MKFUN"},
+        {OpCode_MKKVP, "MKKVP"},
+        {OpCode_MKR0, "MKR0"},
+        {OpCode_MKRS, "MKRS"},
+        {OpCode_MKRE, "MKRE"},
+        {OpCode_MKRSE, "MKRSE"},
+        {OpCode_MKRT, "MKRT"},
+        {OpCode_MKRST, "MKRST"},
+        {OpCode_MKRET, "MKRET"},
+        {OpCode_MKR, "MKR"},
+        {OpCode_INS, "INS"},
+        {OpCode_INSP, "INSP"},
+        {OpCode_BLD, "BLD"},
+        {OpCode_IDX, "IDX"},
+        {OpCode_IDXA, "IDXA"},
+        {OpCode_ABORT, "ABORT"},
+        {OpCode_END, "END"},
+    };
+    auto iter = mnemonics.find(opCode);
+    return iter != mnemonics.end() ? iter->second : "???";
+}
@@ -29,11 +29,13 @@ class Instruction
         // Address methods.
         void Offset(std::uint32_t);
         std::uint32_t Offset() const;
+        void TargetLocation(const Executable::Location &);
         Executable::Location TargetLocation() const;
         bool Fixed() const;
         void Fix(std::uint32_t targetOffset);
 
         // Code generation methods.
+        std::uint8_t OpCode() const;
         virtual unsigned Size() const;
         virtual void Write(std::ostream &) const;
 
@@ -50,7 +52,6 @@ class Instruction
         static unsigned OperandSize(std::int32_t value);
         static void WriteField
             (std::ostream &, std::uint64_t value, unsigned size);
-        std::uint8_t OpCode() const;
 
     private:
 
@@ -296,6 +297,50 @@ class BinaryInstruction : public SimpleInstruction
             (std::uint8_t opCode, const std::string &comment = "");
 };
 
+class BinaryImmediateInstruction : public Instruction
+{
+    public:
+
+        BinaryImmediateInstruction
+            (std::uint8_t operation, std::int32_t value,
+             const std::string &comment = "");
+
+    protected:
+
+        unsigned OperandsSize() const override;
+        void WriteOperands(std::ostream &) const override;
+        void PrintCode(std::ostream &) const override;
+
+    private:
+
+        std::uint8_t operation;
+        std::int32_t value;
+};
+
+class BinaryJumpInstruction : public Instruction
+{
+    public:
+
+        BinaryJumpInstruction
+            (std::uint8_t operation, const Executable::Location &,
+             const std::string &comment = "");
+        BinaryJumpInstruction
+            (std::uint8_t operation, std::int32_t value,
+             const Executable::Location &,
+             const std::string &comment = "");
+
+    protected:
+
+        unsigned OperandsSize() const override;
+        void WriteOperands(std::ostream &) const override;
+        void PrintCode(std::ostream &) const override;
+
+    private:
+
+        std::uint8_t operation;
+        std::int32_t value;
+};
+
 class LogicalInstruction : public SimpleInstruction
 {
     public:
@@ -315,6 +360,8 @@ class LoadInstruction : public Instruction
             (std::int32_t symbol, bool address,
              const std::string &comment = "");
 
+        std::int32_t Symbol() const;
+
     protected:
 
         unsigned OperandsSize() const override;
@@ -326,6 +373,46 @@ class LoadInstruction : public Instruction
         std::int32_t symbol;
 };
 
+class ReserveSlotsInstruction : public Instruction
+{
+    public:
+
+        explicit ReserveSlotsInstruction
+            (std::uint8_t count, const std::string &comment = "");
+
+    protected:
+
+        unsigned OperandsSize() const override;
+        void WriteOperands(std::ostream &) const override;
+        void PrintCode(std::ostream &) const override;
+
+    private:
+
+        std::uint8_t count;
+};
+
+class LoadLocalInstruction : public Instruction
+{
+    public:
+
+        LoadLocalInstruction
+            (std::uint8_t slot, std::int32_t symbol, bool address,
+             const std::string &comment = "");
+
+        std::int32_t Symbol() const;
+
+    protected:
+
+        unsigned OperandsSize() const override;
+        void WriteOperands(std::ostream &) const override;
+        void PrintCode(std::ostream &) const override;
+
+    private:
+
+        std::uint8_t slot;
+        std::int32_t symbol;
+};
+
 class SetInstruction : public SimpleInstruction
 {
     public:
@@ -334,6 +421,24 @@ class SetInstruction : public SimpleInstruction
             (bool pop, const std::string &comment = "");
 };
 
+class SetOperationInstruction : public Instruction
+{
+    public:
+
+        explicit SetOperationInstruction
+            (std::uint8_t operation, const std::string &comment = "");
+
+    protected:
+
+        unsigned OperandsSize() const override;
+        void WriteOperands(std::ostream &) const override;
+        void PrintCode(std::ostream &) const override;
+
+    private:
+
+        std::uint8_t operation;
+};
+
 class DeleteInstruction : public Instruction
 {
     public:
@@ -0,0 +1,524 @@
+//
+// Asp executable page layout implementation.
+//
+
+#include "executable.hpp"
+#include "instruction.hpp"
+#include "opcode.h"
+#include <algorithm>
+#include <list>
+#include <cstdint>
+
+using namespace std;
+
+static void AddPageVisits
+    (vector<size_t> &pages, size_t address, size_t size, size_t pageSize,
+     bool sequential);
+static size_t PageReadCount(const vector<size_t> &pages, size_t pageCount);
+
+// Size of the executable header, which precedes the code in the first code
+// page.
+static const size_t HeaderSize = 12;
+
+// A run of code that control never falls into or out of, and which may
+// therefore be placed anywhere: the top-level code, which invokes the main
+// module and remains first, or a part of the body of a module or function
+// between the bodies of any functions defined within it. Each part that
+// precedes a function body ends by jumping around it.
+struct Executable::LayoutUnit
+{
+    list<InstructionInfo> instructions;
+    unsigned offset = 0, size = 0;
+    size_t functionIndex = SIZE_MAX;
+
+    // Unit whose first instruction is the target of the jump that ends
+    // this unit, if any. The jump is removed when that unit follows.
+    size_t jumpUnitIndex = SIZE_MAX;
+    unsigned jumpSize = 0;
+};
+
+// Traced instruction, located within its unit.
+struct Executable::UnitAddress
+{
+    size_t unitIndex;
+    unsigned offset, size;
+};
+
+void Executable::Layout()
+{
+    // Identify where units begin: at the entry to each module, and at the
+    // start and end of each function body.
+    map<const InstructionInfo *, size_t> functionEntries, functionEnds;
+    for (size_t i = 0; i < functionLocations.size(); i++)
+    {
+        functionEntries[&*functionLocations[i].first] = i;
+        functionEnds[&*functionLocations[i].second] = i;
+    }
+    InstructionSet moduleEntries;
+    for (const auto &moduleLocation: moduleLocations)
+        moduleEntries.insert(&*moduleLocation.second.first);
+
+    // Assign each instruction to a unit, noting the function, if any, to
+    // which each unit belongs.
+    vector<LayoutUnit> units(1);
+    map<const InstructionInfo *, size_t> unitIndices;
+    vector<const InstructionInfo *> firstInstructions(1, nullptr);
+    vector<Location> lastInstructions(1, instructions.end());
+    vector<size_t> functionStack;
+    functionIndices.clear();
+    for (auto iter = instructions.begin(); iter != instructions.end(); iter++)
+    {
+        const auto &instruction = iter->instruction;
+        bool split = false;
+        if (functionEnds.count(&*iter) != 0)
+        {
+            functionStack.pop_back();
+            split = true;
+        }
+        auto entryIter = functionEntries.find(&*iter);
+        if (entryIter != functionEntries.end())
+        {
+            functionStack.push_back(entryIter->second);
+            split = true;
+        }
+        if (split || moduleEntries.count(&*iter) != 0)
+        {
+            units.emplace_back();
+            units.back().offset = instruction->Offset();
+            if (!functionStack.empty())
+                units.back().functionIndex = functionStack.back();
+            firstInstructions.push_back(nullptr);
+            lastInstructions.push_back(instructions.end());
+        }
+
+        auto unitIndex = units.size() - 1;
+        auto &unit = units.back();
+        unitIndices[&*iter] = unitIndex;
+        if (unit.functionIndex != SIZE_MAX)
+            functionIndices[&*iter] = unit.functionIndex;
+        unit.size += instruction->Size();
+        if (instruction->Size() != 0)
+        {
+            if (firstInstructions[unitIndex] == nullptr)
+                firstInstructions[unitIndex] = &*iter;
+            lastInstructions[unitIndex] = iter;
+        }
+    }
+
+    // Note the units that end by jumping to the start of another unit.
+    for (size_t i = 0; i < units.size(); i++)
+    {
+        auto lastIter = lastInstructions[i];
+        if (lastIter == instructions.end() ||
+            lastIter->instruction->OpCode() != OpCode_JMP)
+            continue;
+        auto targetIter = Resolve(lastIter->instruction->TargetLocation());
+        if (targetIter == instructions.end())
+            continue;
+        auto targetUnitIndex = unitIndices[&*targetIter];
+        if (firstInstructions[targetUnitIndex] == &*targetIter)
+        {
+            units[i].jumpUnitIndex = targetUnitIndex;
+            units[i].jumpSize = lastIter->instruction->Size();
+        }
+    }
+
+    // Locate each traced address within its unit.
+    vector<UnitAddress> unitAddresses;
+    for (auto &tracedAddress: tracedAddresses)
+    {
+        auto unitIndex = unitIndices[tracedAddress.instructionInfo];
+        tracedAddress.unitIndex = unitIndex;
+        unitAddresses.push_back
+            (UnitAddress
+                {unitIndex,
+                 tracedAddress.instructionInfo->instruction->Offset() +
+                 tracedAddress.delta - units[unitIndex].offset,
+                 tracedAddress.originalSize});
+    }
+
+    // Consider the original order of the units, and orders that reduce
+    // the number of functions spanning page boundaries and, given a trace,
+    // that place units between which control passes often together. Keep
+    // the one that does best, preferring the original order.
+    UnitOrder originalOrder;
+    for (size_t i = 1; i < units.size(); i++)
+        originalOrder.push_back(i);
+    vector<UnitOrder> orders;
+    orders.push_back(originalOrder);
+    orders.push_back(PackUnits(units, originalOrder));
+    if (!unitAddresses.empty())
+    {
+        auto chainedOrder = ChainUnits(units, originalOrder, unitAddresses);
+        orders.push_back(chainedOrder);
+        orders.push_back(PackUnits(units, chainedOrder));
+    }
+    originalSpanningFunctionCount =
+        SpanningFunctionCount(units, originalOrder);
+    const UnitOrder *bestOrder = nullptr;
+    size_t bestReadCount = 0;
+    unsigned bestSpanningFunctionCount = 0;
+    for (const auto &order: orders)
+    {
+        auto readCount = PageReadCount(units, order, unitAddresses);
+        auto spanningFunctionCount = SpanningFunctionCount(units, order);
+        if (bestOrder == nullptr ||
+            readCount < bestReadCount ||
+            (readCount == bestReadCount &&
+             spanningFunctionCount < bestSpanningFunctionCount))
+        {
+            bestOrder = &order;
+            bestReadCount = readCount;
+            bestSpanningFunctionCount = spanningFunctionCount;
+        }
+    }
+
+    // Rearrange the code into the chosen order.
+    while (!instructions.empty())
+    {
+        auto iter = instructions.begin();
+        auto &unitInstructions = units[unitIndices[&*iter]].instructions;
+        unitInstructions.splice(unitInstructions.end(), instructions, iter);
+    }
+    instructions.splice(instructions.end(), units[0].instructions);
+    for (auto index: *bestOrder)
+        instructions.splice(instructions.end(), units[index].instructions);
+}
+
+void Executable::ResolvePageTrace()
+{
+    // Associate each traced code address with the instruction containing
+    // it, using the offsets of the code as originally generated.
+    tracedAddresses.clear();
+    if (pageTrace.empty())
+        return;
+    vector<pair<uint32_t, const InstructionInfo *> > offsets;
+    for (const auto &instructionInfo: instructions)
+    {
+        const auto &instruction = instructionInfo.instruction;
+        if (instruction->Size() != 0)
+            offsets.emplace_back(instruction->Offset(), &instructionInfo);
+    }
+    for (auto address: pageTrace)
+    {
+        auto iter = upper_bound
+            (offsets.begin(), offsets.end(), address,
+             [](uint32_t address,
+                const pair<uint32_t, const InstructionInfo *> &offset)
+             {
+                 return address < offset.first;
+             });
+        if (iter == offsets.begin())
+            continue;
+        iter--;
+        auto delta = address - iter->first;
+        if (delta >= iter->second->instruction->Size())
+            continue;
+        tracedAddresses.push_back
+            (TracedAddress
+                {iter->second, address, delta,
+                 iter->second->instruction->Size(), 0});
+    }
+}
+
+Executable::UnitOrder Executable::PackUnits
+    (const vector<LayoutUnit> &units, const UnitOrder &order) const
+{
+    // Place the units in the given order, except that when a unit that
+    // fits within a page would cross a page boundary, first place any
+    // later units that fit in the space before the boundary.
+    list<size_t> pending(order.begin(), order.end());
+    UnitOrder packedOrder;
+    size_t offset = units[0].size;
+    while (!pending.empty())
+    {
+        auto iter = pending.begin();
+        size_t size = units[*iter].size;
+        size_t room = pageSize - (HeaderSize + offset) % pageSize;
+        if (size > room && size <= pageSize)
+        {
+            iter = find_if
+                (pending.begin(), pending.end(),
+                 [&units, room](size_t index)
+                 {
+                     return units[index].size <= room;
+                 });
+            if (iter == pending.end())
+                iter = pending.begin();
+        }
+
+        packedOrder.push_back(*iter);
+        offset += units[*iter].size;
+        pending.erase(iter);
+    }
+
+    return packedOrder;
+}
+
+Executable::UnitOrder Executable::ChainUnits
+    (const vector<LayoutUnit> &units, const UnitOrder &order,
+     const vector<UnitAddress> &unitAddresses) const
+{
+    // Determine how often each unit was visited and how often control
+    // passed between each pair of units while the trace was taken.
+    vector<unsigned long> heats(units.size(), 0);
+    map<pair<size_t, size_t>, unsigned long> transitions;
+    size_t previousIndex = 0;
+    for (const auto &unitAddress: unitAddresses)
+    {
+        auto index = unitAddress.unitIndex;
+        heats[index]++;
+        if (index != previousIndex)
+            transitions
+                [make_pair
+                    (min(index, previousIndex),
+                     max(index, previousIndex))]++;
+        previousIndex = index;
+    }
+
+    // Join units into chains, considering the pairs of units between which
+    // control passed most often first, as in Pettis and Hansen's procedure
+    // positioning. The top-level code is excluded, as it remains first.
+    vector<pair<unsigned long, pair<size_t, size_t> > > edges;
+    for (const auto &transition: transitions)
+        edges.emplace_back(transition.second, transition.first);
+    stable_sort
+        (edges.begin(), edges.end(),
+         [](const pair<unsigned long, pair<size_t, size_t> > &edge1,
+            const pair<unsigned long, pair<size_t, size_t> > &edge2)
+         {
+             return edge1.first > edge2.first;
+         });
+    vector<size_t> chainIndices(units.size(), SIZE_MAX);
+    vector<UnitOrder> chains;
+    for (auto index: order)
+    {
+        chainIndices[index] = chains.size();
+        chains.push_back(UnitOrder(1, index));
+    }
+    for (const auto &edge: edges)
+    {
+        auto index1 = edge.second.first, index2 = edge.second.second;
+        auto chainIndex1 = chainIndices[index1];
+        auto chainIndex2 = chainIndices[index2];
+        if (chainIndex1 == SIZE_MAX || chainIndex2 == SIZE_MAX ||
+            chainIndex1 == chainIndex2)
+            continue;
+
+        // Join the chains end to end, choosing the order that places the
+        // two units next to each other if possible.
+        if (chains[chainIndex1].front() == index1 &&
+            chains[chainIndex2].back() == index2)
+            swap(chainIndex1, chainIndex2);
+        auto &chain = chains[chainIndex1];
+        auto &joinedChain = chains[chainIndex2];
+        for (auto index: joinedChain)
+            chainIndices[index] = chainIndex1;
+        chain.insert(chain.end(), joinedChain.begin(), joinedChain.end());
+        joinedChain.clear();
+    }
+
+    // Order the chains from the most to the least often visited, leaving
+    // those not visited at all in their original order.
+    vector<pair<unsigned long, size_t> > chainHeats;
+    for (size_t i = 0; i < chains.size(); i++)
+    {
+        if (chains[i].empty())
+            continue;
+        unsigned long heat = 0;
+        for (auto index: chains[i])
+            heat += heats[index];
+        chainHeats.emplace_back(heat, i);
+    }
+    stable_sort
+        (chainHeats.begin(), chainHeats.end(),
+         [](const pair<unsigned long, size_t> &chainHeat1,
+            const pair<unsigned long, size_t> &chainHeat2)
+         {
+             return chainHeat1.first > chainHeat2.first;
+         });
+    UnitOrder chainedOrder;
+    for (const auto &chainHeat: chainHeats)
+    {
+        const auto &chain = chains[chainHeat.second];
+        chainedOrder.insert(chainedOrder.end(), chain.begin(), chain.end());
+    }
+
+    return chainedOrder;
+}
+
+vector<unsigned> Executable::UnitOffsets
+    (const vector<LayoutUnit> &units, const UnitOrder &order) const
+{
+    // Determine where each unit would be placed, allowing for the removal
+    // of jumps to the unit that follows.
+    vector<unsigned> offsets(units.size(), 0);
+    unsigned offset = units[0].size;
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        const auto &unit = units[order[i]];
+        offsets[order[i]] = offset;
+        offset += unit.size;
+        if (optimize && i + 1 < order.size() &&
+            unit.jumpUnitIndex == order[i + 1])
+            offset -= unit.jumpSize;
+    }
+    return offsets;
+}
+
+unsigned Executable::SpanningFunctionCount
+    (const vector<LayoutUnit> &units, const UnitOrder &order) const
+{
+    // Count the functions whose code would not lie within a single page.
+    auto offsets = UnitOffsets(units, order);
+    vector<pair<size_t, size_t> > functionPages
+        (functionLocations.size(), make_pair(SIZE_MAX, 0));
+    for (auto index: order)
+    {
+        const auto &unit = units[index];
+        if (unit.functionIndex == SIZE_MAX || unit.size == 0)
+            continue;
+        auto &pages = functionPages[unit.functionIndex];
+        pages.first = min
+            (pages.first, (HeaderSize + offsets[index]) / pageSize);
+        pages.second = max
+            (pages.second,
+             (HeaderSize + offsets[index] + unit.size - 1) / pageSize);
+    }
+    unsigned count = 0;
+    for (const auto &pages: functionPages)
+        if (pages.first != SIZE_MAX && pages.first != pages.second)
+            count++;
+    return count;
+}
+
+size_t Executable::PageReadCount
+    (const vector<LayoutUnit> &units, const UnitOrder &order,
+     const vector<UnitAddress> &unitAddresses) const
+{
+    // Count the code page reads that the traced execution would incur.
+    auto offsets = UnitOffsets(units, order);
+    vector<size_t> pages;
+    for (size_t i = 0; i < unitAddresses.size(); i++)
+    {
+        const auto &address = unitAddresses[i];
+        const auto &previousAddress = unitAddresses[i == 0 ? 0 : i - 1];
+        AddPageVisits
+            (pages, HeaderSize + offsets[address.unitIndex] + address.offset,
+             address.size, pageSize,
+             i != 0 &&
+             address.unitIndex == previousAddress.unitIndex &&
+             address.offset >= previousAddress.offset);
+    }
+    return ::PageReadCount(pages, pageCount);
+}
+
+unsigned Executable::SpanningFunctionCount() const
+{
+    // Count the functions whose code does not lie within a single page.
+    vector<pair<size_t, size_t> > functionPages
+        (functionLocations.size(), make_pair(SIZE_MAX, 0));
+    for (const auto &instructionInfo: instructions)
+    {
+        const auto &instruction = instructionInfo.instruction;
+        auto iter = functionIndices.find(&instructionInfo);
+        if (iter == functionIndices.end() || instruction->Size() == 0)
+            continue;
+        auto &pages = functionPages[iter->second];
+        pages.first = min
+            (pages.first, (HeaderSize + instruction->Offset()) / pageSize);
+        pages.second = max
+            (pages.second,
+             (HeaderSize + instruction->Offset() + instruction->Size() - 1) /
+             pageSize);
+    }
+    unsigned count = 0;
+    for (const auto &pages: functionPages)
+        if (pages.first != SIZE_MAX && pages.first != pages.second)
+            count++;
+    return count;
+}
+
+size_t Executable::PageReadCount(bool laidOut) const
+{
+    // Count the code page reads that the traced execution incurs, using
+    // either the original or the final offsets of the instructions.
+    vector<size_t> pages;
+    size_t previousAddress = 0;
+    for (size_t i = 0; i < tracedAddresses.size(); i++)
+    {
+        const auto &tracedAddress = tracedAddresses[i];
+        const auto &instruction = tracedAddress.instructionInfo->instruction;
+        size_t address = laidOut ?
+            instruction->Offset() + tracedAddress.delta :
+            tracedAddress.originalAddress;
+        AddPageVisits
+            (pages, HeaderSize + address,
+             laidOut ? instruction->Size() : tracedAddress.originalSize,
+             pageSize,
+             i != 0 &&
+             tracedAddress.unitIndex == tracedAddresses[i - 1].unitIndex &&
+             address >= previousAddress);
+        previousAddress = address;
+    }
+    return ::PageReadCount(pages, pageCount);
+}
+
+void Executable::WriteLayoutReport(ostream &os) const
+{
+    if (pageSize == 0)
+        return;
+
+    os
+        << "Functions spanning code pages: " << SpanningFunctionCount()
+        << " of " << functionLocations.size()
+        << " (was " << originalSpanningFunctionCount << ')' << endl;
+    if (!tracedAddresses.empty())
+        os
+            << "Expected code page reads: " << PageReadCount(true)
+            << " (was " << PageReadCount(false) << ')' << endl;
+}
+
+static void AddPageVisits
+    (vector<size_t> &pages, size_t address, size_t size, size_t pageSize,
+     bool sequential)
+{
+    // Between traced instructions, control either proceeds sequentially,
+    // passing through each page in turn, or is transferred directly. The
+    // whole of each instruction is read.
+    size_t page = address / pageSize;
+    if (sequential && !pages.empty())
+    {
+        for (auto nextPage = pages.back() + 1; nextPage <= page; nextPage++)
+            pages.push_back(nextPage);
+    }
+    else if (pages.empty() || page != pages.back())
+        pages.push_back(page);
+    if (size > 1)
+    {
+        auto endPage = (address + size - 1) / pageSize;
+        for (auto nextPage = page + 1; nextPage <= endPage; nextPage++)
+            pages.push_back(nextPage);
+    }
+}
+
+static size_t PageReadCount(const vector<size_t> &pages, size_t pageCount)
+{
+    // Simulate the engine's default least recently used replacement.
+    list<size_t> cachedPages;
+    size_t count = 0;
+    for (auto page: pages)
+    {
+        auto iter = find(cachedPages.begin(), cachedPages.end(), page);
+        if (iter != cachedPages.end())
+            cachedPages.erase(iter);
+        else
+        {
+            count++;
+            if (cachedPages.size() == pageCount)
+                cachedPages.pop_back();
+        }
+        cachedPages.push_front(page);
+    }
+    return count;
+}
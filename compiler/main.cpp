@@ -16,6 +16,9 @@
 #include <memory>
 #include <cstdlib>
 #include <cerrno>
+#include <cctype>
+#include <cstdint>
+#include <vector>
 
 #if !defined ASP_COMPILER_VERSION_MAJOR || \
     !defined ASP_COMPILER_VERSION_MINOR || \
@@ -85,6 +88,34 @@ static void Usage()
     cerr
         << ":\n"
         << COMMAND_OPTION_PREFIXES[0]
+        << "n          Don't optimize. Emit instructions as generated, without"
+        << " the peephole\n"
+        << "            pass. Useful for comparing listings.\n"
+        << COMMAND_OPTION_PREFIXES[0]
+        << "p n        Arrange the code for running in paging mode with code"
+        << " pages of n\n"
+        << "            bytes. Function bodies and modules are ordered to"
+        << " reduce the\n"
+        << "            number of functions that cross a page boundary.\n"
+        << COMMAND_OPTION_PREFIXES[0]
+        << "c n        With " << COMMAND_OPTION_PREFIXES[0]
+        << "p, the code area size, in bytes, of the engine that\n"
+        << "            will run the script, which determines the number of"
+        << " code pages it\n"
+        << "            caches. The default is a single page.\n"
+        << COMMAND_OPTION_PREFIXES[0]
+        << "g FILE     With " << COMMAND_OPTION_PREFIXES[0]
+        << "p, order function bodies and modules to reduce the\n"
+        << "            number of code page reads incurred by the execution"
+        << " traced in\n"
+        << "            FILE, as written by the standalone application's "
+        << COMMAND_OPTION_PREFIXES[0] << "g option.\n"
+        << "            The trace must be taken from the script compiled"
+        << " without the\n"
+        << "            " << COMMAND_OPTION_PREFIXES[0]
+        << "p option. The expected number of page reads is"
+        << " reported.\n"
+        << COMMAND_OPTION_PREFIXES[0]
         << "o FILE     Write outputs to FILE.* instead of basing file names"
         << " on the SCRIPT\n"
         << "            file name. If FILE ends with .aspe, its base name is"
@@ -119,8 +150,9 @@ int main(int argc, char **argv)
 static int main1(int argc, char **argv)
 {
     // Process command line options.
-    bool silent = false, reportVersion = false;
-    string outputBaseName;
+    bool silent = false, reportVersion = false, optimize = true;
+    string outputBaseName, pageTraceFileName;
+    size_t pageSize = 0, codeByteCount = 0;
     for (; argc >= 2; argc--, argv++)
     {
         string arg1 = argv[1];
@@ -141,11 +173,30 @@ static int main1(int argc, char **argv)
             Usage();
             return 0;
         }
+        else if (option == "n")
+            optimize = false;
         else if (option == "o")
         {
             outputBaseName = (++argv)[1];
             argc--;
         }
+        else if (option == "p")
+        {
+            string value = (++argv)[1];
+            argc--;
+            pageSize = static_cast<size_t>(atoi(value.c_str()));
+        }
+        else if (option == "c")
+        {
+            string value = (++argv)[1];
+            argc--;
+            codeByteCount = static_cast<size_t>(atoi(value.c_str()));
+        }
+        else if (option == "g")
+        {
+            pageTraceFileName = (++argv)[1];
+            argc--;
+        }
         else if (option == "s")
             silent = true;
         else if (option == "v")
@@ -338,9 +389,50 @@ static int main1(int argc, char **argv)
         return 2;
     }
 
+    // Read the code address trace, which gives one address per line, if
+    // given.
+    vector<uint32_t> pageTrace;
+    if (!pageTraceFileName.empty())
+    {
+        if (pageSize == 0)
+        {
+            cerr << "Error: Code address trace requires a page size" << endl;
+            return 1;
+        }
+        ifstream pageTraceStream(pageTraceFileName);
+        if (!pageTraceStream)
+        {
+            cerr
+                << "Error opening " << pageTraceFileName
+                << ": " << strerror(errno) << endl;
+            return 2;
+        }
+        string line;
+        while (getline(pageTraceStream, line))
+        {
+            if (line.empty())
+                continue;
+            char *end;
+            auto address = strtoul(line.c_str(), &end, 0);
+            if (*end != '\0' && !isspace(*end))
+            {
+                cerr
+                    << "Error: Invalid code address in "
+                    << pageTraceFileName << ": " << line << endl;
+                return 2;
+            }
+            pageTrace.push_back(static_cast<uint32_t>(address));
+        }
+    }
+
     // Predefine symbols for main module and application functions.
     SymbolTable symbolTable;
     Executable executable(symbolTable);
+    executable.SetOptimize(optimize);
+    executable.SetPageSize(pageSize);
+    if (pageSize != 0 && codeByteCount >= pageSize)
+        executable.SetPageCount(codeByteCount / pageSize);
+    executable.SetPageTrace(pageTrace);
     Compiler compiler(cerr, symbolTable, executable);
     compiler.LoadApplicationSpec(specStream);
     compiler.AddModuleFileName(mainModuleBaseFileName);
@@ -529,6 +621,7 @@ static int main1(int argc, char **argv)
         cout
             << executableFileName << ": "
             << executableByteCount << " bytes" << endl;
+        executable.WriteLayoutReport(cout);
     }
 
     return 0;
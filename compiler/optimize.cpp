@@ -0,0 +1,267 @@
+//
+// Asp executable optimization implementation.
+//
+
+#include "executable.hpp"
+#include "instruction.hpp"
+#include "opcode.h"
+
+using namespace std;
+
+static bool IsJump(uint8_t opCode);
+static bool IsUnconditionalExit(uint8_t opCode);
+static bool IsConstantPush(uint8_t opCode);
+
+void Executable::Optimize()
+{
+    // Apply the optimizations repeatedly until none of them makes any
+    // further change, as each one may expose opportunities for the others.
+    bool changed;
+    do
+    {
+        changed = ShortenJumpChains();
+        changed = RemoveRedundantJumps() || changed;
+        auto targets = TargetInstructions();
+        changed = RemoveUnreachableCode(targets) || changed;
+        changed = CombineInstructions(targets) || changed;
+    } while (changed);
+}
+
+Executable::InstructionSet Executable::TargetInstructions() const
+{
+    // Collect all entries that control may reach other than by falling
+    // through from the previous instruction.
+    InstructionSet targets;
+    if (!instructions.empty())
+        targets.insert(&instructions.front());
+    for (const auto &instructionInfo: instructions)
+    {
+        const auto &instruction = instructionInfo.instruction;
+        if (!instruction->Fixed())
+            targets.insert(&*instruction->TargetLocation());
+    }
+    for (const auto &moduleLocation: moduleLocations)
+        targets.insert(&*moduleLocation.second.first);
+    return targets;
+}
+
+Executable::Location Executable::Resolve(Location location)
+{
+    // Skip null instructions to find the one actually executed.
+    while (location != instructions.end() &&
+           location->instruction->Size() == 0)
+        location++;
+    return location;
+}
+
+Executable::Location Executable::NextInstruction
+    (Location location, const InstructionSet *targets)
+{
+    // Find the instruction that follows, failing if any of the skipped
+    // entries is the target of a jump.
+    for (location++; location != instructions.end(); location++)
+    {
+        if (targets != nullptr && targets->count(&*location) != 0)
+            return instructions.end();
+        if (location->instruction->Size() != 0)
+            break;
+    }
+    return location;
+}
+
+void Executable::Replace(const Location &location, Instruction *instruction)
+{
+    delete location->instruction;
+    location->instruction = instruction;
+}
+
+bool Executable::ShortenJumpChains()
+{
+    // Redirect jumps that land on an unconditional jump to its target.
+    bool changed = false;
+    for (auto &instructionInfo: instructions)
+    {
+        auto instruction = instructionInfo.instruction;
+        if (!IsJump(instruction->OpCode()))
+            continue;
+
+        // Follow the chain, stopping short of any cycle.
+        InstructionSet visited;
+        auto targetLocation = Resolve(instruction->TargetLocation());
+        while (targetLocation != instructions.end() &&
+               targetLocation->instruction->OpCode() == OpCode_JMP &&
+               visited.insert(&*targetLocation).second)
+        {
+            auto newTargetLocation =
+                targetLocation->instruction->TargetLocation();
+            auto nextLocation = Resolve(newTargetLocation);
+            if (nextLocation == instructions.end() ||
+                visited.count(&*nextLocation) != 0)
+                break;
+
+            instruction->TargetLocation(newTargetLocation);
+            targetLocation = nextLocation;
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+bool Executable::RemoveRedundantJumps()
+{
+    // Remove unconditional jumps to the instruction that follows.
+    bool changed = false;
+    for (auto iter = instructions.begin(); iter != instructions.end(); iter++)
+    {
+        const auto &instruction = iter->instruction;
+        if (instruction->OpCode() != OpCode_JMP ||
+            Resolve(instruction->TargetLocation()) != NextInstruction(iter))
+            continue;
+
+        Replace(iter, new NullInstruction);
+        changed = true;
+    }
+
+    return changed;
+}
+
+bool Executable::RemoveUnreachableCode(const InstructionSet &targets)
+{
+    // Remove instructions following an unconditional exit that are not
+    // the target of any jump.
+    bool changed = false, reachable = true;
+    for (auto iter = instructions.begin(); iter != instructions.end(); iter++)
+    {
+        const auto &instruction = iter->instruction;
+
+        if (targets.count(&*iter) != 0)
+            reachable = true;
+        if (instruction->Size() == 0)
+            continue;
+
+        if (!reachable)
+        {
+            Replace(iter, new NullInstruction);
+            changed = true;
+        }
+        else if (IsUnconditionalExit(instruction->OpCode()))
+            reachable = false;
+    }
+
+    return changed;
+}
+
+bool Executable::CombineInstructions(const InstructionSet &targets)
+{
+    // Replace short instruction sequences with equivalent shorter ones.
+    // Sequences that a jump lands inside of are left alone.
+    bool changed = false;
+    for (auto iter = instructions.begin(); iter != instructions.end(); iter++)
+    {
+        const auto &instruction = iter->instruction;
+        auto opCode = instruction->OpCode();
+        if (instruction->Size() == 0)
+            continue;
+
+        auto nextIter = NextInstruction(iter, &targets);
+        if (nextIter == instructions.end())
+            continue;
+        auto nextOpCode = nextIter->instruction->OpCode();
+
+        // Remove a constant that is pushed only to be popped.
+        if (IsConstantPush(opCode) && nextOpCode == OpCode_POP)
+        {
+            Replace(iter, new NullInstruction);
+            Replace(nextIter, new NullInstruction);
+            changed = true;
+            continue;
+        }
+
+        // Pop the assigned value as part of the assignment.
+        if (opCode == OpCode_SET && nextOpCode == OpCode_POP)
+        {
+            Replace(iter, new SetInstruction(true, "Assign with pop"));
+            Replace(nextIter, new NullInstruction);
+            changed = true;
+            continue;
+        }
+
+        // Replace an assignment followed by a load of the same variable
+        // with an assignment that leaves the value on the stack.
+        if (nextOpCode != OpCode_SETP)
+            continue;
+        auto loadIter = NextInstruction(nextIter, &targets);
+        if (loadIter == instructions.end())
+            continue;
+        auto loadOpCode = loadIter->instruction->OpCode();
+        bool match = false;
+        if (opCode == OpCode_LDA1 || opCode == OpCode_LDA2 ||
+            opCode == OpCode_LDA4)
+        {
+            auto addressInstruction =
+                dynamic_cast<const LoadInstruction *>(instruction);
+            auto loadInstruction =
+                dynamic_cast<const LoadInstruction *>(loadIter->instruction);
+            match =
+                (loadOpCode == OpCode_LD1 || loadOpCode == OpCode_LD2 ||
+                 loadOpCode == OpCode_LD4) &&
+                addressInstruction->Symbol() == loadInstruction->Symbol();
+        }
+        else if (opCode == OpCode_LDLA1 || opCode == OpCode_LDLA2 ||
+                 opCode == OpCode_LDLA4)
+        {
+            auto addressInstruction =
+                dynamic_cast<const LoadLocalInstruction *>(instruction);
+            auto loadInstruction = dynamic_cast<const LoadLocalInstruction *>
+                (loadIter->instruction);
+            match =
+                (loadOpCode == OpCode_LDL1 || loadOpCode == OpCode_LDL2 ||
+                 loadOpCode == OpCode_LDL4) &&
+                addressInstruction->Symbol() == loadInstruction->Symbol();
+        }
+        if (match)
+        {
+            Replace
+                (nextIter,
+                 new SetInstruction(false, "Assign, leave value on stack"));
+            Replace(loadIter, new NullInstruction);
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+static bool IsJump(uint8_t opCode)
+{
+    return
+        opCode == OpCode_JMPF || opCode == OpCode_JMPT ||
+        opCode == OpCode_JMP ||
+        opCode == OpCode_LOR || opCode == OpCode_LAND ||
+        opCode == OpCode_BJMPF ||
+        opCode == OpCode_BIJMPF1 || opCode == OpCode_BIJMPF2 ||
+        opCode == OpCode_BIJMPF4;
+}
+
+static bool IsUnconditionalExit(uint8_t opCode)
+{
+    return
+        opCode == OpCode_JMP || opCode == OpCode_RET ||
+        opCode == OpCode_XMOD ||
+        opCode == OpCode_ABORT || opCode == OpCode_END;
+}
+
+static bool IsConstantPush(uint8_t opCode)
+{
+    return
+        opCode == OpCode_PUSHN || opCode == OpCode_PUSHE ||
+        opCode == OpCode_PUSHF || opCode == OpCode_PUSHT ||
+        opCode == OpCode_PUSHI0 || opCode == OpCode_PUSHI1 ||
+        opCode == OpCode_PUSHI2 || opCode == OpCode_PUSHI4 ||
+        opCode == OpCode_PUSHD ||
+        opCode == OpCode_PUSHY1 || opCode == OpCode_PUSHY2 ||
+        opCode == OpCode_PUSHY4 ||
+        opCode == OpCode_PUSHS0 || opCode == OpCode_PUSHS1 ||
+        opCode == OpCode_PUSHS2 || opCode == OpCode_PUSHS4;
+}
@@ -466,3 +466,19 @@ DefStatement::~DefStatement()
     delete parameterList;
     delete block;
 }
+
+bool DefStatement::LocalSlot(int32_t symbol, uint8_t &slot) const
+{
+    auto iter = localSlots.find(symbol);
+    if (iter == localSlots.end())
+    {
+        // Keep the number of slots within the SLOTS instruction's
+        // 1-byte operand.
+        if (localSlots.size() >= UINT8_MAX)
+            return false;
+        iter = localSlots.emplace
+            (symbol, static_cast<uint8_t>(localSlots.size())).first;
+    }
+    slot = iter->second;
+    return true;
+}
@@ -9,7 +9,9 @@
 #include "expression.hpp"
 #include "executable.hpp"
 #include <list>
+#include <map>
 #include <string>
+#include <cstdint>
 
 class Block;
 class LoopStatement;
@@ -454,11 +456,16 @@ class DefStatement : public Statement
 
         void Emit(Executable &) const override;
 
+        // Local variable slot assignment. Returns false if all slots are
+        // already in use by other variables.
+        bool LocalSlot(std::int32_t symbol, std::uint8_t &slot) const;
+
     private:
 
         std::string name;
         ParameterList *parameterList;
         Block *block;
+        mutable std::map<std::int32_t, std::uint8_t> localSlots;
 };
 
 #endif
@@ -936,6 +936,8 @@ static const char *TypeString(DataType type)
             return "app-ptr";
         case DataType_Type:
             return "type";
+        default:
+            break;
     }
 
     return "?";
@@ -20,6 +20,10 @@ extern "C" {
 typedef struct AspEngine AspEngine;
 typedef union AspDataEntry AspDataEntry;
 typedef struct AspCodePageEntry AspCodePageEntry;
+typedef struct AspCodePageCache AspCodePageCache;
+typedef struct AspSequenceIndexCacheEntry AspSequenceIndexCacheEntry;
+typedef struct AspLoadCacheEntry AspLoadCacheEntry;
+typedef struct AspStringLiteralCacheEntry AspStringLiteralCacheEntry;
 typedef struct AspAppSpec AspAppSpec;
 
 #ifdef __cplusplus
@@ -36,12 +40,106 @@ typedef AspRunResult (AspDispatchFunction)
     (AspEngine *, int32_t symbol, AspDataEntry *ns,
      AspDataEntry **returnValue);
 
+/* Code page cache entry. Entries are linked into a list ordered from most
+   to least recently used, and those holding pages are also chained from
+   hash buckets keyed by page number. The pin count is the number of
+   engines running from the page, or a special value while the page is
+   being read. An engine using a page without the lock marks it as
+   touched, leaving the move within the list to the next replacement. */
 struct AspCodePageEntry
 {
-    uint8_t index;
-    int8_t age;
+    uint32_t index;
+    uint16_t newer, older, chain;
+    uint16_t pinCount;
+    bool used, referenced, touched, pinned;
 };
 
+/* Code pages used by one engine or shared by engines running the same
+   paged executable. Each engine pins the page it is running from, so that
+   the page is not replaced while in use. Where atomic operations are
+   available, engines locate and pin cached pages without the lock, taking
+   it only to read a missing page, and releasing it during the read. Pages
+   may also be pinned by the application, e.g., to keep frequently called
+   functions in memory. */
+struct AspCodePageCache
+{
+    uint8_t *pages;
+    AspCodePageEntry *entries;
+    uint16_t *buckets;
+    uint16_t pageCount, bucketMask;
+    uint16_t engineCount, pinnedCount;
+    uint16_t newest, oldest, clockHand;
+    AspCodePagePolicy policy;
+    size_t pageSize;
+    AspCodeReader reader;
+    void *id;
+    AspCodePageCacheLock lock;
+    void *lockContext;
+    bool codeEndKnown;
+    size_t codeEndOffset;
+};
+
+/* Number of recently indexed sequence positions remembered by the engine. */
+#define ASP_SEQUENCE_INDEX_CACHE_SIZE 4
+
+struct AspSequenceIndexCacheEntry
+{
+    uint32_t sequenceIndex, elementIndex;
+    int32_t position;
+};
+
+/* Minimum length of a tuple or list, and minimum number of elements that
+   indexing would otherwise traverse, at which the engine builds a chunk index
+   for the sequence. The index is only built once traversals of the sequence
+   have covered the given multiple of its length, and only extended while
+   more than the given fraction of the data area would remain free. */
+#define ASP_SEQUENCE_CHUNK_INDEX_MIN_COUNT 32
+#define ASP_SEQUENCE_CHUNK_INDEX_MIN_DISTANCE 8
+#define ASP_SEQUENCE_CHUNK_INDEX_BUILD_RATIO 8
+#define ASP_SEQUENCE_CHUNK_INDEX_FREE_DIVISOR 4
+
+/* Number of members at which a set or dictionary gets a hash index in builds
+   with ASP_HASHED_COLLECTIONS. Should there be too little memory, the build
+   is retried each time the count doubles. The index is dropped when the count
+   falls below half the minimum, and is only built or extended while more than
+   the given fraction of the data area would remain free. */
+#define ASP_TREE_HASH_INDEX_MIN_COUNT 16
+#define ASP_TREE_HASH_INDEX_FREE_DIVISOR 4
+
+/* Number of local variable slots shared by the script function calls in
+   progress. Each call reserves as many as its function uses. A call for
+   which too few remain looks up its variables by symbol instead. */
+#define ASP_LOCAL_SLOT_COUNT 256
+
+/* Number of variable load instruction sites whose resolved global or system
+   namespace node is remembered by the engine. */
+#define ASP_LOAD_CACHE_SIZE 16
+
+struct AspLoadCacheEntry
+{
+    uint32_t address, generation, namespaceIndex, nodeIndex;
+    int32_t symbol;
+};
+
+/* Number of string literal instruction sites whose string is retained by
+   the engine. Sites share an entry only if their addresses are a multiple
+   of this number apart, so the literals of any loop whose code is no longer
+   than this are always retained together. */
+#define ASP_STRING_LITERAL_CACHE_SIZE 128
+
+struct AspStringLiteralCacheEntry
+{
+    uint32_t address, stringIndex;
+};
+
+/* Number of single-character strings, indexed by character code, that the
+   engine shares rather than allocating anew. */
+#define ASP_CHARACTER_STRING_CACHE_SIZE 128
+
+/* Number of data type slots in which live entries are counted: one per data
+   type, plus one for any entry of an unknown type. */
+#define ASP_DATA_TYPE_SLOT_COUNT 41
+
 struct AspAppSpec
 {
     const char *spec;
@@ -76,6 +174,12 @@ struct AspEngine
     AspAddCodeResult loadResult;
     AspRunResult runResult;
 
+    /* Deadline checker, called by AspRun after each interval of
+       instructions. */
+    AspDeadlineChecker deadlineChecker;
+    void *deadlineCheckerContext;
+    uint32_t deadlineCheckInterval;
+
     /* Version information. */
     uint8_t version[4]; /* major, minor, patch, tweak */
 
@@ -84,14 +188,19 @@ struct AspEngine
     size_t maxCodeSize, codeEndIndex;
     uint32_t pc, instructionAddress;
 
-    /* Code paging data. */
-    uint8_t cachedCodePageCount, cachedCodePageIndex;
-    bool codeEndKnown;
+    /* Code paging data. The cache in use is either the engine's own or
+       one shared with other engines. The bytes and code offset of the page
+       the engine is running from are kept for quick access. */
+    AspCodePageCache ownCodePageCache, *codePageCache;
+    uint16_t codePageEntryIndex;
+    bool codePagePinned, codeEndKnown;
+    uint8_t *codePage;
+    uint32_t codePageOffset;
     size_t codePageSize;
-    AspCodePageEntry *cachedCodePages;
-    AspCodeReader codeReader;
-    void *pagedCodeId;
-    size_t codePageReadCount;
+    size_t codePageReadCount, codePageHitCount;
+    AspCodePrefetcher codePrefetcher;
+    size_t codeReadAheadOffset;
+    uint32_t codeReadAheadTrigger;
 
     /* Data space. */
     AspDataEntry *data;
@@ -99,6 +208,48 @@ struct AspEngine
     size_t freeCount, lowFreeCount;
     uint32_t freeListIndex;
 
+    /* Entries at or beyond the watermark have not been allocated since the
+       data area was last cleared, and are implicitly free. Clearing the
+       data area therefore only has to reset the watermark. */
+    uint32_t dataWatermark;
+
+    /* Live entry counts, by data type slot. */
+    uint32_t dataTypeCounts[ASP_DATA_TYPE_SLOT_COUNT];
+
+    /* Recently indexed sequence elements, used as starting points when
+       traversing a sequence to locate an element by index. */
+    AspSequenceIndexCacheEntry sequenceIndexCache
+        [ASP_SEQUENCE_INDEX_CACHE_SIZE];
+    uint8_t sequenceIndexCacheNext;
+
+    /* Sequence whose long traversals are being counted towards building a
+       chunk index for it, and the number of elements traversed so far. */
+    uint32_t chunkIndexCandidateIndex, chunkIndexTraversalCount;
+
+    /* Local variable namespace nodes, by slot. Each script function call
+       in progress holds a range of slots following those of its caller. */
+    uint32_t localSlots[ASP_LOCAL_SLOT_COUNT];
+    uint32_t localSlotCount;
+
+    /* Global and system namespace nodes resolved by recent variable loads,
+       keyed by instruction address. An entry is valid only while the
+       namespace generation, which changes whenever a variable is added to
+       or removed from a non-local namespace, remains the same. */
+    AspLoadCacheEntry loadCache[ASP_LOAD_CACHE_SIZE];
+    uint32_t namespaceGeneration;
+
+    /* Shared single-character strings, indexed by character code. Each is
+       created on first use and retained until data memory runs out. */
+    uint32_t characterStrings[ASP_CHARACTER_STRING_CACHE_SIZE];
+    size_t characterStringShareCount;
+
+    /* Strings pushed by recently executed string literal instructions,
+       in the entry selected by instruction address. These are also retained
+       until data memory runs out. */
+    AspStringLiteralCacheEntry stringLiteralCache
+        [ASP_STRING_LITERAL_CACHE_SIZE];
+    size_t stringLiteralShareCount;
+
     /* Loop iteration limit for detecting potential cycles in data
        structures. */
     uint32_t cycleDetectionLimit;
@@ -108,7 +259,7 @@ struct AspEngine
 
     /* Stack. */
     AspDataEntry *stackTop;
-    unsigned stackCount;
+    unsigned stackCount, peakStackCount;
 
     /* Modules namespace. */
     AspDataEntry *modules;
@@ -134,6 +285,13 @@ struct AspEngine
     #ifdef ASP_DEBUG
     FILE *traceFile;
     #endif
+
+    #ifdef ASP_OPCODE_PROFILE
+    AspOpCodeProfiler opCodeProfiler;
+    void *opCodeProfilerContext;
+    AspProfile *profile;
+    uint8_t profileOpCode;
+    #endif
 };
 
 /* Definitions used by auto-generated application function support code. */
@@ -21,7 +21,8 @@
 extern "C" {
 #endif
 
-/* Result returned from AspAddCode, AspSeal, AspSealCode, and AspPageCode. */
+/* Result returned from AspAddCode, AspSeal, AspSealCode, AspPageCode, and
+   AspShareCodePages. */
 typedef enum
 {
     AspAddCodeResult_OK = 0x00,
@@ -32,7 +33,8 @@ typedef enum
     AspAddCodeResult_InvalidState = 0x08,
 } AspAddCodeResult;
 
-/* Result returned from AspInitialize, AspReset, and AspStep, among others. */
+/* Result returned from AspInitialize, AspReset, AspStep, and AspRun, among
+   others. */
 typedef enum
 {
     AspRunResult_OK = 0x00,
@@ -76,6 +78,57 @@ typedef double (*AspFloatConverter)(uint8_t ieee754_binary64[8]);
 typedef AspRunResult (*AspCodeReader)
     (void *id, uint32_t offset, size_t *size, void *codePage);
 
+/* Code prefetcher type, called to indicate that the code page at the given
+   offset is likely to be read soon. */
+typedef void (*AspCodePrefetcher)(void *id, uint32_t offset, size_t size);
+
+/* Deadline checker type, called by AspRun between instructions at the
+   interval given to AspSetDeadlineChecker. Returning false ends the call
+   early, e.g., once a wall-clock deadline has passed. */
+typedef bool (*AspDeadlineChecker)(void *context);
+
+/* Shared code page cache lock type, called to acquire (lock is true) or
+   release (lock is false) exclusive access to the cache. The cache's code
+   reader is called without the lock, so it may be called for different
+   pages at the same time. */
+typedef void (*AspCodePageCacheLock)(void *context, bool lock);
+
+/* Code page replacement policy, which determines the cached page replaced
+   when another page must be read. */
+typedef enum
+{
+    AspCodePagePolicy_LRU,
+    AspCodePagePolicy_Clock,
+} AspCodePagePolicy;
+
+/* Data area usage. Live entry counts are indexed by data type code, whose
+   name is given by AspDataTypeName. The stack depth counts both values and
+   call frames. */
+typedef struct AspDataStatistics
+{
+    uint32_t entryCounts[256];
+    size_t freeCount, lowFreeCount;
+    unsigned stackDepth, peakStackDepth;
+} AspDataStatistics;
+
+#ifdef ASP_OPCODE_PROFILE
+/* Instruction profiler type, called with each op code before it executes. */
+typedef void (*AspOpCodeProfiler)(void *context, uint8_t opCode);
+
+/* Profile counters, supplied by the caller and updated by the engine as
+   instructions execute. Each entry of pcCounts counts the executions of the
+   instruction at that code address; instructions beyond pcCountsSize are
+   counted only by op code. Allocations of data entries made while running
+   are attributed to the op code of the instruction being executed. */
+typedef struct AspProfile
+{
+    uint32_t opCodeCounts[256];
+    uint32_t allocationCounts[256];
+    uint32_t *pcCounts;
+    size_t pcCountsSize;
+} AspProfile;
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -97,7 +150,7 @@ ASP_API AspRunResult AspInitializeEx
     (AspEngine *, void *code, size_t codeSize, void *data, size_t dataSize,
      const AspAppSpec *, void *context, AspFloatConverter);
 ASP_API AspRunResult AspSetCodePaging
-    (AspEngine *, uint8_t pageCount, size_t pageSize, AspCodeReader);
+    (AspEngine *, uint16_t pageCount, size_t pageSize, AspCodeReader);
 ASP_API void AspCodeVersion(const AspEngine *, uint8_t version[4]);
 ASP_API size_t AspMaxCodeSize(const AspEngine *);
 ASP_API size_t AspMaxDataSize(const AspEngine *);
@@ -107,6 +160,19 @@ ASP_API AspAddCodeResult AspSeal(AspEngine *);
 ASP_API AspAddCodeResult AspSealCode
     (AspEngine *, const void *code, size_t codeSize);
 ASP_API AspAddCodeResult AspPageCode(AspEngine *, void *id);
+ASP_API size_t AspCodePageCacheSize(uint16_t pageCount, size_t pageSize);
+ASP_API AspRunResult AspInitializeCodePageCache
+    (AspCodePageCache *, void *pages, size_t pagesSize,
+     uint16_t pageCount, size_t pageSize, AspCodeReader, void *id,
+     AspCodePageCacheLock, void *lockContext);
+ASP_API AspAddCodeResult AspShareCodePages
+    (AspEngine *, AspCodePageCache *);
+ASP_API void AspUnshareCodePages(AspEngine *);
+ASP_API AspRunResult AspSetCodePrefetcher
+    (AspEngine *, AspCodePrefetcher, size_t readAheadOffset);
+ASP_API AspRunResult AspSetCodePagePolicy(AspEngine *, AspCodePagePolicy);
+ASP_API AspRunResult AspPinCodePage(AspEngine *, uint32_t address);
+ASP_API AspRunResult AspUnpinCodePage(AspEngine *, uint32_t address);
 ASP_API AspRunResult AspReset(AspEngine *);
 ASP_API AspRunResult AspSetArguments(AspEngine *, const char * const *);
 ASP_API AspRunResult AspSetArgumentsString(AspEngine *, const char *);
@@ -116,16 +182,42 @@ ASP_API uint32_t AspGetCycleDetectionLimit(const AspEngine *);
 /* Execution control. */
 ASP_API AspRunResult AspRestart(AspEngine *);
 ASP_API AspRunResult AspStep(AspEngine *);
+ASP_API AspRunResult AspRun
+    (AspEngine *, uint32_t stepLimit, uint32_t *stepCount);
+ASP_API AspRunResult AspSetDeadlineChecker
+    (AspEngine *, AspDeadlineChecker, void *context, uint32_t interval);
 ASP_API bool AspIsReady(const AspEngine *);
 ASP_API bool AspIsRunning(const AspEngine *);
 ASP_API bool AspIsRunnable(const AspEngine *);
+ASP_API bool AspIsCodeReady(AspEngine *);
 ASP_API size_t AspProgramCounter(const AspEngine *);
+ASP_API size_t AspCallStack
+    (const AspEngine *, size_t *returnAddresses, size_t maxCount);
 ASP_API size_t AspLowFreeCount(const AspEngine *);
+ASP_API void AspGetDataStatistics
+    (const AspEngine *, AspDataStatistics *);
+ASP_API const char *AspDataTypeName(uint8_t type);
 ASP_API size_t AspCodePageReadCount(AspEngine *, bool reset);
+ASP_API size_t AspCodePageHitCount(AspEngine *, bool reset);
+ASP_API size_t AspCharacterStringShareCount(AspEngine *, bool reset);
+ASP_API size_t AspStringLiteralShareCount(AspEngine *, bool reset);
+ASP_API size_t AspSnapshotSize(const AspEngine *);
+ASP_API AspRunResult AspSaveSnapshot
+    (const AspEngine *, void *snapshot, size_t snapshotSize);
+ASP_API AspRunResult AspRestoreSnapshot
+    (AspEngine *, const void *snapshot, size_t snapshotSize);
+ASP_API AspRunResult AspFork
+    (const AspEngine *, AspEngine *fork,
+     void *data, size_t dataSize, void *context);
 #ifdef ASP_DEBUG
 ASP_API void AspTraceFile(AspEngine *, FILE *);
 ASP_API void AspDump(const AspEngine *, FILE *);
 #endif
+#ifdef ASP_OPCODE_PROFILE
+ASP_API void AspSetOpCodeProfiler
+    (AspEngine *, AspOpCodeProfiler, void *context);
+ASP_API void AspSetProfile(AspEngine *, AspProfile *);
+#endif
 
 /* API for use by application functions. */
 ASP_API bool AspIsNone(const AspDataEntry *);
@@ -167,6 +259,10 @@ ASP_API AspDataEntry *AspToString(AspEngine *, AspDataEntry *);
 ASP_API AspDataEntry *AspToRepr(AspEngine *, const AspDataEntry *);
 ASP_API AspRunResult AspCount
     (AspEngine *, const AspDataEntry *, int32_t *count);
+/* Indexing a tuple or list far from its ends and from recently indexed
+   positions goes through a chunk index that the engine builds for the
+   sequence, so the cost grows with the logarithm of its length (one step
+   per four-fold increase) rather than being constant. */
 ASP_API AspDataEntry *AspElement
     (AspEngine *, const AspDataEntry *sequence, int32_t index);
 ASP_API int32_t AspRangeElement
@@ -3,20 +3,98 @@
  */
 
 #include "code.h"
+#include <string.h>
 #include <stdint.h>
 
-static void UpdateAges(AspEngine *);
+/* Where the compiler provides atomic operations, engines sharing a cache
+   locate and pin cached pages without taking the lock. The entry fields
+   examined in doing so are accessed atomically throughout. */
+#ifdef __ATOMIC_ACQUIRE
+#define ASP_LOCK_FREE_CODE_PAGES
+#define AtomicLoad(p) (__atomic_load_n((p), __ATOMIC_RELAXED))
+#define AtomicStore(p, v) (__atomic_store_n((p), (v), __ATOMIC_RELAXED))
+#else
+#define AtomicLoad(p) (*(p))
+#define AtomicStore(p, v) (*(p) = (v))
+#endif
+
+static const uint16_t NoEntry = UINT16_MAX;
+static const uint16_t LoadingPinCount = UINT16_MAX;
+
+static AspRunResult AcquireCodePage
+    (AspEngine *, AspCodePageCache *, uint32_t codePageIndex,
+     uint16_t *entryIndex);
+static AspRunResult PinCodePage(AspEngine *, uint32_t address, bool pin);
+static bool FindCodePage(AspEngine *, uint32_t offset, bool touch);
+static void ArmReadAhead(AspEngine *);
+static void RequestCodePage(AspEngine *, uint32_t offset);
+static uint16_t PinCachedEntry
+    (AspCodePageCache *, uint32_t codePageIndex);
+static uint16_t FindCachedEntry
+    (const AspCodePageCache *, uint32_t codePageIndex);
+static uint16_t FindEntry(const AspCodePageCache *, uint32_t codePageIndex);
+static uint16_t SelectEntry(AspCodePageCache *);
+static bool PinEntry(AspCodePageEntry *);
+static void UnpinEntry(AspCodePageEntry *);
+static bool ClaimEntry(AspCodePageEntry *);
+static void ReleaseEntry(AspCodePageEntry *, uint16_t pinCount);
+static uint16_t EntryPinCount(const AspCodePageEntry *);
+static void MarkEntry(AspCodePageEntry *);
+static void SetCodeEnd(AspCodePageCache *, size_t endOffset);
+static void GetCodeEnd(AspEngine *, const AspCodePageCache *);
+static void TouchEntry(AspCodePageCache *, uint16_t entryIndex);
+static void LinkEntry(AspCodePageCache *, uint16_t entryIndex, bool newest);
+static void UnlinkEntry(AspCodePageCache *, uint16_t entryIndex);
+static void HashEntry(AspCodePageCache *, uint16_t entryIndex);
+static void UnhashEntry(AspCodePageCache *, uint16_t entryIndex);
+static void LockCache(const AspCodePageCache *, bool lock);
+static void LockLookup(const AspCodePageCache *, bool lock);
+
+AspRunResult AspFetchCodeBytes
+    (AspEngine *engine, size_t count, uint8_t *buffer, const uint8_t **bytes)
+{
+    /* Access unpaged code directly. */
+    if (engine->codePageCache == 0)
+    {
+        if (engine->pc + count > engine->codeEndIndex)
+            return AspRunResult_BeyondEndOfCode;
+
+        *bytes = engine->code + engine->pc;
+        engine->pc += (uint32_t)count;
+        return AspRunResult_OK;
+    }
+
+    /* Access paged code directly if all the requested bytes lie within the
+       page containing the program counter. */
+    AspRunResult checkResult = AspValidateCodeAddress(engine, engine->pc);
+    if (checkResult != AspRunResult_OK)
+        return checkResult;
+    uint32_t pageOffset =
+        engine->headerIndex + engine->pc - engine->codePageOffset;
+    if (pageOffset + count <= engine->codePageSize &&
+        (!engine->codeEndKnown ||
+         engine->pc + count <= engine->codeEndIndex))
+    {
+        *bytes = engine->codePage + pageOffset;
+        engine->pc += (uint32_t)count;
+        return AspRunResult_OK;
+    }
+
+    /* Otherwise, copy the bytes into the caller's buffer. */
+    *bytes = buffer;
+    return AspLoadCodeBytes(engine, buffer, count);
+}
 
 AspRunResult AspLoadCodeBytes
     (AspEngine *engine, uint8_t *bytes, size_t count)
 {
-    if (engine->cachedCodePageCount == 0)
+    if (engine->codePageCache == 0)
     {
         if (engine->pc + count > engine->codeEndIndex)
             return AspRunResult_BeyondEndOfCode;
 
-        while (count--)
-            *bytes++ = *(engine->code + engine->pc++);
+        memcpy(bytes, engine->code + engine->pc, count);
+        engine->pc += (uint32_t)count;
         return AspRunResult_OK;
     }
 
@@ -28,12 +106,8 @@ AspRunResult AspLoadCodeBytes
         if (checkResult != AspRunResult_OK)
             return checkResult;
 
-        const uint8_t *page =
-            engine->codeArea +
-            engine->cachedCodePageIndex * engine->codePageSize;
-        uint32_t pageOffset = offset++ % engine->codePageSize;
         engine->pc++;
-        *bytes++ = *(page + pageOffset);
+        *bytes++ = *(engine->codePage + (offset++ - engine->codePageOffset));
     }
 
     return AspRunResult_OK;
@@ -41,7 +115,7 @@ AspRunResult AspLoadCodeBytes
 
 AspRunResult AspValidateCodeAddress(AspEngine *engine, uint32_t address)
 {
-    if (engine->cachedCodePageCount == 0)
+    if (engine->codePageCache == 0)
     {
         if (address > engine->codeEndIndex)
             return AspRunResult_BeyondEndOfCode;
@@ -50,18 +124,24 @@ AspRunResult AspValidateCodeAddress(AspEngine *engine, uint32_t address)
     {
         /* Load the applicable code page. */
         uint32_t offset = engine->headerIndex + address;
-        const AspCodePageEntry *entry =
-            engine->cachedCodePages + engine->cachedCodePageIndex;
-        uint32_t codePageOffset =
-            entry->index * (uint32_t)engine->codePageSize;
-        if (offset < codePageOffset ||
-            offset >= codePageOffset + engine->codePageSize)
+        if (engine->codePage == 0 ||
+            offset - engine->codePageOffset >= engine->codePageSize)
         {
             AspRunResult loadResult = AspLoadCodePage(engine, offset);
             if (loadResult != AspRunResult_OK)
                 return loadResult;
         }
 
+        /* Request the next page once execution passes the read-ahead point
+           within the current page. */
+        if (offset >= engine->codeReadAheadTrigger)
+        {
+            engine->codeReadAheadTrigger = UINT32_MAX;
+            RequestCodePage
+                (engine,
+                 engine->codePageOffset + (uint32_t)engine->codePageSize);
+        }
+
         /* Ensure the program counter is in bounds if possible (i.e., if the
            last page has been loaded). */
         if (engine->codeEndKnown && address >= engine->codeEndIndex)
@@ -71,92 +151,705 @@ AspRunResult AspValidateCodeAddress(AspEngine *engine, uint32_t address)
     return AspRunResult_OK;
 }
 
+AspRunResult AspValidateCodeTarget(AspEngine *engine, uint32_t address)
+{
+    if (engine->codePageCache == 0)
+        return AspValidateCodeAddress(engine, address);
+
+    /* Rather than loading the page containing a jump or call target, which
+       may not be needed if the jump is not taken, defer loading it until
+       control is transferred to it. If the page is cached, mark it as
+       recently used so that it is less likely to be replaced in the
+       meantime. Otherwise, request that it be prefetched. */
+    if (engine->codeEndKnown && address >= engine->codeEndIndex)
+        return AspRunResult_BeyondEndOfCode;
+    uint32_t offset = engine->headerIndex + address;
+    if (!FindCodePage(engine, offset, true))
+        RequestCodePage(engine, offset);
+    return AspRunResult_OK;
+}
+
+bool AspIsCodePageCached(AspEngine *engine, uint32_t offset)
+{
+    return
+        engine->codePageCache == 0 ||
+        FindCodePage(engine, offset, false);
+}
+
 AspRunResult AspLoadCodePage(AspEngine *engine, uint32_t offset)
 {
-    /* Determine which page to load. */
-    uint8_t codePageIndex = (uint8_t)(offset / (uint32_t)engine->codePageSize);
+    AspCodePageCache *cache = engine->codePageCache;
+    uint32_t codePageIndex = offset / (uint32_t)cache->pageSize;
 
-    /* Determine whether the page is already cached. */
-    for (uint8_t i = 0; i < engine->cachedCodePageCount; i++)
+    /* Release the page this engine was running from, and pin the requested
+       page if it is cached. */
+    LockLookup(cache, true);
+    if (engine->codePagePinned)
     {
-        const AspCodePageEntry *entry = engine->cachedCodePages + i;
+        UnpinEntry(cache->entries + engine->codePageEntryIndex);
+        engine->codePagePinned = false;
+        engine->codePage = 0;
+    }
+    uint16_t entryIndex = PinCachedEntry(cache, codePageIndex);
+    LockLookup(cache, false);
 
-        uint32_t codePageOffset =
-            entry->index * (uint32_t)engine->codePageSize;
-        if (entry->age >= 0 &&
-            offset >= codePageOffset &&
-            offset < codePageOffset + engine->codePageSize)
-        {
-            if (engine->cachedCodePageIndex != i)
-            {
-                engine->cachedCodePageIndex = i;
-                UpdateAges(engine);
-            }
-            return AspRunResult_OK;
-        }
+    /* Otherwise, pin it under the lock, reading it if necessary. */
+    AspRunResult result = AspRunResult_OK;
+    if (entryIndex != NoEntry)
+    {
+        if (engine->codePageHitCount < SIZE_MAX)
+            engine->codePageHitCount++;
+        GetCodeEnd(engine, cache);
+    }
+    else
+    {
+        LockCache(cache, true);
+        result = AcquireCodePage(engine, cache, codePageIndex, &entryIndex);
+        LockCache(cache, false);
+        if (result != AspRunResult_OK)
+            return result;
     }
 
-    /* Find the least recently used cache page. */
-    int8_t oldestAge = 0;
-    for (uint8_t i = 0; i < engine->cachedCodePageCount; i++)
+    engine->codePagePinned = true;
+    engine->codePageEntryIndex = entryIndex;
+    engine->codePage = cache->pages + entryIndex * cache->pageSize;
+    engine->codePageOffset = codePageIndex * (uint32_t)cache->pageSize;
+    ArmReadAhead(engine);
+    return AspRunResult_OK;
+}
+
+size_t AspCodePageTableSize(uint16_t pageCount)
+{
+    size_t bucketCount = 1;
+    while (bucketCount < pageCount)
+        bucketCount <<= 1;
+    return
+        pageCount * sizeof(AspCodePageEntry) +
+        bucketCount * sizeof(uint16_t);
+}
+
+void AspInitializeCodePageTable(AspCodePageCache *cache, void *table)
+{
+    /* The hash buckets follow the entries. */
+    size_t bucketCount = 1;
+    while (bucketCount < cache->pageCount)
+        bucketCount <<= 1;
+    cache->entries = (AspCodePageEntry *)table;
+    cache->buckets = (uint16_t *)(cache->entries + cache->pageCount);
+    cache->bucketMask = (uint16_t)(bucketCount - 1);
+    AspClearCodePageTable(cache);
+}
+
+void AspClearCodePageTable(AspCodePageCache *cache)
+{
+    /* Order the unused entries so that the first one is used first. */
+    for (uint16_t i = 0; i < cache->pageCount; i++)
     {
-        const AspCodePageEntry *entry = engine->cachedCodePages + i;
+        AspCodePageEntry *entry = cache->entries + i;
+        entry->index = 0;
+        entry->newer = i + 1 == cache->pageCount ? NoEntry : i + 1;
+        entry->older = i == 0 ? NoEntry : i - 1;
+        entry->chain = NoEntry;
+        entry->pinCount = 0;
+        entry->used = entry->referenced = entry->touched = false;
+        entry->pinned = false;
+    }
+    for (size_t i = 0; i <= cache->bucketMask; i++)
+        cache->buckets[i] = NoEntry;
+    cache->newest = cache->pageCount - 1;
+    cache->oldest = 0;
+    cache->clockHand = 0;
+    cache->engineCount = 0;
+    cache->pinnedCount = 0;
+    cache->codeEndKnown = false;
+    cache->codeEndOffset = 0;
+}
 
-        /* Check for a previously unused entry. */
-        if (entry->age < 0)
-        {
-            engine->cachedCodePageIndex = i;
+bool AspAttachCodePageCache(AspEngine *engine, AspCodePageCache *cache)
+{
+    /* Limit the number of engines plus the number of pages pinned by the
+       application to the number of pages. As each engine pins at most one
+       page, this ensures that an engine moving to another page can always
+       find one to replace. */
+    LockCache(cache, true);
+    bool attached = cache->engineCount + cache->pinnedCount < cache->pageCount;
+    if (attached)
+    {
+        cache->engineCount++;
+        if (engine->codePagePinned)
+            PinEntry(cache->entries + engine->codePageEntryIndex);
+    }
+    LockCache(cache, false);
+    if (!attached)
+        return false;
+
+    engine->codePageCache = cache;
+    engine->codePageSize = cache->pageSize;
+    return true;
+}
+
+void AspDetachCodePageCache(AspEngine *engine)
+{
+    AspCodePageCache *cache = engine->codePageCache;
+    if (cache == 0)
+        return;
+
+    LockCache(cache, true);
+    if (engine->codePagePinned)
+        UnpinEntry(cache->entries + engine->codePageEntryIndex);
+    cache->engineCount--;
+    LockCache(cache, false);
+
+    engine->codePageCache = 0;
+    engine->codePagePinned = false;
+    engine->codePageEntryIndex = 0;
+    engine->codePage = 0;
+    engine->codePageOffset = 0;
+    engine->codePageSize = 0;
+}
+
+AspRunResult AspSetCodePagePolicy
+    (AspEngine *engine, AspCodePagePolicy policy)
+{
+    /* The policy applies to the cache the engine is using, so setting it
+       for one engine sharing a cache sets it for all of them. Both
+       policies track page use in the same way, so the policy may be
+       changed at any time. */
+    AspCodePageCache *cache = engine->codePageCache;
+    if (engine->inApp || cache == 0)
+        return AspRunResult_InvalidState;
+    if (policy != AspCodePagePolicy_LRU && policy != AspCodePagePolicy_Clock)
+        return AspRunResult_ValueOutOfRange;
+
+    LockCache(cache, true);
+    cache->policy = policy;
+    LockCache(cache, false);
+    return AspRunResult_OK;
+}
+
+AspRunResult AspPinCodePage(AspEngine *engine, uint32_t address)
+{
+    return PinCodePage(engine, address, true);
+}
+
+AspRunResult AspUnpinCodePage(AspEngine *engine, uint32_t address)
+{
+    return PinCodePage(engine, address, false);
+}
+
+size_t AspCodePageHitCount(AspEngine *engine, bool reset)
+{
+    size_t count = engine->codePageHitCount;
+    if (reset)
+        engine->codePageHitCount = 0;
+    return count;
+}
+
+static AspRunResult AcquireCodePage
+    (AspEngine *engine, AspCodePageCache *cache, uint32_t codePageIndex,
+     uint16_t *entryIndex)
+{
+    /* Determine whether the page is cached. If not, claim the entry chosen
+       by the replacement policy. While another engine is reading the page,
+       or while other engines hold every entry, let go of the lock so that
+       they can finish, and try again. Each engine pins at most one page
+       and the number of pages pinned by the application is limited, so an
+       entry is bound to become available. */
+    uint16_t index;
+    bool cached;
+    for (;;)
+    {
+        index = FindEntry(cache, codePageIndex);
+        cached = index != NoEntry;
+        if (cached ?
+            EntryPinCount(cache->entries + index) != LoadingPinCount :
+            (index = SelectEntry(cache)) != NoEntry)
             break;
+        if (cache->lock == 0)
+            return AspRunResult_InternalError;
+        LockCache(cache, false);
+        LockCache(cache, true);
+    }
+
+    AspCodePageEntry *entry = cache->entries + index;
+    if (cached)
+    {
+        PinEntry(entry);
+        if (engine->codePageHitCount < SIZE_MAX)
+            engine->codePageHitCount++;
+    }
+
+    /* Read the page into the claimed entry. The entry is chained from its
+       hash bucket beforehand, so that other engines wanting the page wait
+       for it rather than reading it again. The lock is let go during the
+       read, so that engines using other pages are not held up. */
+    else
+    {
+        if (entry->used)
+            UnhashEntry(cache, index);
+        AtomicStore(&entry->used, false);
+        AtomicStore(&entry->index, codePageIndex);
+        HashEntry(cache, index);
+
+        uint32_t codePageOffset = codePageIndex * (uint32_t)cache->pageSize;
+        size_t pageSize = cache->pageSize;
+        if (engine->codePageReadCount < SIZE_MAX)
+            engine->codePageReadCount++;
+        LockCache(cache, false);
+        AspRunResult readResult = cache->reader
+            (cache->id, codePageOffset, &pageSize,
+             cache->pages + index * cache->pageSize);
+        LockCache(cache, true);
+        if (readResult == AspRunResult_OK &&
+            codePageOffset == 0 && pageSize < engine->headerIndex)
+            readResult = AspRunResult_BeyondEndOfCode;
+        if (readResult != AspRunResult_OK)
+        {
+            /* Make the entry the next one to be replaced. */
+            UnhashEntry(cache, index);
+            UnlinkEntry(cache, index);
+            LinkEntry(cache, index, false);
+            AtomicStore(&entry->referenced, false);
+            ReleaseEntry(entry, 0);
+            return readResult;
         }
+        AtomicStore(&entry->used, true);
+
+        /* Determine the entire code size if possible. */
+        if (pageSize != cache->pageSize)
+            SetCodeEnd(cache, codePageOffset + pageSize);
 
-        if (i == 0 || entry->age > oldestAge)
+        /* Make the page available to other engines, pinned for this
+           one. */
+        ReleaseEntry(entry, 1);
+    }
+
+    TouchEntry(cache, index);
+    GetCodeEnd(engine, cache);
+
+    *entryIndex = index;
+    return AspRunResult_OK;
+}
+
+static AspRunResult PinCodePage
+    (AspEngine *engine, uint32_t address, bool pin)
+{
+    /* Pinning a page keeps it cached until it is unpinned. As the code
+       address is relative to the header, the code must have been loaded. */
+    AspCodePageCache *cache = engine->codePageCache;
+    if (engine->inApp || cache == 0 ||
+        (engine->state != AspEngineState_Ready &&
+         engine->state != AspEngineState_Running &&
+         engine->state != AspEngineState_RunError &&
+         engine->state != AspEngineState_Ended))
+        return AspRunResult_InvalidState;
+    if (engine->codeEndKnown && address >= engine->codeEndIndex)
+        return AspRunResult_BeyondEndOfCode;
+    uint32_t codePageIndex =
+        (engine->headerIndex + address) / (uint32_t)cache->pageSize;
+
+    LockCache(cache, true);
+
+    AspRunResult result = AspRunResult_OK;
+    uint16_t entryIndex = FindEntry(cache, codePageIndex);
+    if (!pin)
+    {
+        if (entryIndex != NoEntry && cache->entries[entryIndex].pinned)
+        {
+            cache->entries[entryIndex].pinned = false;
+            cache->pinnedCount--;
+        }
+    }
+    else if (entryIndex == NoEntry || !cache->entries[entryIndex].pinned)
+    {
+        /* Leave enough unpinned pages for each engine using the cache to
+           be able to move to another page. */
+        if (cache->engineCount + cache->pinnedCount >= cache->pageCount)
+            result = AspRunResult_ValueOutOfRange;
+        else if (entryIndex == NoEntry ||
+                 EntryPinCount(cache->entries + entryIndex) ==
+                 LoadingPinCount)
         {
-            oldestAge = entry->age;
-            engine->cachedCodePageIndex = i;
+            /* Reading the page may reveal that the address is beyond the
+               end of the code. As the lock is let go during the read, check
+               the number of pinned pages again afterwards. */
+            result = AcquireCodePage
+                (engine, cache, codePageIndex, &entryIndex);
+            if (result == AspRunResult_OK)
+            {
+                UnpinEntry(cache->entries + entryIndex);
+                if (engine->codeEndKnown && address >= engine->codeEndIndex)
+                    result = AspRunResult_BeyondEndOfCode;
+                else if (!cache->entries[entryIndex].pinned &&
+                         cache->engineCount + cache->pinnedCount >=
+                         cache->pageCount)
+                    result = AspRunResult_ValueOutOfRange;
+            }
+        }
+        if (result == AspRunResult_OK && !cache->entries[entryIndex].pinned)
+        {
+            cache->entries[entryIndex].pinned = true;
+            cache->pinnedCount++;
         }
     }
-    engine->cachedCodePages[engine->cachedCodePageIndex].index = codePageIndex;
-    UpdateAges(engine);
 
-    /* Read the page from offline storage into the least recently used cache
+    LockCache(cache, false);
+
+    return result;
+}
+
+static bool FindCodePage(AspEngine *engine, uint32_t offset, bool touch)
+{
+    /* Check the current page first. This needs no lock even if the cache
+       is shared, as a pinned page is not replaced. */
+    if (engine->codePage != 0 &&
+        offset - engine->codePageOffset < engine->codePageSize)
+        return true;
+
+    /* Otherwise, look up the page. The answer may be out of date by the
+       time it is used if the cache is shared, which is harmless, as it
+       serves only to guide prefetching and replacement. */
+    AspCodePageCache *cache = engine->codePageCache;
+    LockLookup(cache, true);
+    uint16_t entryIndex = FindCachedEntry
+        (cache, offset / (uint32_t)cache->pageSize);
+    if (entryIndex != NoEntry && touch)
+        MarkEntry(cache->entries + entryIndex);
+    LockLookup(cache, false);
+
+    return entryIndex != NoEntry;
+}
+
+static void ArmReadAhead(AspEngine *engine)
+{
+    engine->codeReadAheadTrigger =
+        engine->codePrefetcher == 0 ||
+        engine->codeReadAheadOffset >= engine->codePageSize ?
+        UINT32_MAX :
+        engine->codePageOffset + (uint32_t)engine->codeReadAheadOffset;
+}
+
+static void RequestCodePage(AspEngine *engine, uint32_t offset)
+{
+    if (engine->codePrefetcher == 0)
+        return;
+
+    /* Avoid requesting pages beyond the end of the code, if known, and
+       pages that are already cached. */
+    uint32_t codePageOffset = offset - offset % (uint32_t)engine->codePageSize;
+    if (engine->codeEndKnown &&
+        codePageOffset >= engine->headerIndex + engine->codeEndIndex)
+        return;
+    if (AspIsCodePageCached(engine, codePageOffset))
+        return;
+
+    engine->codePrefetcher
+        (engine->codePageCache->id, codePageOffset, engine->codePageSize);
+}
+
+static uint16_t PinCachedEntry
+    (AspCodePageCache *cache, uint32_t codePageIndex)
+{
+    uint16_t entryIndex = FindCachedEntry(cache, codePageIndex);
+    if (entryIndex == NoEntry)
+        return NoEntry;
+    AspCodePageEntry *entry = cache->entries + entryIndex;
+    if (!PinEntry(entry))
+        return NoEntry;
+
+    /* Now that the entry cannot be replaced, ensure it still holds the
        page. */
-    uint32_t codePageOffset =
-        codePageIndex * (uint32_t)engine->codePageSize;
-    size_t pageSize = engine->codePageSize;
-    if (engine->codePageReadCount < SIZE_MAX)
-        engine->codePageReadCount++;
-    AspRunResult readResult = engine->codeReader
-        (engine->pagedCodeId, codePageOffset, &pageSize,
-         engine->codeArea +
-         engine->cachedCodePageIndex * engine->codePageSize);
-    if (readResult != AspRunResult_OK)
-        return readResult;
-    if (codePageOffset == 0 && pageSize < engine->headerIndex)
-        return AspRunResult_BeyondEndOfCode;
+    if (AtomicLoad(&entry->index) != codePageIndex ||
+        !AtomicLoad(&entry->used))
+    {
+        UnpinEntry(entry);
+        return NoEntry;
+    }
+
+    MarkEntry(entry);
+    return entryIndex;
+}
 
-    /* Determine the entire code size if possible. */
-    if (pageSize != engine->codePageSize)
+static uint16_t FindCachedEntry
+    (const AspCodePageCache *cache, uint32_t codePageIndex)
+{
+    /* Other engines may be rearranging the hash chains, so limit the
+       number of steps taken. Missing a page is harmless, as the caller
+       then looks it up again under the lock. */
+    uint16_t entryIndex = AtomicLoad
+        (cache->buckets + (codePageIndex & cache->bucketMask));
+    for (uint16_t i = 0; entryIndex != NoEntry && i < cache->pageCount; i++)
+    {
+        const AspCodePageEntry *entry = cache->entries + entryIndex;
+        if (AtomicLoad(&entry->index) == codePageIndex)
+            return
+                AtomicLoad(&entry->used) &&
+                EntryPinCount(entry) != LoadingPinCount ?
+                entryIndex : NoEntry;
+        entryIndex = AtomicLoad(&entry->chain);
+    }
+    return NoEntry;
+}
+
+static uint16_t FindEntry
+    (const AspCodePageCache *cache, uint32_t codePageIndex)
+{
+    uint16_t entryIndex = cache->buckets[codePageIndex & cache->bucketMask];
+    while (entryIndex != NoEntry &&
+           cache->entries[entryIndex].index != codePageIndex)
+        entryIndex = cache->entries[entryIndex].chain;
+    return entryIndex;
+}
+
+static uint16_t SelectEntry(AspCodePageCache *cache)
+{
+    /* Skip pages pinned by an engine or by the application, and pages
+       being read. Unused entries are initially the least recently used and
+       are never marked as referenced, so both policies fill the cache
+       before replacing any page. The chosen entry is claimed for reading,
+       which fails if an engine has pinned it without the lock in the
+       meantime. */
+    if (cache->policy == AspCodePagePolicy_Clock)
     {
-        size_t endIndex = codePageOffset + pageSize - engine->headerIndex;
-        if (!engine->codeEndKnown || endIndex < engine->codeEndIndex)
+        /* Sweep the entries in order, giving each referenced page a second
+           chance. Two sweeps suffice to find an unpinned page if there is
+           one. */
+        for (uint32_t i = 0; i < 2U * cache->pageCount; i++)
         {
-            engine->codeEndIndex = endIndex;
-            engine->codeEndKnown = true;
+            uint16_t entryIndex = cache->clockHand;
+            AspCodePageEntry *entry = cache->entries + entryIndex;
+            cache->clockHand =
+                entryIndex + 1 == cache->pageCount ? 0 : entryIndex + 1;
+            if (entry->pinned || EntryPinCount(entry) != 0)
+                continue;
+            if (!AtomicLoad(&entry->referenced))
+            {
+                if (ClaimEntry(entry))
+                    return entryIndex;
+                continue;
+            }
+            AtomicStore(&entry->referenced, false);
         }
     }
 
-    return AspRunResult_OK;
+    /* Otherwise, choose the least recently used page. Pages used by
+       engines that did not take the lock have not been moved within the
+       list, so move any such page to the newest end instead of choosing
+       it. */
+    else
+    {
+        uint16_t entryIndex = cache->oldest;
+        for (uint32_t i = 0;
+             entryIndex != NoEntry && i < 2U * cache->pageCount; i++)
+        {
+            AspCodePageEntry *entry = cache->entries + entryIndex;
+            uint16_t newerIndex = entry->newer;
+            if (!entry->pinned && EntryPinCount(entry) == 0)
+            {
+                if (AtomicLoad(&entry->touched))
+                {
+                    TouchEntry(cache, entryIndex);
+                    if (newerIndex == NoEntry)
+                        newerIndex = entryIndex;
+                }
+                else if (ClaimEntry(entry))
+                    return entryIndex;
+            }
+            entryIndex = newerIndex;
+        }
+    }
+
+    /* Other engines may keep marking pages as used while the policy looks
+       for one to replace. Rather than give up, take any page not in use. */
+    for (uint16_t entryIndex = 0; entryIndex < cache->pageCount; entryIndex++)
+    {
+        AspCodePageEntry *entry = cache->entries + entryIndex;
+        if (!entry->pinned && EntryPinCount(entry) == 0 && ClaimEntry(entry))
+            return entryIndex;
+    }
+    return NoEntry;
 }
 
-static void UpdateAges(AspEngine *engine)
+static void TouchEntry(AspCodePageCache *cache, uint16_t entryIndex)
 {
-    for (unsigned i = 0; i < engine->cachedCodePageCount; i++)
+    AtomicStore(&cache->entries[entryIndex].referenced, true);
+    AtomicStore(&cache->entries[entryIndex].touched, false);
+    if (cache->newest != entryIndex)
     {
-        AspCodePageEntry *entry = engine->cachedCodePages + i;
+        UnlinkEntry(cache, entryIndex);
+        LinkEntry(cache, entryIndex, true);
+    }
+}
 
-        if (i == engine->cachedCodePageIndex)
-            entry->age = 0;
-        else if (entry->age >= 0)
-            entry->age++;
+static void LinkEntry
+    (AspCodePageCache *cache, uint16_t entryIndex, bool newest)
+{
+    AspCodePageEntry *entry = cache->entries + entryIndex;
+    if (newest)
+    {
+        entry->older = cache->newest;
+        entry->newer = NoEntry;
+        if (cache->newest != NoEntry)
+            cache->entries[cache->newest].newer = entryIndex;
+        else
+            cache->oldest = entryIndex;
+        cache->newest = entryIndex;
     }
+    else
+    {
+        entry->newer = cache->oldest;
+        entry->older = NoEntry;
+        if (cache->oldest != NoEntry)
+            cache->entries[cache->oldest].older = entryIndex;
+        else
+            cache->newest = entryIndex;
+        cache->oldest = entryIndex;
+    }
+}
+
+static void UnlinkEntry(AspCodePageCache *cache, uint16_t entryIndex)
+{
+    AspCodePageEntry *entry = cache->entries + entryIndex;
+    if (entry->newer != NoEntry)
+        cache->entries[entry->newer].older = entry->older;
+    else
+        cache->newest = entry->older;
+    if (entry->older != NoEntry)
+        cache->entries[entry->older].newer = entry->newer;
+    else
+        cache->oldest = entry->newer;
+}
+
+static void HashEntry(AspCodePageCache *cache, uint16_t entryIndex)
+{
+    AspCodePageEntry *entry = cache->entries + entryIndex;
+    uint16_t *bucket = cache->buckets + (entry->index & cache->bucketMask);
+    AtomicStore(&entry->chain, *bucket);
+    AtomicStore(bucket, entryIndex);
+}
+
+static void UnhashEntry(AspCodePageCache *cache, uint16_t entryIndex)
+{
+    AspCodePageEntry *entry = cache->entries + entryIndex;
+    uint16_t *link = cache->buckets + (entry->index & cache->bucketMask);
+    while (*link != entryIndex)
+        link = &cache->entries[*link].chain;
+    AtomicStore(link, entry->chain);
+    AtomicStore(&entry->chain, NoEntry);
+}
+
+static bool PinEntry(AspCodePageEntry *entry)
+{
+    /* Pin the entry unless its page is being read. */
+    #ifdef ASP_LOCK_FREE_CODE_PAGES
+    uint16_t pinCount = AtomicLoad(&entry->pinCount);
+    do
+    {
+        if (pinCount == LoadingPinCount)
+            return false;
+    } while (!__atomic_compare_exchange_n
+                (&entry->pinCount, &pinCount, (uint16_t)(pinCount + 1U),
+                 true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+    #else
+    if (entry->pinCount == LoadingPinCount)
+        return false;
+    entry->pinCount++;
+    #endif
+    return true;
+}
+
+static void UnpinEntry(AspCodePageEntry *entry)
+{
+    #ifdef ASP_LOCK_FREE_CODE_PAGES
+    __atomic_fetch_sub(&entry->pinCount, 1U, __ATOMIC_RELEASE);
+    #else
+    entry->pinCount--;
+    #endif
+}
+
+static bool ClaimEntry(AspCodePageEntry *entry)
+{
+    /* Mark an unpinned entry as being read, unless it has been pinned in
+       the meantime. */
+    #ifdef ASP_LOCK_FREE_CODE_PAGES
+    uint16_t pinCount = 0;
+    return __atomic_compare_exchange_n
+        (&entry->pinCount, &pinCount, LoadingPinCount,
+         false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+    #else
+    if (entry->pinCount != 0)
+        return false;
+    entry->pinCount = LoadingPinCount;
+    return true;
+    #endif
+}
+
+static void ReleaseEntry(AspCodePageEntry *entry, uint16_t pinCount)
+{
+    /* Publish the outcome of reading the entry's page. */
+    #ifdef ASP_LOCK_FREE_CODE_PAGES
+    __atomic_store_n(&entry->pinCount, pinCount, __ATOMIC_RELEASE);
+    #else
+    entry->pinCount = pinCount;
+    #endif
+}
+
+static uint16_t EntryPinCount(const AspCodePageEntry *entry)
+{
+    return AtomicLoad(&entry->pinCount);
+}
+
+static void MarkEntry(AspCodePageEntry *entry)
+{
+    /* Record the use of a page without the lock, for the replacement
+       policies to take into account. Avoid needless writes to an entry
+       that other engines may be reading. */
+    if (!AtomicLoad(&entry->referenced))
+        AtomicStore(&entry->referenced, true);
+    if (!AtomicLoad(&entry->touched))
+        AtomicStore(&entry->touched, true);
+}
+
+static void SetCodeEnd(AspCodePageCache *cache, size_t endOffset)
+{
+    if (cache->codeEndKnown && endOffset >= cache->codeEndOffset)
+        return;
+    AtomicStore(&cache->codeEndOffset, endOffset);
+    #ifdef ASP_LOCK_FREE_CODE_PAGES
+    __atomic_store_n(&cache->codeEndKnown, true, __ATOMIC_RELEASE);
+    #else
+    cache->codeEndKnown = true;
+    #endif
+}
+
+static void GetCodeEnd(AspEngine *engine, const AspCodePageCache *cache)
+{
+    #ifdef ASP_LOCK_FREE_CODE_PAGES
+    bool codeEndKnown = __atomic_load_n
+        (&cache->codeEndKnown, __ATOMIC_ACQUIRE);
+    #else
+    bool codeEndKnown = cache->codeEndKnown;
+    #endif
+    if (!codeEndKnown)
+        return;
+    engine->codeEndIndex =
+        AtomicLoad(&cache->codeEndOffset) - engine->headerIndex;
+    engine->codeEndKnown = true;
+}
+
+static void LockCache(const AspCodePageCache *cache, bool lock)
+{
+    if (cache->lock != 0)
+        cache->lock(cache->lockContext, lock);
+}
+
+static void LockLookup(const AspCodePageCache *cache, bool lock)
+{
+    /* Without atomic operations, looking up pages requires the lock. */
+    #ifdef ASP_LOCK_FREE_CODE_PAGES
+    (void)cache;
+    (void)lock;
+    #else
+    LockCache(cache, lock);
+    #endif
 }
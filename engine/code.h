@@ -13,9 +13,18 @@
 extern "C" {
 #endif
 
+AspRunResult AspFetchCodeBytes
+    (AspEngine *, size_t count, uint8_t *buffer, const uint8_t **bytes);
 AspRunResult AspLoadCodeBytes(AspEngine *, uint8_t *bytes, size_t count);
 AspRunResult AspValidateCodeAddress(AspEngine *, uint32_t address);
+AspRunResult AspValidateCodeTarget(AspEngine *, uint32_t address);
+bool AspIsCodePageCached(AspEngine *, uint32_t offset);
 AspRunResult AspLoadCodePage(AspEngine *, uint32_t offset);
+size_t AspCodePageTableSize(uint16_t pageCount);
+void AspInitializeCodePageTable(AspCodePageCache *, void *table);
+void AspClearCodePageTable(AspCodePageCache *);
+bool AspAttachCodePageCache(AspEngine *, AspCodePageCache *);
+void AspDetachCodePageCache(AspEngine *);
 
 #ifdef __cplusplus
 }
@@ -11,7 +11,16 @@
 #include <string.h>
 
 static int CompareFloats(double, double, AspCompareType, bool *nanDetected);
+static AspRunResult CompareStrings
+    (AspEngine *, const AspDataEntry *, const AspDataEntry *, int *result);
 static int CompareIterators(const AspDataEntry *, const AspDataEntry *);
+static AspRunResult HashObject
+    (AspEngine *, const AspDataEntry *, uint32_t *hash);
+static uint32_t HashBytes(uint32_t hash, const void *data, size_t size);
+static uint32_t HashWord(uint32_t hash, uint32_t value);
+
+static const uint32_t HashOffsetBasis = 2166136261U;
+static const uint32_t HashPrime = 16777619U;
 
 AspRunResult AspCompare
     (AspEngine *engine,
@@ -209,27 +218,10 @@ AspRunResult AspCompare
 
                     case DataType_String:
                     {
-                        int32_t
-                            leftCount = AspDataGetSequenceCount(leftEntry),
-                            rightCount = AspDataGetSequenceCount(rightEntry);
-                        int32_t shortCount =
-                            leftCount < rightCount ? leftCount : rightCount;
-                        for (int32_t i = 0; i < shortCount; i++)
-                        {
-                            char
-                                leftChar = AspStringElement
-                                    (engine, leftEntry, i),
-                                rightChar = AspStringElement
-                                    (engine, rightEntry, i);
-                            if (leftChar != rightChar)
-                            {
-                                comparison = leftChar < rightChar ? -1 : 1;
-                                break;
-                            }
-                        }
-                        if (comparison == 0 && leftCount != rightCount)
-                            comparison = leftCount < rightCount ? -1 : 1;
-
+                        AspRunResult compareResult = CompareStrings
+                            (engine, leftEntry, rightEntry, &comparison);
+                        if (compareResult != AspRunResult_OK)
+                            return compareResult;
                         break;
                     }
 
@@ -551,6 +543,54 @@ AspRunResult AspCompare
     return AspRunResult_OK;
 }
 
+AspRunResult AspHashKey
+    (AspEngine *engine, const AspDataEntry *key, uint32_t *result)
+{
+    *result = 0;
+    AspRunResult assertResult = AspAssert
+        (engine, key != 0 && AspIsObject(key));
+    if (assertResult != AspRunResult_OK)
+        return assertResult;
+
+    /* Keys that compare equal as keys must hash alike. A tuple's hash
+       includes its elements, but a nested tuple contributes only its
+       count, which avoids recursion. */
+    uint32_t hash = HashOffsetBasis;
+    AspRunResult hashResult = HashObject(engine, key, &hash);
+    if (hashResult != AspRunResult_OK)
+        return hashResult;
+    if (AspDataGetType(key) == DataType_Tuple)
+    {
+        AspSequenceResult nextResult = AspSequenceNext
+            (engine, key, 0, true);
+        uint32_t iterationCount = 0;
+        for (;
+             iterationCount < engine->cycleDetectionLimit &&
+             nextResult.element != 0;
+             iterationCount++)
+        {
+            hashResult = HashObject(engine, nextResult.value, &hash);
+            if (hashResult != AspRunResult_OK)
+                return hashResult;
+            nextResult = AspSequenceNext
+                (engine, key, nextResult.element, true);
+        }
+        if (iterationCount >= engine->cycleDetectionLimit)
+            return AspRunResult_CycleDetected;
+    }
+
+    /* Mix the bits so that the low-order ones, which select a hash table
+       slot, depend on every byte hashed. */
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6BU;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35U;
+    hash ^= hash >> 16;
+
+    *result = hash;
+    return AspRunResult_OK;
+}
+
 static int CompareFloats
     (double leftValue, double rightValue,
      AspCompareType compareType, bool *nanDetected)
@@ -614,6 +654,69 @@ static int CompareFloats
     }
 }
 
+static AspRunResult CompareStrings
+    (AspEngine *engine,
+     const AspDataEntry *leftEntry, const AspDataEntry *rightEntry,
+     int *result)
+{
+    /* Walk the fragments of both strings in step, comparing characters
+       until a difference is found or the shorter string is exhausted. */
+    *result = 0;
+    AspSequenceResult
+        leftResult = AspSequenceNext(engine, leftEntry, 0, true),
+        rightResult = AspSequenceNext(engine, rightEntry, 0, true);
+    uint32_t leftIndex = 0, rightIndex = 0;
+    uint32_t iterationCount = 0;
+    for (;
+         iterationCount < engine->cycleDetectionLimit &&
+         leftResult.element != 0 && rightResult.element != 0;
+         iterationCount++)
+    {
+        uint32_t
+            leftSize = AspDataGetStringFragmentSize(leftResult.value),
+            rightSize = AspDataGetStringFragmentSize(rightResult.value);
+        const char
+            *leftData = AspDataGetStringFragmentData(leftResult.value),
+            *rightData = AspDataGetStringFragmentData(rightResult.value);
+        for (; leftIndex < leftSize && rightIndex < rightSize;
+             leftIndex++, rightIndex++)
+        {
+            char
+                leftChar = leftData[leftIndex],
+                rightChar = rightData[rightIndex];
+            if (leftChar != rightChar)
+            {
+                *result = leftChar < rightChar ? -1 : 1;
+                return AspRunResult_OK;
+            }
+        }
+
+        /* Advance to the next fragment of either string as required. */
+        if (leftIndex >= leftSize)
+        {
+            leftResult = AspSequenceNext
+                (engine, leftEntry, leftResult.element, true);
+            leftIndex = 0;
+        }
+        if (rightIndex >= rightSize)
+        {
+            rightResult = AspSequenceNext
+                (engine, rightEntry, rightResult.element, true);
+            rightIndex = 0;
+        }
+    }
+    if (iterationCount >= engine->cycleDetectionLimit)
+        return AspRunResult_CycleDetected;
+
+    /* The strings match up to the length of the shorter one. */
+    int32_t
+        leftCount = AspDataGetSequenceCount(leftEntry),
+        rightCount = AspDataGetSequenceCount(rightEntry);
+    if (leftCount != rightCount)
+        *result = leftCount < rightCount ? -1 : 1;
+    return AspRunResult_OK;
+}
+
 static int CompareIterators
     (const AspDataEntry *leftEntry, const AspDataEntry *rightEntry)
 {
@@ -626,3 +729,140 @@ static int CompareIterators
         AspDataGetIteratorStringIndex(rightEntry) ?
         0 : 1;
 }
+
+static AspRunResult HashObject
+    (AspEngine *engine, const AspDataEntry *entry, uint32_t *hash)
+{
+    DataType type = (DataType)AspDataGetType(entry);
+    *hash = HashWord(*hash, type);
+    switch (type)
+    {
+        default:
+            return AspRunResult_UnexpectedType;
+
+        case DataType_None:
+        case DataType_Ellipsis:
+            break;
+
+        case DataType_Boolean:
+            *hash = HashWord(*hash, AspDataGetBoolean(entry));
+            break;
+
+        case DataType_Integer:
+            *hash = HashWord(*hash, (uint32_t)AspDataGetInteger(entry));
+            break;
+
+        case DataType_Float:
+        {
+            /* Negative zero compares equal to zero, so hash it as zero.
+               NaNs compare by bit pattern, so hash them as they are. */
+            double value = AspDataGetFloat(entry);
+            if (value == 0.0)
+                value = 0.0;
+            *hash = HashBytes(*hash, &value, sizeof value);
+            break;
+        }
+
+        case DataType_Symbol:
+            *hash = HashWord(*hash, (uint32_t)AspDataGetSymbol(entry));
+            break;
+
+        case DataType_Range:
+        {
+            int32_t start, end, step;
+            bool bounded;
+            AspGetRange(engine, entry, &start, &end, &step, &bounded);
+            *hash = HashWord(*hash, (uint32_t)start);
+            *hash = HashWord(*hash, (uint32_t)end);
+            *hash = HashWord(*hash, (uint32_t)step);
+            *hash = HashWord(*hash, bounded);
+            break;
+        }
+
+        case DataType_String:
+        {
+            AspSequenceResult nextResult = AspSequenceNext
+                (engine, entry, 0, true);
+            uint32_t iterationCount = 0;
+            for (;
+                 iterationCount < engine->cycleDetectionLimit &&
+                 nextResult.element != 0;
+                 iterationCount++)
+            {
+                *hash = HashBytes
+                    (*hash,
+                     AspDataGetStringFragmentData(nextResult.value),
+                     AspDataGetStringFragmentSize(nextResult.value));
+                nextResult = AspSequenceNext
+                    (engine, entry, nextResult.element, true);
+            }
+            if (iterationCount >= engine->cycleDetectionLimit)
+                return AspRunResult_CycleDetected;
+            break;
+        }
+
+        case DataType_Tuple:
+            *hash = HashWord
+                (*hash, (uint32_t)AspDataGetSequenceCount(entry));
+            break;
+
+        case DataType_Function:
+        {
+            bool isApp = AspDataGetFunctionIsApp(entry);
+            *hash = HashWord(*hash, isApp);
+            *hash = HashWord
+                (*hash, isApp ?
+                 (uint32_t)AspDataGetFunctionSymbol(entry) :
+                 AspDataGetFunctionCodeAddress(entry));
+            break;
+        }
+
+        case DataType_Module:
+            *hash = HashWord(*hash, AspDataGetModuleCodeAddress(entry));
+            break;
+
+        case DataType_AppIntegerObject:
+            *hash = HashWord
+                (*hash, (uint32_t)AspDataGetAppObjectType(entry));
+            *hash = HashWord
+                (*hash, (uint32_t)AspDataGetAppIntegerObjectValue(entry));
+            break;
+
+        case DataType_AppPointerObject:
+        {
+            const void *value = AspDataGetAppPointerObjectValue(entry);
+            *hash = HashWord
+                (*hash, (uint32_t)AspDataGetAppObjectType(entry));
+            *hash = HashBytes(*hash, &value, sizeof value);
+            break;
+        }
+
+        case DataType_Type:
+            *hash = HashWord(*hash, AspDataGetTypeValue(entry));
+            break;
+    }
+
+    return AspRunResult_OK;
+}
+
+static uint32_t HashBytes(uint32_t hash, const void *data, size_t size)
+{
+    /* FNV-1a. */
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= HashPrime;
+    }
+    return hash;
+}
+
+static uint32_t HashWord(uint32_t hash, uint32_t value)
+{
+    for (unsigned i = 0; i < 4; i++, value >>= 8)
+    {
+        hash ^= value & 0xFFU;
+        hash *= HashPrime;
+    }
+    return hash;
+}
@@ -8,6 +8,7 @@
 #include "asp-priv.h"
 #include "data.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -25,6 +26,8 @@ AspRunResult AspCompare
     (AspEngine *engine,
      const AspDataEntry *left, const AspDataEntry *right,
      AspCompareType, int *result, bool *nanDetected);
+AspRunResult AspHashKey
+    (AspEngine *, const AspDataEntry *key, uint32_t *result);
 
 #ifdef __cplusplus
 }
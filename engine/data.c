@@ -10,6 +10,106 @@
 
 static bool IsSimpleImmutableObject(const AspDataEntry *);
 
+/* Data types and their names, in order of type code. Live entries of each
+   type are counted in the slot given by DataTypeSlots, which must be kept
+   consistent with this table: the slot of each type is one more than its
+   position here. */
+typedef struct
+{
+    DataType type;
+    const char *name;
+} DataTypeInfo;
+static const DataTypeInfo DataTypeInfos[ASP_DATA_TYPE_SLOT_COUNT - 1] =
+{
+    /* Objects. */
+    {DataType_None, "None"},
+    {DataType_Ellipsis, "..."},
+    {DataType_Boolean, "bool"},
+    {DataType_Integer, "int"},
+    {DataType_Float, "float"},
+    /* {DataType_Complex, "cmplx"}, */
+    {DataType_Symbol, "sym"},
+    {DataType_Range, "range"},
+    {DataType_String, "str"},
+    {DataType_Tuple, "tuple"},
+    {DataType_List, "list"},
+    {DataType_Set, "set"},
+    {DataType_Dictionary, "dict"},
+    {DataType_Function, "func"},
+    {DataType_Module, "mod"},
+    {DataType_ReverseIterator, "iter-rev"},
+    {DataType_ForwardIterator, "iter"},
+    {DataType_AppIntegerObject, "app-int"},
+    {DataType_AppPointerObject, "app-ptr"},
+    {DataType_Type, "type"},
+
+    /* Support types. */
+    {DataType_CodeAddress, "caddr"},
+    {DataType_StackEntry, "stkent"},
+    {DataType_Frame, "frame"},
+    {DataType_AppFrame, "appframe"},
+    {DataType_Element, "elem"},
+    {DataType_ElementChunk, "elemchk"},
+    {DataType_StringFragment, "strfrag"},
+    {DataType_KeyValuePair, "kvp"},
+    {DataType_Namespace, "ns"},
+    {DataType_SetNode, "snode"},
+    {DataType_DictionaryNode, "dnode"},
+    {DataType_NamespaceNode, "nsnode"},
+    {DataType_TreeLinksNode, "lrnode"},
+    {DataType_TreeHashChunk, "hashchk"},
+    {DataType_Parameter, "parm"},
+    {DataType_ParameterList, "parms"},
+    {DataType_Argument, "arg"},
+    {DataType_ArgumentList, "args"},
+    {DataType_AppIntegerObjectInfo, "app-ii"},
+    {DataType_AppPointerObjectInfo, "app-pi"},
+    {DataType_Free, "free"},
+};
+static const uint8_t DataTypeSlots[256] =
+{
+    [DataType_None] = 1,
+    [DataType_Ellipsis] = 2,
+    [DataType_Boolean] = 3,
+    [DataType_Integer] = 4,
+    [DataType_Float] = 5,
+    [DataType_Symbol] = 6,
+    [DataType_Range] = 7,
+    [DataType_String] = 8,
+    [DataType_Tuple] = 9,
+    [DataType_List] = 10,
+    [DataType_Set] = 11,
+    [DataType_Dictionary] = 12,
+    [DataType_Function] = 13,
+    [DataType_Module] = 14,
+    [DataType_ReverseIterator] = 15,
+    [DataType_ForwardIterator] = 16,
+    [DataType_AppIntegerObject] = 17,
+    [DataType_AppPointerObject] = 18,
+    [DataType_Type] = 19,
+    [DataType_CodeAddress] = 20,
+    [DataType_StackEntry] = 21,
+    [DataType_Frame] = 22,
+    [DataType_AppFrame] = 23,
+    [DataType_Element] = 24,
+    [DataType_ElementChunk] = 25,
+    [DataType_StringFragment] = 26,
+    [DataType_KeyValuePair] = 27,
+    [DataType_Namespace] = 28,
+    [DataType_SetNode] = 29,
+    [DataType_DictionaryNode] = 30,
+    [DataType_NamespaceNode] = 31,
+    [DataType_TreeLinksNode] = 32,
+    [DataType_TreeHashChunk] = 33,
+    [DataType_Parameter] = 34,
+    [DataType_ParameterList] = 35,
+    [DataType_Argument] = 36,
+    [DataType_ArgumentList] = 37,
+    [DataType_AppIntegerObjectInfo] = 38,
+    [DataType_AppPointerObjectInfo] = 39,
+    [DataType_Free] = 40,
+};
+
 void AspDataSetWord3(AspDataEntry *entry, uint32_t value)
 {
     entry->s.s[11] = (uint8_t)AspBitGetField(value, 0, 8);
@@ -48,49 +148,81 @@ size_t AspDataEntrySize(void)
 
 void AspClearData(AspEngine *engine)
 {
-    /* Clear data storage, setting every element to a free entry. */
+    /* Clear data storage by emptying the free list and moving the watermark
+       back to the start, making every entry implicitly free. No entries are
+       touched; each is initialized when it is next allocated. */
     engine->freeListIndex = 0;
-    AspDataEntry *data = engine->data;
-    for (unsigned i = 0; i < engine->dataEndIndex; i++)
-    {
-        memset(data + i, 0, sizeof *data);
-        AspDataSetType(data + i, DataType_Free);
-        AspDataSetFreeNext(data + i, i + 1);
-    }
-    if (engine->dataEndIndex != 0)
-        AspDataSetFreeNext(data + engine->dataEndIndex - 1, 0);
+    engine->dataWatermark = 0;
     engine->lowFreeCount = engine->freeCount = engine->dataEndIndex;
+    memset(engine->dataTypeCounts, 0, sizeof engine->dataTypeCounts);
+
+    /* Forget any cached sequence positions. */
+    memset(engine->sequenceIndexCache, 0, sizeof engine->sequenceIndexCache);
+    engine->sequenceIndexCacheNext = 0;
+    engine->chunkIndexCandidateIndex = 0;
+    engine->chunkIndexTraversalCount = 0;
+    engine->localSlotCount = 0;
+    memset(engine->loadCache, 0, sizeof engine->loadCache);
+    engine->namespaceGeneration = 0;
+    memset(engine->characterStrings, 0, sizeof engine->characterStrings);
+    memset
+        (engine->stringLiteralCache, 0, sizeof engine->stringLiteralCache);
 }
 
 uint32_t AspAlloc(AspEngine *engine)
 {
+    /* Give up the engine's shared strings before declaring that memory is
+       exhausted. */
+    if (engine->freeCount == 0)
+        AspReleaseSharedStrings(engine);
     if (engine->freeCount == 0)
     {
         engine->runResult = AspRunResult_OutOfDataMemory;
         return 0;
     }
 
+    /* Reuse a freed entry if there is one. Otherwise, take the first entry
+       beyond the watermark. Note that a zero free list index indicates an
+       empty list, as the entry at index zero (the None singleton) is never
+       freed. */
     AspDataEntry *data = engine->data;
     uint32_t index = engine->freeListIndex;
+    if (index != 0)
+    {
+        AspRunResult assertResult = AspAssert
+            (engine, AspDataGetType(data + index) == DataType_Free);
+        if (assertResult != AspRunResult_OK)
+            return 0;
+        engine->freeListIndex = AspDataGetFreeNext(data + index);
+    }
+    else
+    {
+        AspRunResult assertResult = AspAssert
+            (engine, engine->dataWatermark < engine->dataEndIndex);
+        if (assertResult != AspRunResult_OK)
+            return 0;
+        index = engine->dataWatermark++;
+    }
 
-    AspRunResult assertResult = AspAssert
-        (engine, AspDataGetType(data + index) == DataType_Free);
-    if (assertResult != AspRunResult_OK)
-        return 0;
-
-    engine->freeListIndex = AspDataGetFreeNext(data + index);
     engine->freeCount--;
     if (engine->freeCount < engine->lowFreeCount)
         engine->lowFreeCount = engine->freeCount;
     memset(data + index, 0, sizeof *data);
     AspDataSetType(data + index, DataType_None);
+    engine->dataTypeCounts[DataTypeSlots[DataType_None]]++;
+
+    #ifdef ASP_OPCODE_PROFILE
+    if (engine->profile != 0 && engine->state == AspEngineState_Running)
+        engine->profile->allocationCounts[engine->profileOpCode]++;
+    #endif
+
     return index;
 }
 
 bool AspFree(AspEngine *engine, uint32_t index)
 {
     AspRunResult assertResult = AspAssert
-        (engine, index < engine->dataEndIndex);
+        (engine, index != 0 && index < engine->dataWatermark);
     if (assertResult != AspRunResult_OK)
         return false;
     AspDataEntry *data = engine->data;
@@ -99,6 +231,7 @@ bool AspFree(AspEngine *engine, uint32_t index)
     if (assertResult != AspRunResult_OK)
         return false;
 
+    engine->dataTypeCounts[DataTypeSlots[AspDataGetType(data + index)]]--;
     memset(data + index, 0, sizeof *data);
     AspDataSetType(data + index, DataType_Free);
     AspDataSetFreeNext(data + index, engine->freeListIndex);
@@ -214,11 +347,30 @@ AspDataEntry *AspAllocEntry(AspEngine *engine, DataType type)
     if (index == 0)
         return 0;
     AspDataEntry *entry = engine->data + index;
-    AspDataSetType(entry, type);
+    AspSetEntryType(engine, entry, type);
     AspRef(engine, entry);
     return entry;
 }
 
+void AspSetEntryType(AspEngine *engine, AspDataEntry *entry, DataType type)
+{
+    engine->dataTypeCounts[DataTypeSlots[AspDataGetType(entry)]]--;
+    AspDataSetType(entry, type);
+    engine->dataTypeCounts[DataTypeSlots[type]]++;
+}
+
+void AspCountDataTypes(const AspEngine *engine, uint32_t *counts)
+{
+    for (unsigned slot = 1; slot < ASP_DATA_TYPE_SLOT_COUNT; slot++)
+        counts[DataTypeInfos[slot - 1].type] = engine->dataTypeCounts[slot];
+}
+
+const char *AspDataTypeName(uint8_t type)
+{
+    uint8_t slot = DataTypeSlots[type];
+    return slot == 0 ? 0 : DataTypeInfos[slot - 1].name;
+}
+
 AspDataEntry *AspEntry(AspEngine *engine, uint32_t index)
 {
     /* Zero means a null reference (for lists, trees, etc.). */
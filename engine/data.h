@@ -48,6 +48,7 @@ typedef enum
     DataType_Frame = 0x52,
     DataType_AppFrame = 0x54,
     DataType_Element = 0x62,
+    DataType_ElementChunk = 0x63,
     DataType_StringFragment = 0x64,
     DataType_KeyValuePair = 0x66,
     DataType_Namespace = 0x70,
@@ -55,6 +56,7 @@ typedef enum
     DataType_DictionaryNode = 0x78,
     DataType_NamespaceNode = 0x7C,
     DataType_TreeLinksNode = 0x7D,
+    DataType_TreeHashChunk = 0x7E,
     DataType_Parameter = 0x80,
     DataType_ParameterList = 0x81,
     DataType_Argument = 0x82,
@@ -243,6 +245,26 @@ int32_t AspDataGetSignedWord3(const AspDataEntry *);
 #define AspDataGetTreeRootIndex(eptr) \
     (AspDataGetWord1((eptr)))
 
+/* Set and Dictionary entry field access. */
+#define AspDataSetTreeHashIndex(eptr, value) \
+    (AspDataSetWord3((eptr), (value)))
+#define AspDataGetTreeHashIndex(eptr) \
+    (AspDataGetWord3((eptr)))
+
+/* Namespace entry field access. */
+#define AspDataSetNamespaceIsLocal(eptr, value) \
+    (AspDataSetBit0((eptr), (unsigned)(value)))
+#define AspDataGetNamespaceIsLocal(eptr) \
+    ((bool)(AspDataGetBit0((eptr))))
+#define AspDataSetNamespaceSlotBase(eptr, value) \
+    (AspDataSetWord2((eptr), (value)))
+#define AspDataGetNamespaceSlotBase(eptr) \
+    (AspDataGetWord2((eptr)))
+#define AspDataSetNamespaceSlotCount(eptr, value) \
+    (AspDataSetWord3((eptr), (value)))
+#define AspDataGetNamespaceSlotCount(eptr) \
+    (AspDataGetWord3((eptr)))
+
 /* Iterator entry field access. */
 #define AspDataSetIteratorIterableIndex(eptr, value) \
     (AspDataSetWord0((eptr), (value)))
@@ -409,6 +431,30 @@ int32_t AspDataGetSignedWord3(const AspDataEntry *);
     (AspDataSetWord2((eptr), (value)))
 #define AspDataGetElementValueIndex(eptr) \
     (AspDataGetWord2((eptr)))
+#define AspDataSetElementChunkIndex(eptr, value) \
+    (AspDataSetWord3((eptr), (value)))
+#define AspDataGetElementChunkIndex(eptr) \
+    (AspDataGetWord3((eptr)))
+
+/* ElementChunk entry field access. */
+#define AspDataGetElementChunkCapacity() 4U
+#define AspDataSetElementChunkLevel(eptr, value) \
+    (AspBitSetField \
+        (&(eptr)->w.u.u.u0, (AspWordBitSize), 32U - (AspWordBitSize), \
+         (value)))
+#define AspDataGetElementChunkLevel(eptr) \
+    (AspBitGetField \
+        ((eptr)->w.u.u.u0, (AspWordBitSize), 32U - (AspWordBitSize)))
+#define AspDataSetElementChunkSlotIndex(eptr, slot, value) \
+    ((slot) == 0 ? AspDataSetWord0((eptr), (value)) : \
+     (slot) == 1 ? AspDataSetWord1((eptr), (value)) : \
+     (slot) == 2 ? AspDataSetWord2((eptr), (value)) : \
+     AspDataSetWord3((eptr), (value)))
+#define AspDataGetElementChunkSlotIndex(eptr, slot) \
+    ((slot) == 0 ? AspDataGetWord0((eptr)) : \
+     (slot) == 1 ? AspDataGetWord1((eptr)) : \
+     (slot) == 2 ? AspDataGetWord2((eptr)) : \
+     AspDataGetWord3((eptr)))
 
 /* StringFragment entry field access. */
 #define AspDataGetStringFragmentMaxSize() \
@@ -492,6 +538,45 @@ int32_t AspDataGetSignedWord3(const AspDataEntry *);
 #define AspDataGetTreeLinksNodeRightIndex(eptr) \
     (AspDataGetWord2((eptr)))
 
+/* TreeHashChunk entry field access. A level zero chunk holds two hash
+   table slots, each pairing a node with the hash of its key. Other chunks
+   hold up to four lower level chunks. */
+#define AspDataGetTreeHashChunkCapacity() 4U
+#define AspDataGetTreeHashChunkSlotCapacity() 2U
+#define AspDataSetTreeHashChunkLevel(eptr, value) \
+    (AspBitSetField \
+        (&(eptr)->w.u.u.u0, (AspWordBitSize), 32U - (AspWordBitSize), \
+         (value)))
+#define AspDataGetTreeHashChunkLevel(eptr) \
+    (AspBitGetField \
+        ((eptr)->w.u.u.u0, (AspWordBitSize), 32U - (AspWordBitSize)))
+#define AspDataSetTreeHashChunkIsHalf(eptr, value) \
+    (AspDataSetBit0((eptr), (unsigned)(value)))
+#define AspDataGetTreeHashChunkIsHalf(eptr) \
+    ((bool)(AspDataGetBit0((eptr))))
+#define AspDataSetTreeHashChunkChildIndex(eptr, slot, value) \
+    ((slot) == 0 ? AspDataSetWord0((eptr), (value)) : \
+     (slot) == 1 ? AspDataSetWord1((eptr), (value)) : \
+     (slot) == 2 ? AspDataSetWord2((eptr), (value)) : \
+     AspDataSetWord3((eptr), (value)))
+#define AspDataGetTreeHashChunkChildIndex(eptr, slot) \
+    ((slot) == 0 ? AspDataGetWord0((eptr)) : \
+     (slot) == 1 ? AspDataGetWord1((eptr)) : \
+     (slot) == 2 ? AspDataGetWord2((eptr)) : \
+     AspDataGetWord3((eptr)))
+#define AspDataSetTreeHashChunkNodeIndex(eptr, slot, value) \
+    ((slot) == 0 ? AspDataSetWord0((eptr), (value)) : \
+     AspDataSetWord2((eptr), (value)))
+#define AspDataGetTreeHashChunkNodeIndex(eptr, slot) \
+    ((slot) == 0 ? AspDataGetWord0((eptr)) : \
+     AspDataGetWord2((eptr)))
+#define AspDataSetTreeHashChunkHash(eptr, slot, value) \
+    ((slot) == 0 ? AspDataSetWord1((eptr), (value)) : \
+     AspDataSetWord3((eptr), (value)))
+#define AspDataGetTreeHashChunkHash(eptr, slot) \
+    ((slot) == 0 ? AspDataGetWord1((eptr)) : \
+     AspDataGetWord3((eptr)))
+
 /* Parameter entry field access. */
 #define AspDataSetParameterSymbol(eptr, value) \
     (AspDataSetSignedWord0((eptr), (value)))
@@ -550,6 +635,8 @@ bool AspIsObject(const AspDataEntry *);
 AspRunResult AspCheckIsImmutableObject
     (AspEngine *, const AspDataEntry *, bool *isImmutable);
 AspDataEntry *AspAllocEntry(AspEngine *, DataType);
+void AspSetEntryType(AspEngine *, AspDataEntry *, DataType);
+void AspCountDataTypes(const AspEngine *, uint32_t *counts);
 AspDataEntry *AspEntry(AspEngine *, uint32_t index);
 AspDataEntry *AspValueEntry(AspEngine *, uint32_t index);
 uint32_t AspIndex(const AspEngine *, const AspDataEntry *);
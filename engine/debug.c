@@ -32,6 +32,9 @@ void AspDump(const AspEngine *engine, FILE *fp)
     fprintf
         (fp, "Free count low water mark: %zd\n",
          engine->lowFreeCount);
+    fprintf
+        (fp, "Data watermark: 0x%07X\n",
+         (unsigned)engine->dataWatermark);
 
     fprintf(fp, "Stack: ");
     if (engine->stackTop == 0)
@@ -67,7 +70,9 @@ static void DumpData(const AspEngine *engine, FILE *fp)
     unsigned freeRangeStart = 0;
     for (unsigned i = 0; i < engine->dataEndIndex; i++)
     {
-        uint8_t t = AspDataGetType(data + i);
+        uint8_t t =
+            i < engine->dataWatermark ?
+            AspDataGetType(data + i) : (uint8_t)DataType_Free;
         if (inFree)
         {
             if (t != DataType_Free)
@@ -100,77 +105,13 @@ static void DumpData(const AspEngine *engine, FILE *fp)
     }
 }
 
-typedef struct
-{
-    DataType type;
-    const char *name;
-} TypeName;
-static TypeName gTypeNames[] =
-{
-    /* Objects. */
-    {DataType_None, "None"},
-    {DataType_Ellipsis, "..."},
-    {DataType_Boolean, "bool"},
-    {DataType_Integer, "int"},
-    {DataType_Float, "float"},
-    /* {DataType_Complex, "cmplx"}, */
-    {DataType_Symbol, "sym"},
-    {DataType_Range, "range"},
-    {DataType_String, "str"},
-    {DataType_Tuple, "tuple"},
-    {DataType_List, "list"},
-    {DataType_Set, "set"},
-    {DataType_Dictionary, "dict"},
-    {DataType_Function, "func"},
-    {DataType_Module, "mod"},
-    {DataType_ReverseIterator, "iter-rev"},
-    {DataType_ForwardIterator, "iter"},
-    {DataType_AppIntegerObject, "app-int"},
-    {DataType_AppPointerObject, "app-ptr"},
-    {DataType_Type, "type"},
-
-    /* Support types. */
-    {DataType_CodeAddress, "caddr"},
-    {DataType_StackEntry, "stkent"},
-    {DataType_Frame, "frame"},
-    {DataType_AppFrame, "appframe"},
-    {DataType_Element, "elem"},
-    {DataType_StringFragment, "strfrag"},
-    {DataType_KeyValuePair, "kvp"},
-    {DataType_Namespace, "ns"},
-    {DataType_SetNode, "snode"},
-    {DataType_DictionaryNode, "dnode"},
-    {DataType_NamespaceNode, "nsnode"},
-    {DataType_TreeLinksNode, "lrnode"},
-    {DataType_Parameter, "parm"},
-    {DataType_ParameterList, "parms"},
-    {DataType_Argument, "arg"},
-    {DataType_ArgumentList, "args"},
-    {DataType_AppIntegerObjectInfo, "app-ii"},
-    {DataType_AppPointerObjectInfo, "app-pi"},
-    {DataType_Free, "free"},
-};
-
-static int CompareTypeNames(const void *key, const void *element)
-{
-    const TypeName *typeNameKey = key;
-    const TypeName *typeNameElement = element;
-    return
-        (int)typeNameKey->type == (int)typeNameElement->type ? 0 :
-        (int)typeNameKey->type < (int)typeNameElement->type ? -1 : 1;
-}
-
 static void DumpDataEntry(uint32_t index, const AspDataEntry *entry, FILE *fp)
 {
     uint8_t t = AspDataGetType(entry);
     fprintf(fp, "0x%07X: t=0x%02X", index, t);
-    TypeName keyTypeName = {t, ""};
-    const TypeName *nameEntry = (TypeName *)bsearch
-        (&keyTypeName, gTypeNames,
-         sizeof gTypeNames / sizeof *gTypeNames, sizeof *gTypeNames,
-         CompareTypeNames);
-    if (nameEntry != 0)
-        fprintf(fp, "(%s)", nameEntry->name);
+    const char *name = AspDataTypeName(t);
+    if (name != 0)
+        fprintf(fp, "(%s)", name);
     if (AspIsObject(entry))
         fprintf(fp, " use=%d", AspDataGetUseCount(entry));
     switch (t)
@@ -212,10 +153,21 @@ static void DumpDataEntry(uint32_t index, const AspDataEntry *entry, FILE *fp)
 
         case DataType_Set:
         case DataType_Dictionary:
-        case DataType_Namespace:
             fprintf(fp, " count=%u root=0x%07X",
                 AspDataGetTreeCount(entry),
                 AspDataGetTreeRootIndex(entry));
+            if (AspDataGetTreeHashIndex(entry) != 0)
+                fprintf(fp, " hash=0x%07X",
+                    AspDataGetTreeHashIndex(entry));
+            break;
+
+        case DataType_Namespace:
+            fprintf(fp, " count=%u root=0x%07X slots=%u+%u loc=%d",
+                AspDataGetTreeCount(entry),
+                AspDataGetTreeRootIndex(entry),
+                AspDataGetNamespaceSlotBase(entry),
+                AspDataGetNamespaceSlotCount(entry),
+                AspDataGetNamespaceIsLocal(entry));
             break;
 
         case DataType_ForwardIterator:
@@ -323,6 +275,18 @@ static void DumpDataEntry(uint32_t index, const AspDataEntry *entry, FILE *fp)
                 AspDataGetElementPreviousIndex(entry),
                 AspDataGetElementNextIndex(entry),
                 AspDataGetElementValueIndex(entry));
+            if (AspDataGetElementChunkIndex(entry) != 0)
+                fprintf(fp, " chunk=0x%07X",
+                    AspDataGetElementChunkIndex(entry));
+            break;
+
+        case DataType_ElementChunk:
+            fprintf(fp, " lvl=%u s0=0x%07X s1=0x%07X s2=0x%07X s3=0x%07X",
+                AspDataGetElementChunkLevel(entry),
+                AspDataGetElementChunkSlotIndex(entry, 0),
+                AspDataGetElementChunkSlotIndex(entry, 1),
+                AspDataGetElementChunkSlotIndex(entry, 2),
+                AspDataGetElementChunkSlotIndex(entry, 3));
             break;
 
         case DataType_StringFragment:
@@ -387,6 +351,24 @@ static void DumpDataEntry(uint32_t index, const AspDataEntry *entry, FILE *fp)
                 AspDataGetTreeLinksNodeRightIndex(entry));
             break;
 
+        case DataType_TreeHashChunk:
+            if (AspDataGetTreeHashChunkLevel(entry) == 0)
+                fprintf(fp, " lvl=0 n0=0x%07X h0=0x%07X n1=0x%07X h1=0x%07X",
+                    AspDataGetTreeHashChunkNodeIndex(entry, 0),
+                    AspDataGetTreeHashChunkHash(entry, 0),
+                    AspDataGetTreeHashChunkNodeIndex(entry, 1),
+                    AspDataGetTreeHashChunkHash(entry, 1));
+            else
+                fprintf(fp,
+                    " lvl=%u s0=0x%07X s1=0x%07X s2=0x%07X s3=0x%07X half=%d",
+                    AspDataGetTreeHashChunkLevel(entry),
+                    AspDataGetTreeHashChunkChildIndex(entry, 0),
+                    AspDataGetTreeHashChunkChildIndex(entry, 1),
+                    AspDataGetTreeHashChunkChildIndex(entry, 2),
+                    AspDataGetTreeHashChunkChildIndex(entry, 3),
+                    AspDataGetTreeHashChunkIsHalf(entry));
+            break;
+
         case DataType_Parameter:
             fprintf(fp, " s=%u", AspDataGetParameterSymbol(entry));
             if (AspDataGetParameterHasDefault(entry))
@@ -56,26 +56,42 @@ AspRunResult AspInitializeEx
     engine->floatConverter = floatConverter;
     engine->codeArea = code;
     engine->maxCodeSize = codeSize;
-    engine->cachedCodePageCount = 0;
+    memset
+        (&engine->ownCodePageCache, 0, sizeof engine->ownCodePageCache);
+    engine->codePageCache = 0;
+    engine->codePagePinned = false;
+    engine->codePageEntryIndex = 0;
+    engine->codePage = 0;
+    engine->codePageOffset = 0;
     engine->codePageSize = 0;
-    engine->cachedCodePages = 0;
-    engine->codeReader = 0;
+    engine->codePrefetcher = 0;
+    engine->codeReadAheadOffset = 0;
     engine->data = data;
     engine->maxDataSize = dataSize;
     engine->dataEndIndex = dataSize / AspDataEntrySize();
     engine->cycleDetectionLimit = (uint32_t)(engine->dataEndIndex / 2);
     engine->appSpec = appSpec;
     engine->inApp = false;
+    engine->deadlineChecker = 0;
+    engine->deadlineCheckerContext = 0;
+    engine->deadlineCheckInterval = 0;
 
     #ifdef ASP_DEBUG
     engine->traceFile = stdout;
     #endif
 
+    #ifdef ASP_OPCODE_PROFILE
+    engine->opCodeProfiler = 0;
+    engine->opCodeProfilerContext = 0;
+    engine->profile = 0;
+    engine->profileOpCode = 0;
+    #endif
+
     return AspReset(engine);
 }
 
 AspRunResult AspSetCodePaging
-    (AspEngine *engine, uint8_t pageCount, size_t pageSize,
+    (AspEngine *engine, uint16_t pageCount, size_t pageSize,
      AspCodeReader reader)
 {
     if (engine->inApp || engine->state != AspEngineState_Reset)
@@ -83,7 +99,9 @@ AspRunResult AspSetCodePaging
 
     if (pageCount != 0 && (pageSize < HeaderSize || reader == 0))
         return AspRunResult_ValueOutOfRange;
-    if (engine->state != AspEngineState_Reset)
+    if (engine->state != AspEngineState_Reset ||
+        (engine->codePageCache != 0 &&
+         engine->codePageCache != &engine->ownCodePageCache))
         return AspRunResult_InvalidState;
     if (engine->codeArea == 0)
         return AspRunResult_InitializationError;
@@ -93,17 +111,27 @@ AspRunResult AspSetCodePaging
     size_t requiredSize = pageCount * pageSize;
     if (requiredSize > engine->maxCodeSize)
         return AspRunResult_InitializationError;
-    size_t pageEntriesSize = pageCount * sizeof(AspCodePageEntry);
-    if (pageEntriesSize >= engine->maxDataSize)
+    size_t tableSize = pageCount == 0 ? 0 : AspCodePageTableSize(pageCount);
+    if (tableSize >= engine->maxDataSize)
         return AspRunResult_OutOfDataMemory;
 
+    /* Detach from the engine's own cache before changing it. The page
+       table occupies whole data entries at the end of the data area, which
+       keeps it suitably aligned. */
+    AspDetachCodePageCache(engine);
     engine->dataEndIndex =
-        (engine->maxDataSize - pageEntriesSize) / AspDataEntrySize();
-    engine->cachedCodePageCount = pageCount;
-    engine->codePageSize = pageSize;
-    engine->codeReader = reader;
-    engine->cachedCodePages = (AspCodePageEntry *)(pageCount == 0 ? 0 :
-        (uint8_t *)engine->data + engine->maxDataSize - pageEntriesSize);
+        (engine->maxDataSize - tableSize) / AspDataEntrySize();
+    AspCodePageCache *cache = &engine->ownCodePageCache;
+    memset(cache, 0, sizeof *cache);
+    if (pageCount != 0)
+    {
+        cache->pages = engine->codeArea;
+        cache->pageCount = pageCount;
+        cache->policy = AspCodePagePolicy_LRU;
+        cache->pageSize = pageSize;
+        cache->reader = reader;
+        AspInitializeCodePageTable(cache, engine->data + engine->dataEndIndex);
+    }
 
     return AspReset(engine);
 }
@@ -168,6 +196,7 @@ AspAddCodeResult AspAddCode
     {
         engine->state = AspEngineState_LoadError;
         engine->loadResult = AspAddCodeResult_InvalidState;
+        return engine->loadResult;
     }
 
     /* Ensure there's enough room to copy the code. */
@@ -175,6 +204,7 @@ AspAddCodeResult AspAddCode
     {
         engine->state = AspEngineState_LoadError;
         engine->loadResult = AspAddCodeResult_OutOfCodeMemory;
+        return engine->loadResult;
     }
 
     memcpy(engine->code + engine->codeEndIndex, codePtr, codeSize);
@@ -230,17 +260,18 @@ AspAddCodeResult AspSealCode
 AspAddCodeResult AspPageCode(AspEngine *engine, void *id)
 {
     if (engine->state != AspEngineState_Reset ||
-        engine->codeArea == 0 || engine->cachedCodePageCount == 0)
+        engine->codeArea == 0 ||
+        engine->codePageCache != &engine->ownCodePageCache)
         return AspAddCodeResult_InvalidState;
 
     /* Load the first page, which contains the header, and then ensure the
        header is valid. */
-    engine->pagedCodeId = id;
+    engine->ownCodePageCache.id = id;
     engine->headerIndex = HeaderSize;
     AspRunResult pageResult = AspLoadCodePage(engine, 0);
     if (pageResult != AspRunResult_OK)
         return AspAddCodeResult_InvalidFormat;
-    engine->code = engine->codeArea;
+    engine->code = engine->codePage;
     ProcessCodeHeader(engine);
     if (engine->loadResult != AspAddCodeResult_OK)
         return engine->loadResult;
@@ -251,11 +282,103 @@ AspAddCodeResult AspPageCode(AspEngine *engine, void *id)
     return engine->loadResult = AspAddCodeResult_OK;
 }
 
+size_t AspCodePageCacheSize(uint16_t pageCount, size_t pageSize)
+{
+    return AspCodePageTableSize(pageCount) + pageCount * pageSize;
+}
+
+AspRunResult AspInitializeCodePageCache
+    (AspCodePageCache *cache, void *pages, size_t pagesSize,
+     uint16_t pageCount, size_t pageSize, AspCodeReader reader, void *id,
+     AspCodePageCacheLock lock, void *lockContext)
+{
+    if (pageCount == 0 || pageSize < HeaderSize || reader == 0)
+        return AspRunResult_ValueOutOfRange;
+    if (pages == 0 || pagesSize < AspCodePageCacheSize(pageCount, pageSize))
+        return AspRunResult_InitializationError;
+
+    /* The page table precedes the pages themselves, so that it has the
+       alignment of the memory provided. */
+    cache->pages = (uint8_t *)pages + AspCodePageTableSize(pageCount);
+    cache->pageCount = pageCount;
+    cache->policy = AspCodePagePolicy_LRU;
+    cache->pageSize = pageSize;
+    cache->reader = reader;
+    cache->id = id;
+    cache->lock = lock;
+    cache->lockContext = lockContext;
+    AspInitializeCodePageTable(cache, pages);
+
+    return AspRunResult_OK;
+}
+
+AspAddCodeResult AspShareCodePages
+    (AspEngine *engine, AspCodePageCache *cache)
+{
+    if (engine->state != AspEngineState_Reset ||
+        engine->codePageCache != 0)
+        return AspAddCodeResult_InvalidState;
+    if (!AspAttachCodePageCache(engine, cache))
+        return AspAddCodeResult_OutOfCodeMemory;
+
+    /* Load the first page, which contains the header, and then ensure the
+       header is valid. The page may be in any cache entry. */
+    engine->headerIndex = HeaderSize;
+    AspRunResult pageResult = AspLoadCodePage(engine, 0);
+    if (pageResult != AspRunResult_OK)
+    {
+        AspDetachCodePageCache(engine);
+        return AspAddCodeResult_InvalidFormat;
+    }
+    engine->code = engine->codePage;
+    ProcessCodeHeader(engine);
+    engine->code = 0;
+    if (engine->loadResult != AspAddCodeResult_OK)
+    {
+        AspDetachCodePageCache(engine);
+        return engine->loadResult;
+    }
+
+    engine->state = AspEngineState_Ready;
+    engine->runResult = AspRunResult_OK;
+    return engine->loadResult = AspAddCodeResult_OK;
+}
+
+AspRunResult AspSetCodePrefetcher
+    (AspEngine *engine, AspCodePrefetcher prefetcher, size_t readAheadOffset)
+{
+    /* The prefetcher is passed the same identifier as the code reader. It
+       is called for the next page once execution passes the read-ahead
+       offset within a page, unless the offset is beyond the end of the page,
+       and for pages containing jump and call targets. Requests are hints
+       only, and may refer to pages beyond the end of the code. */
+    if (engine->inApp)
+        return AspRunResult_InvalidState;
+
+    engine->codePrefetcher = prefetcher;
+    engine->codeReadAheadOffset = readAheadOffset;
+    engine->codeReadAheadTrigger = UINT32_MAX;
+    return AspRunResult_OK;
+}
+
+void AspUnshareCodePages(AspEngine *engine)
+{
+    /* The engine is left with no code, so running it fails until it is
+       reset and given code again. */
+    if (engine->codePageCache == 0 ||
+        engine->codePageCache == &engine->ownCodePageCache)
+        return;
+    AspDetachCodePageCache(engine);
+    engine->codeEndIndex = 0;
+    engine->codeEndKnown = false;
+}
+
 AspRunResult AspReset(AspEngine *engine)
 {
     if (engine->inApp)
         return AspRunResult_InvalidState;
 
+    AspDetachCodePageCache(engine);
     engine->state = AspEngineState_Reset;
     engine->headerIndex = 0;
     engine->loadResult = AspAddCodeResult_OK;
@@ -266,18 +389,17 @@ AspRunResult AspReset(AspEngine *engine)
     engine->code = engine->codeArea;
     engine->codeEndIndex = 0;
     engine->pc = engine->instructionAddress = 0;
-    engine->cachedCodePageIndex = 0;
     engine->codeEndKnown = false;
-    engine->pagedCodeId = 0;
     engine->codePageReadCount = 0;
-    if (engine->cachedCodePages != 0)
+    engine->codePageHitCount = 0;
+    engine->codeReadAheadTrigger = UINT32_MAX;
+    engine->characterStringShareCount = 0;
+    engine->stringLiteralShareCount = 0;
+    if (engine->ownCodePageCache.pageCount != 0)
     {
-        for (size_t i = 0; i < engine->cachedCodePageCount; i++)
-        {
-            AspCodePageEntry *entry = engine->cachedCodePages + i;
-            entry->index = 0;
-            entry->age = -1;
-        }
+        engine->ownCodePageCache.id = 0;
+        AspClearCodePageTable(&engine->ownCodePageCache);
+        AspAttachCodePageCache(engine, &engine->ownCodePageCache);
     }
     engine->again = false;
     engine->callFromApp = false;
@@ -302,6 +424,24 @@ uint32_t AspGetCycleDetectionLimit(const AspEngine *engine)
     return engine->cycleDetectionLimit;
 }
 
+AspRunResult AspSetDeadlineChecker
+    (AspEngine *engine, AspDeadlineChecker checker, void *context,
+     uint32_t interval)
+{
+    /* The checker is called each time the given number of instructions
+       has executed within a call to AspRun, so the interval bounds how far
+       a batch may overrun its deadline. A null checker removes it. */
+    if (engine->inApp)
+        return AspRunResult_InvalidState;
+    if (checker != 0 && interval == 0)
+        return AspRunResult_ValueOutOfRange;
+
+    engine->deadlineChecker = checker;
+    engine->deadlineCheckerContext = context;
+    engine->deadlineCheckInterval = interval;
+    return AspRunResult_OK;
+}
+
 AspRunResult AspRestart(AspEngine *engine)
 {
     if (engine->inApp)
@@ -317,6 +457,8 @@ AspRunResult AspRestart(AspEngine *engine)
     engine->runResult = AspRunResult_OK;
     engine->pc = engine->instructionAddress = 0;
     engine->codePageReadCount = 0;
+    engine->characterStringShareCount = 0;
+    engine->stringLiteralShareCount = 0;
     engine->again = false;
     engine->callFromApp = false;
     engine->callReturning = false;
@@ -401,7 +543,7 @@ static AspRunResult ResetData(AspEngine *engine)
 
     /* Initialize stack. */
     engine->stackTop = 0;
-    engine->stackCount = 0;
+    engine->stackCount = engine->peakStackCount = 0;
 
     /* Create empty modules collection. */
     engine->modules = AspAllocEntry(engine, DataType_Namespace);
@@ -660,16 +802,64 @@ bool AspIsRunnable(const AspEngine *engine)
         engine->state == AspEngineState_Running;
 }
 
+bool AspIsCodeReady(AspEngine *engine)
+{
+    /* Indicate whether the engine can proceed without reading a code page,
+       allowing the application to do other work while a prefetched page is
+       being read. */
+    return AspIsCodePageCached(engine, engine->headerIndex + engine->pc);
+}
+
 size_t AspProgramCounter(const AspEngine *engine)
 {
     return (size_t)engine->pc;
 }
 
+size_t AspCallStack
+    (const AspEngine *engine, size_t *returnAddresses, size_t maxCount)
+{
+    /* Walk the stack from the top, noting the return address of each
+       function call and module load frame, innermost first. Return the
+       total number of frames, which may exceed the number stored. */
+    size_t count = 0;
+    const AspDataEntry *stackEntry = engine->stackTop;
+    while (stackEntry != 0 &&
+           AspDataGetType(stackEntry) == DataType_StackEntry)
+    {
+        const AspDataEntry *value =
+            engine->data + AspDataGetStackEntryValueIndex(stackEntry);
+        if (AspDataGetType(value) == DataType_Frame)
+        {
+            if (count < maxCount)
+                returnAddresses[count] =
+                    (size_t)AspDataGetFrameReturnAddress(value);
+            count++;
+        }
+
+        uint32_t previousIndex =
+            AspDataGetStackEntryPreviousIndex(stackEntry);
+        stackEntry = previousIndex == 0 ? 0 : engine->data + previousIndex;
+    }
+
+    return count;
+}
+
 size_t AspLowFreeCount(const AspEngine *engine)
 {
     return engine->lowFreeCount;
 }
 
+void AspGetDataStatistics
+    (const AspEngine *engine, AspDataStatistics *statistics)
+{
+    memset(statistics->entryCounts, 0, sizeof statistics->entryCounts);
+    AspCountDataTypes(engine, statistics->entryCounts);
+    statistics->freeCount = engine->freeCount;
+    statistics->lowFreeCount = engine->lowFreeCount;
+    statistics->stackDepth = engine->stackCount;
+    statistics->peakStackDepth = engine->peakStackCount;
+}
+
 size_t AspCodePageReadCount(AspEngine *engine, bool reset)
 {
     size_t count = engine->codePageReadCount;
@@ -677,3 +867,33 @@ size_t AspCodePageReadCount(AspEngine *engine, bool reset)
         engine->codePageReadCount = 0;
     return count;
 }
+
+size_t AspCharacterStringShareCount(AspEngine *engine, bool reset)
+{
+    size_t count = engine->characterStringShareCount;
+    if (reset)
+        engine->characterStringShareCount = 0;
+    return count;
+}
+
+size_t AspStringLiteralShareCount(AspEngine *engine, bool reset)
+{
+    size_t count = engine->stringLiteralShareCount;
+    if (reset)
+        engine->stringLiteralShareCount = 0;
+    return count;
+}
+
+#ifdef ASP_OPCODE_PROFILE
+void AspSetOpCodeProfiler
+    (AspEngine *engine, AspOpCodeProfiler profiler, void *context)
+{
+    engine->opCodeProfiler = profiler;
+    engine->opCodeProfilerContext = context;
+}
+
+void AspSetProfile(AspEngine *engine, AspProfile *profile)
+{
+    engine->profile = profile;
+}
+#endif
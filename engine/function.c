@@ -295,6 +295,7 @@ AspRunResult AspCallFunction
         ns = AspAllocEntry(engine, DataType_Namespace);
         if (ns == 0)
             return AspRunResult_OutOfDataMemory;
+        AspDataSetNamespaceIsLocal(ns, true);
         AspRunResult loadArgumentsResult = AspLoadArguments
             (engine, argumentList, parameters, ns);
         if (loadArgumentsResult != AspRunResult_OK)
@@ -442,9 +443,11 @@ AspRunResult AspCallFunction
     }
     else
     {
-        /* Obtain the code address of the script-defined function. */
+        /* Obtain the code address of the script-defined function. As with
+           jumps, loading the page containing it is deferred until the
+           function's first instruction is fetched. */
         uint32_t codeAddress = AspDataGetFunctionCodeAddress(function);
-        AspRunResult validateResult = AspValidateCodeAddress
+        AspRunResult validateResult = AspValidateCodeTarget
             (engine, codeAddress);
         if (validateResult != AspRunResult_OK)
             return validateResult;
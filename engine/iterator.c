@@ -184,8 +184,8 @@ AspIteratorResult AspIteratorCreate
         }
     }
     AspDataSetIteratorMemberIndex(iterator, AspIndex(engine, member));
-    AspDataSetType
-        (iterator,
+    AspSetEntryType
+        (engine, iterator,
          reversed ? DataType_ReverseIterator : DataType_ForwardIterator);
 
     if (result.result != AspRunResult_OK)
@@ -420,35 +420,9 @@ AspIteratorResult AspIteratorDereference
                 AspDataGetStringFragmentData(fragment);
             uint8_t c = stringData[stringIndex];
 
-            AspDataEntry *resultString = AspAllocEntry
-                (engine, DataType_String);
-            if (resultString == 0)
-            {
+            value = AspCharacterString(engine, c);
+            if (value == 0)
                 result.result = AspRunResult_OutOfDataMemory;
-                break;
-            }
-
-            AspDataEntry *newFragment =
-                AspAllocEntry(engine, DataType_StringFragment);
-            if (newFragment == 0)
-            {
-                AspUnref(engine, resultString);
-                result.result = AspRunResult_OutOfDataMemory;
-                break;
-            }
-            AspDataSetStringFragment(newFragment, &c , 1);
-
-            AspSequenceResult appendResult = AspSequenceAppend
-                (engine, resultString, newFragment);
-            if (appendResult.result != AspRunResult_OK)
-            {
-                AspUnref(engine, newFragment);
-                AspUnref(engine, resultString);
-                result.result = appendResult.result;
-                break;
-            }
-
-            value = resultString;
 
             break;
         }
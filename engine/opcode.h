@@ -75,6 +75,17 @@ typedef enum OpCode
     OpCode_IS = 0x69, /* is */
     OpCode_ORDER = 0x6C, /* object order */
 
+    /* Fused binary operations. Each takes a 1-byte binary operation op code,
+       followed by the immediate integer right operand where applicable, and
+       then the jump address where applicable. */
+    OpCode_BINI1 = 0x71, /* binary operation with 1-byte integer operand */
+    OpCode_BINI2 = 0x72, /* binary operation with 2-byte integer operand */
+    OpCode_BINI4 = 0x73, /* binary operation with 4-byte integer operand */
+    OpCode_BJMPF = 0x74, /* binary operation, jump if false */
+    OpCode_BIJMPF1 = 0x75, /* BINI1, jump if false */
+    OpCode_BIJMPF2 = 0x76, /* BINI2, jump if false */
+    OpCode_BIJMPF4 = 0x77, /* BINI4, jump if false */
+
     /* Load operations. */
     OpCode_LD = 0x80, /* load variable's value with symbol on the stack */
     OpCode_LD1 = 0x81, /* load variable's value with 1-byte symbol */
@@ -88,6 +99,7 @@ typedef enum OpCode
     /* Assignment and deletion operations. */
     OpCode_SET = 0x88, /* assign variable (no pop) */
     OpCode_SETP = 0x89, /* assign variable with pop */
+    OpCode_SETOP = 0x8A, /* binary operation, assign result with pop */
     OpCode_ERASE = 0x8C, /* delete element or slice */
     OpCode_DEL1 = 0x8D, /* delete variable with 1-byte symbol */
     OpCode_DEL2 = 0x8E, /* delete variable with 2-byte symbol */
@@ -101,6 +113,18 @@ typedef enum OpCode
     OpCode_LOC2 = 0x96, /* cancel 2-byte symbol global override */
     OpCode_LOC4 = 0x97, /* cancel 4-byte symbol global override */
 
+    /* Local variable slot operations. SLOTS starts each function's code,
+       giving the number of slots its variables use. Each load takes a
+       1-byte slot number followed by the variable's symbol, which is used
+       when the slot does not yet refer to the variable. */
+    OpCode_SLOTS = 0x98, /* reserve local variable slots for the call */
+    OpCode_LDL1 = 0x99, /* load local variable's value with 1-byte symbol */
+    OpCode_LDL2 = 0x9A, /* load local variable's value with 2-byte symbol */
+    OpCode_LDL4 = 0x9B, /* load local variable's value with 4-byte symbol */
+    OpCode_LDLA1 = 0x9D, /* load local variable's address, 1-byte symbol */
+    OpCode_LDLA2 = 0x9E, /* load local variable's address, 2-byte symbol */
+    OpCode_LDLA4 = 0x9F, /* load local variable's address, 4-byte symbol */
+
     /* Iterator operations. */
     OpCode_SITER = 0xA0, /* start iterator */
     OpCode_TITER = 0xA1, /* test iterator */
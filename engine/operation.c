@@ -332,6 +332,50 @@ AspOperationResult AspPerformBinaryOperation
     return result;
 }
 
+AspOperationResult AspPerformInPlaceBinaryOperation
+    (AspEngine *engine, uint8_t opCode,
+     AspDataEntry *left, AspDataEntry *right)
+{
+    /* Only string concatenation is performed in place. All other operations
+       produce a new object as usual. The caller is responsible for ensuring
+       that the left operand is not shared. */
+    if (opCode != OpCode_ADD ||
+        AspDataGetType(left) != DataType_String ||
+        AspDataGetType(right) != DataType_String)
+        return AspPerformBinaryOperation(engine, opCode, left, right);
+
+    AspOperationResult result = {AspRunResult_OK, 0};
+
+    /* Append the right string's fragments to the left string, extending
+       the left string's last fragment where possible. */
+    AspSequenceResult nextResult = AspSequenceNext(engine, right, 0, true);
+    uint32_t iterationCount = 0;
+    for (;
+         iterationCount < engine->cycleDetectionLimit &&
+         nextResult.element != 0;
+         iterationCount++,
+         nextResult = AspSequenceNext
+            (engine, right, nextResult.element, true))
+    {
+        AspDataEntry *fragment = nextResult.value;
+        result.result = AspStringAppendBuffer
+            (engine, left,
+             AspDataGetStringFragmentData(fragment),
+             AspDataGetStringFragmentSize(fragment));
+        if (result.result != AspRunResult_OK)
+            return result;
+    }
+    if (iterationCount >= engine->cycleDetectionLimit)
+    {
+        result.result = AspRunResult_CycleDetected;
+        return result;
+    }
+
+    AspRef(engine, left);
+    result.value = left;
+    return result;
+}
+
 static AspOperationResult PerformBitwiseBinaryOperation
     (AspEngine *engine, uint8_t opCode,
      const AspDataEntry *left, const AspDataEntry *right)
@@ -22,6 +22,9 @@ AspOperationResult AspPerformUnaryOperation
 AspOperationResult AspPerformBinaryOperation
     (AspEngine *engine, uint8_t opCode,
      AspDataEntry *left, AspDataEntry *right);
+AspOperationResult AspPerformInPlaceBinaryOperation
+    (AspEngine *engine, uint8_t opCode,
+     AspDataEntry *left, AspDataEntry *right);
 
 #ifdef __cplusplus
 }
@@ -97,6 +97,13 @@ void AspUnref(AspEngine *engine, AspDataEntry *entry)
             else if (t == DataType_Set || t == DataType_Dictionary ||
                      t == DataType_Namespace)
             {
+                #ifdef ASP_HASHED_COLLECTIONS
+                /* Give up any hash index first, as keeping it up to date
+                   while erasing every node would be wasted effort. */
+                if (t != DataType_Namespace)
+                    AspTreeDropHashIndex(engine, entry);
+                #endif
+
                 AspTreeResult nextResult = {AspRunResult_OK, 0, 0, 0, false};
                 uint32_t iterationCount = 0;
                 for (;
@@ -4,9 +4,31 @@
 
 #include "sequence.h"
 #include "data.h"
+#include <stdint.h>
 
+static const unsigned ChunkSlotBitSize = 2U;
+static const unsigned MaxChunkLevel = (AspWordBitSize + 1U) / 2U - 1U;
+
+static AspSequenceResult IndexSequence
+    (AspEngine *, const AspDataEntry *sequence, int32_t index,
+     bool buildChunkIndex);
 static bool IsSequenceType(DataType);
 static bool IsElementType(DataType);
+static bool IsChunkIndexedType(DataType);
+static bool CanAllocateChunks(AspEngine *, size_t count);
+static bool CountTraversal
+    (AspEngine *, uint32_t sequenceIndex, int32_t distance, int32_t count);
+static bool BuildChunkIndex(AspEngine *, const AspDataEntry *sequence);
+static AspDataEntry *SetChunkIndexElement
+    (AspEngine *, AspDataEntry *head, int32_t position, uint32_t elementIndex);
+static AspDataEntry *NewChunk(AspEngine *, unsigned level);
+static AspDataEntry *ChunkIndexElement
+    (AspEngine *, const AspDataEntry *head, int32_t position);
+static void DropChunkIndex(AspEngine *, AspDataEntry *head);
+static void ForgetIndexCacheEntries(AspEngine *, const AspDataEntry *sequence);
+static void UpdateIndexCache
+    (AspEngine *, const AspDataEntry *sequence,
+     const AspDataEntry *element, int32_t position);
 
 AspSequenceResult AspSequenceAppend
     (AspEngine *engine, AspDataEntry *sequence, AspDataEntry *value)
@@ -45,6 +67,19 @@ AspSequenceResult AspSequenceAppend
         AspDataSetElementPreviousIndex(result.element, tailIndex);
         AspDataSetSequenceTailIndex
             (sequence, AspIndex(engine, result.element));
+
+        /* Add the element to any chunk index, giving up the index if
+           memory is too scarce to extend it. */
+        if (IsChunkIndexedType(AspDataGetType(sequence)))
+        {
+            AspDataEntry *head = AspEntry
+                (engine, AspDataGetSequenceHeadIndex(sequence));
+            if (AspDataGetElementChunkIndex(head) != 0 &&
+                !SetChunkIndexElement
+                    (engine, head, AspDataGetSequenceCount(sequence),
+                     elementIndex))
+                DropChunkIndex(engine, head);
+        }
     }
 
     /* Update the sequence count. */
@@ -63,10 +98,12 @@ AspSequenceResult AspSequenceInsertByIndex
     if (index == -1 || index == AspDataGetSequenceCount(sequence))
         return AspSequenceAppend(engine, sequence, value);
 
-    /* Locate insertion point, adjusting by one for a negative index. */
+    /* Locate insertion point, adjusting by one for a negative index. There
+       is no point in building a chunk index, as insertion gives it up. */
     if (index < 0)
         index++;
-    AspSequenceResult result = AspSequenceIndex(engine, sequence, index);
+    AspSequenceResult result = IndexSequence
+        (engine, sequence, index, false);
     if (result.result != AspRunResult_OK)
         return result;
     if (result.element == 0)
@@ -107,6 +144,13 @@ AspSequenceResult AspSequenceInsert
     AspRef(engine, value);
     AspDataSetElementValueIndex(result.element, AspIndex(engine, value));
 
+    /* Positions of subsequent elements are about to change, so give up
+       any chunk index. */
+    if (IsChunkIndexedType(AspDataGetType(sequence)))
+        DropChunkIndex
+            (engine,
+             AspEntry(engine, AspDataGetSequenceHeadIndex(sequence)));
+
     /* Update links. */
     uint32_t nextElementIndex = AspIndex(engine, element);
     uint32_t previousElementIndex = AspDataGetElementPreviousIndex(element);
@@ -123,6 +167,9 @@ AspSequenceResult AspSequenceInsert
     }
     AspDataSetElementPreviousIndex(element, newElementIndex);
 
+    /* Positions of subsequent elements have changed. */
+    ForgetIndexCacheEntries(engine, sequence);
+
     /* Update the sequence count. */
     int32_t sizeChange = AspDataGetType(sequence) == DataType_String ?
         (int32_t)AspDataGetStringFragmentSize(value) : 1;
@@ -136,7 +183,8 @@ bool AspSequenceErase
     (AspEngine *engine, AspDataEntry *sequence, int32_t index,
      bool eraseValue)
 {
-    AspSequenceResult result = AspSequenceIndex(engine, sequence, index);
+    AspSequenceResult result = IndexSequence
+        (engine, sequence, index, false);
     if (result.element == 0)
         return false;
 
@@ -157,9 +205,23 @@ bool AspSequenceEraseElement
     if (result != AspRunResult_OK)
         return false;
 
-    /* Update links in adjacent elements. */
+    /* Remove the element from any chunk index. Erasing the last element
+       leaves the positions of the others intact, but erasing any other
+       element means giving up the index. */
     uint32_t prevIndex = AspDataGetElementPreviousIndex(element);
     uint32_t nextIndex = AspDataGetElementNextIndex(element);
+    AspDataEntry *head = AspEntry
+        (engine, AspDataGetSequenceHeadIndex(sequence));
+    if (IsChunkIndexedType(AspDataGetType(sequence)) &&
+        AspDataGetElementChunkIndex(head) != 0)
+    {
+        if (prevIndex == 0 || nextIndex != 0 ||
+            !SetChunkIndexElement
+                (engine, head, AspDataGetSequenceCount(sequence) - 1, 0))
+            DropChunkIndex(engine, head);
+    }
+
+    /* Update links in adjacent elements. */
     if (prevIndex == 0)
         AspDataSetSequenceHeadIndex(sequence, nextIndex);
     else
@@ -168,6 +230,7 @@ bool AspSequenceEraseElement
         AspDataSetSequenceTailIndex(sequence, prevIndex);
     else
         AspDataSetElementPreviousIndex(AspEntry(engine, nextIndex), prevIndex);
+    ForgetIndexCacheEntries(engine, sequence);
 
     /* Prepare to drop the element. */
     AspDataEntry *value = AspValueEntry
@@ -197,54 +260,7 @@ bool AspSequenceEraseElement
 AspSequenceResult AspSequenceIndex
     (AspEngine *engine, const AspDataEntry *sequence, int32_t index)
 {
-    AspSequenceResult result = {AspRunResult_OK, 0, 0};
-
-    uint8_t type = AspDataGetType(sequence);
-    result.result = AspAssert
-        (engine, IsSequenceType(type) && type != DataType_String);
-
-    /* Treat negative indices as counting backwards from the end. */
-    int32_t count = AspDataGetSequenceCount(sequence);
-    if (index < 0)
-        index += count;
-
-    /* Ensure the index is in range. */
-    if (index < 0 || index >= count)
-    {
-        result.result = AspRunResult_ValueOutOfRange;
-        return result;
-    }
-
-    /* Check if the request is for the last element, as it's easier to
-       fetch directly rather than traversing the whole sequence. */
-    if (count > 0 && index == count - 1)
-    {
-        /* Return tail element. */
-        result.element = AspEntry
-            (engine, AspDataGetSequenceTailIndex(sequence));
-        result.value = AspValueEntry
-            (engine, AspDataGetElementValueIndex(result.element));
-    }
-    else
-    {
-        /* Traverse the sequence to arrive at the requested element. */
-        result = AspSequenceNext(engine, sequence, 0, true);
-        uint32_t iterationCount = 0;
-        for (int32_t i = 0;
-             iterationCount < engine->cycleDetectionLimit &&
-             i < index && result.element != 0;
-             iterationCount++, i++)
-        {
-            result = AspSequenceNext(engine, sequence, result.element, true);
-        }
-        if (iterationCount >= engine->cycleDetectionLimit)
-        {
-            result.result = AspRunResult_CycleDetected;
-            return result;
-        }
-    }
-
-    return result;
+    return IndexSequence(engine, sequence, index, true);
 }
 
 AspSequenceResult AspSequenceNext
@@ -348,6 +364,446 @@ AspRunResult AspStringAppendBuffer
     return result;
 }
 
+AspDataEntry *AspCharacterString(AspEngine *engine, uint8_t c)
+{
+    /* Share the existing string for the character if there is one. */
+    uint32_t *cacheEntry =
+        c < ASP_CHARACTER_STRING_CACHE_SIZE ?
+        engine->characterStrings + c : 0;
+    if (cacheEntry != 0 && *cacheEntry != 0)
+    {
+        AspDataEntry *str = AspEntry(engine, *cacheEntry);
+        AspRef(engine, str);
+        if (engine->characterStringShareCount < SIZE_MAX)
+            engine->characterStringShareCount++;
+        return str;
+    }
+
+    /* Create a new string, keeping a reference to it for subsequent use.
+       The reference held by the engine ensures that the string is never
+       considered unshared, and is therefore never modified in place. */
+    AspDataEntry *str = AspAllocEntry(engine, DataType_String);
+    if (str == 0)
+        return 0;
+    AspRunResult appendResult = AspStringAppendBuffer
+        (engine, str, (const char *)&c, 1);
+    if (appendResult != AspRunResult_OK)
+    {
+        AspUnref(engine, str);
+        return 0;
+    }
+    if (cacheEntry != 0)
+    {
+        AspRef(engine, str);
+        *cacheEntry = AspIndex(engine, str);
+    }
+
+    return str;
+}
+
+void AspReleaseSharedStrings(AspEngine *engine)
+{
+    for (unsigned c = 0; c < ASP_CHARACTER_STRING_CACHE_SIZE; c++)
+    {
+        uint32_t index = engine->characterStrings[c];
+        if (index == 0)
+            continue;
+        engine->characterStrings[c] = 0;
+        AspUnref(engine, AspEntry(engine, index));
+    }
+    for (unsigned i = 0; i < ASP_STRING_LITERAL_CACHE_SIZE; i++)
+    {
+        AspStringLiteralCacheEntry *cacheEntry =
+            engine->stringLiteralCache + i;
+        uint32_t index = cacheEntry->stringIndex;
+        if (index == 0)
+            continue;
+        cacheEntry->stringIndex = 0;
+        AspUnref(engine, AspEntry(engine, index));
+    }
+}
+
+static void ForgetIndexCacheEntries
+    (AspEngine *engine, const AspDataEntry *sequence)
+{
+    uint32_t sequenceIndex = AspIndex(engine, sequence);
+    for (unsigned i = 0; i < ASP_SEQUENCE_INDEX_CACHE_SIZE; i++)
+    {
+        AspSequenceIndexCacheEntry *cacheEntry =
+            engine->sequenceIndexCache + i;
+        if (cacheEntry->sequenceIndex == sequenceIndex)
+            cacheEntry->sequenceIndex = 0;
+    }
+}
+
+static void UpdateIndexCache
+    (AspEngine *engine, const AspDataEntry *sequence,
+     const AspDataEntry *element, int32_t position)
+{
+    /* Reuse this sequence's entry if there is one. Otherwise, replace the
+       entries in round-robin order. */
+    uint32_t sequenceIndex = AspIndex(engine, sequence);
+    AspSequenceIndexCacheEntry *cacheEntry = 0;
+    for (unsigned i = 0; i < ASP_SEQUENCE_INDEX_CACHE_SIZE; i++)
+    {
+        if (engine->sequenceIndexCache[i].sequenceIndex == sequenceIndex)
+        {
+            cacheEntry = engine->sequenceIndexCache + i;
+            break;
+        }
+    }
+    if (cacheEntry == 0)
+    {
+        cacheEntry =
+            engine->sequenceIndexCache + engine->sequenceIndexCacheNext;
+        engine->sequenceIndexCacheNext = (uint8_t)
+            ((engine->sequenceIndexCacheNext + 1U) %
+             ASP_SEQUENCE_INDEX_CACHE_SIZE);
+    }
+
+    cacheEntry->sequenceIndex = sequenceIndex;
+    cacheEntry->elementIndex = AspIndex(engine, element);
+    cacheEntry->position = position;
+}
+
+static AspSequenceResult IndexSequence
+    (AspEngine *engine, const AspDataEntry *sequence, int32_t index,
+     bool buildChunkIndex)
+{
+    AspSequenceResult result = {AspRunResult_OK, 0, 0};
+
+    uint8_t type = AspDataGetType(sequence);
+    result.result = AspAssert
+        (engine, IsSequenceType(type) && type != DataType_String);
+
+    /* Treat negative indices as counting backwards from the end. */
+    int32_t count = AspDataGetSequenceCount(sequence);
+    if (index < 0)
+        index += count;
+
+    /* Ensure the index is in range. */
+    if (index < 0 || index >= count)
+    {
+        result.result = AspRunResult_ValueOutOfRange;
+        return result;
+    }
+
+    /* Choose the closest known element from which to start traversing
+       the sequence, considering the head, the tail, and any recently
+       indexed positions within this sequence. */
+    uint32_t startIndex = AspDataGetSequenceHeadIndex(sequence);
+    int32_t startPosition = 0;
+    int32_t distance = index;
+    if (count - 1 - index < distance)
+    {
+        startIndex = AspDataGetSequenceTailIndex(sequence);
+        startPosition = count - 1;
+        distance = count - 1 - index;
+    }
+    uint32_t sequenceIndex = AspIndex(engine, sequence);
+    for (unsigned i = 0; distance != 0 && i < ASP_SEQUENCE_INDEX_CACHE_SIZE;
+         i++)
+    {
+        const AspSequenceIndexCacheEntry *cacheEntry =
+            engine->sequenceIndexCache + i;
+        if (cacheEntry->sequenceIndex != sequenceIndex)
+            continue;
+        int32_t cacheDistance = index - cacheEntry->position;
+        if (cacheDistance < 0)
+            cacheDistance = -cacheDistance;
+        if (cacheDistance < distance)
+        {
+            startIndex = cacheEntry->elementIndex;
+            startPosition = cacheEntry->position;
+            distance = cacheDistance;
+        }
+    }
+
+    /* If the traversal would be long, look up the element in the
+       sequence's chunk index instead, building the index first if
+       permitted and warranted. */
+    if (distance >= ASP_SEQUENCE_CHUNK_INDEX_MIN_DISTANCE &&
+        count >= ASP_SEQUENCE_CHUNK_INDEX_MIN_COUNT &&
+        IsChunkIndexedType(type))
+    {
+        const AspDataEntry *head = AspEntry
+            (engine, AspDataGetSequenceHeadIndex(sequence));
+        if (AspDataGetElementChunkIndex(head) != 0 ||
+            (buildChunkIndex &&
+             CountTraversal(engine, sequenceIndex, distance, count) &&
+             BuildChunkIndex(engine, sequence)))
+            result.element = ChunkIndexElement(engine, head, index);
+    }
+
+    /* Otherwise, traverse the sequence to arrive at the requested
+       element. */
+    if (result.element == 0)
+    {
+        bool right = index > startPosition;
+        result.element = AspEntry(engine, startIndex);
+        uint32_t iterationCount = 0;
+        for (;
+             iterationCount < engine->cycleDetectionLimit &&
+             distance > 0 && result.element != 0;
+             iterationCount++, distance--)
+        {
+            result.element = AspEntry
+                (engine,
+                 right ?
+                 AspDataGetElementNextIndex(result.element) :
+                 AspDataGetElementPreviousIndex(result.element));
+        }
+        if (iterationCount >= engine->cycleDetectionLimit)
+        {
+            result.result = AspRunResult_CycleDetected;
+            return result;
+        }
+    }
+    result.result = AspAssert
+        (engine,
+         result.element != 0 &&
+         IsElementType(AspDataGetType(result.element)));
+    if (result.result != AspRunResult_OK)
+    {
+        result.element = 0;
+        return result;
+    }
+    result.value = AspValueEntry
+        (engine, AspDataGetElementValueIndex(result.element));
+
+    /* Remember the position of any element not at either end, as the next
+       access is likely to be nearby (e.g., indexing within a loop). */
+    if (index != 0 && index != count - 1)
+        UpdateIndexCache(engine, sequence, result.element, index);
+
+    return result;
+}
+
+static bool BuildChunkIndex(AspEngine *engine, const AspDataEntry *sequence)
+{
+    /* Only build the index if there is ample memory for all of it. */
+    size_t chunkCount = 0;
+    size_t levelCount = (size_t)AspDataGetSequenceCount(sequence);
+    unsigned capacity = AspDataGetElementChunkCapacity();
+    do
+    {
+        levelCount = (levelCount + capacity - 1U) / capacity;
+        chunkCount += levelCount;
+    } while (levelCount > 1);
+    if (!CanAllocateChunks(engine, chunkCount))
+        return false;
+
+    /* Record each element's position, filling each leaf chunk directly
+       once it has been reached. */
+    AspDataEntry *head = AspEntry
+        (engine, AspDataGetSequenceHeadIndex(sequence));
+    AspDataEntry *leaf = 0;
+    unsigned slotMask = capacity - 1U;
+    int32_t position = 0;
+    uint32_t iterationCount = 0;
+    for (uint32_t elementIndex = AspIndex(engine, head);
+         iterationCount < engine->cycleDetectionLimit && elementIndex != 0;
+         iterationCount++, position++)
+    {
+        unsigned slot = (unsigned)position & slotMask;
+        if (slot != 0)
+            AspDataSetElementChunkSlotIndex(leaf, slot, elementIndex);
+        else if ((leaf = SetChunkIndexElement
+                    (engine, head, position, elementIndex)) == 0)
+        {
+            DropChunkIndex(engine, head);
+            return false;
+        }
+        elementIndex = AspDataGetElementNextIndex
+            (AspEntry(engine, elementIndex));
+    }
+    if (iterationCount >= engine->cycleDetectionLimit)
+    {
+        DropChunkIndex(engine, head);
+        return false;
+    }
+
+    return true;
+}
+
+static AspDataEntry *SetChunkIndexElement
+    (AspEngine *engine, AspDataEntry *head, int32_t position,
+     uint32_t elementIndex)
+{
+    /* Return the leaf chunk holding the position, or null if the index
+       could not be extended to span it. */
+    uint32_t offset = (uint32_t)position;
+    unsigned slotMask = AspDataGetElementChunkCapacity() - 1U;
+
+    /* Start the index, or add chunks above its root, until it spans the
+       given position. */
+    uint32_t rootIndex = AspDataGetElementChunkIndex(head);
+    unsigned level = 0;
+    if (rootIndex == 0)
+    {
+        AspDataEntry *root = NewChunk(engine, level);
+        if (root == 0)
+            return 0;
+        rootIndex = AspIndex(engine, root);
+        AspDataSetElementChunkIndex(head, rootIndex);
+    }
+    else
+        level = AspDataGetElementChunkLevel(AspEntry(engine, rootIndex));
+    while (offset >> (ChunkSlotBitSize * (level + 1U)) != 0)
+    {
+        if (level >= MaxChunkLevel)
+            return 0;
+        AspDataEntry *root = NewChunk(engine, level + 1U);
+        if (root == 0)
+            return 0;
+        AspDataSetElementChunkSlotIndex(root, 0, rootIndex);
+        rootIndex = AspIndex(engine, root);
+        AspDataSetElementChunkIndex(head, rootIndex);
+        level++;
+    }
+
+    /* Descend to the leaf chunk, adding chunks along the way as needed. */
+    AspDataEntry *chunk = AspEntry(engine, rootIndex);
+    for (; level > 0; level--)
+    {
+        unsigned slot = (offset >> (ChunkSlotBitSize * level)) & slotMask;
+        uint32_t childIndex = AspDataGetElementChunkSlotIndex(chunk, slot);
+        if (childIndex == 0)
+        {
+            AspDataEntry *child = NewChunk(engine, level - 1U);
+            if (child == 0)
+                return 0;
+            childIndex = AspIndex(engine, child);
+            AspDataSetElementChunkSlotIndex(chunk, slot, childIndex);
+        }
+        chunk = AspEntry(engine, childIndex);
+    }
+    unsigned slot = offset & slotMask;
+    AspDataSetElementChunkSlotIndex(chunk, slot, elementIndex);
+
+    return chunk;
+}
+
+static AspDataEntry *ChunkIndexElement
+    (AspEngine *engine, const AspDataEntry *head, int32_t position)
+{
+    uint32_t offset = (uint32_t)position;
+    unsigned slotMask = AspDataGetElementChunkCapacity() - 1U;
+
+    AspDataEntry *chunk = AspEntry
+        (engine, AspDataGetElementChunkIndex(head));
+    if (chunk == 0)
+        return 0;
+    unsigned rootLevel = AspDataGetElementChunkLevel(chunk);
+    if (offset >> (ChunkSlotBitSize * (rootLevel + 1U)) != 0)
+        return 0;
+    for (unsigned depth = 0; depth <= MaxChunkLevel; depth++)
+    {
+        if (AspDataGetType(chunk) != DataType_ElementChunk)
+            return 0;
+        unsigned level = AspDataGetElementChunkLevel(chunk);
+        unsigned slot = (offset >> (ChunkSlotBitSize * level)) & slotMask;
+        AspDataEntry *entry = AspEntry
+            (engine, AspDataGetElementChunkSlotIndex(chunk, slot));
+        if (level == 0 || entry == 0)
+            return entry;
+        chunk = entry;
+    }
+
+    return 0;
+}
+
+static void DropChunkIndex(AspEngine *engine, AspDataEntry *head)
+{
+    if (head == 0)
+        return;
+    uint32_t rootIndex = AspDataGetElementChunkIndex(head);
+    if (rootIndex == 0)
+        return;
+    AspDataSetElementChunkIndex(head, 0);
+
+    /* Free the chunks depth first, remembering the path from the root. */
+    uint32_t pathIndices[(AspWordBitSize + 1U) / 2U];
+    unsigned pathSlots[(AspWordBitSize + 1U) / 2U];
+    unsigned capacity = AspDataGetElementChunkCapacity();
+    unsigned depth = 0;
+    pathIndices[0] = rootIndex;
+    pathSlots[0] = 0;
+    for (;;)
+    {
+        AspDataEntry *chunk = AspEntry(engine, pathIndices[depth]);
+        uint32_t childIndex = 0;
+        if (AspDataGetElementChunkLevel(chunk) != 0)
+        {
+            for (; childIndex == 0 && pathSlots[depth] < capacity;
+                 pathSlots[depth]++)
+            {
+                unsigned slot = pathSlots[depth];
+                childIndex = AspDataGetElementChunkSlotIndex(chunk, slot);
+            }
+        }
+        if (childIndex != 0 && depth < MaxChunkLevel)
+        {
+            depth++;
+            pathIndices[depth] = childIndex;
+            pathSlots[depth] = 0;
+            continue;
+        }
+
+        AspUnref(engine, chunk);
+        if (engine->runResult != AspRunResult_OK || depth == 0)
+            break;
+        depth--;
+    }
+}
+
+static AspDataEntry *NewChunk(AspEngine *engine, unsigned level)
+{
+    if (!CanAllocateChunks(engine, 1))
+        return 0;
+    AspDataEntry *chunk = AspAllocEntry(engine, DataType_ElementChunk);
+    if (chunk == 0)
+        return 0;
+    AspDataSetElementChunkLevel(chunk, level);
+    return chunk;
+}
+
+static bool CanAllocateChunks(AspEngine *engine, size_t count)
+{
+    /* Leave a good part of the data area for everything else, as the index
+       is merely an optimization. */
+    return engine->freeCount > count +
+        engine->dataEndIndex / ASP_SEQUENCE_CHUNK_INDEX_FREE_DIVISOR;
+}
+
+static bool CountTraversal
+    (AspEngine *engine, uint32_t sequenceIndex, int32_t distance,
+     int32_t count)
+{
+    /* Building an index costs more than traversing the whole sequence, so
+       only build one once traversals of the sequence have covered a
+       multiple of its length. Otherwise, alternating insertions (which
+       drop the index) and lookups would rebuild it for every lookup. */
+    if (engine->chunkIndexCandidateIndex != sequenceIndex)
+    {
+        engine->chunkIndexCandidateIndex = sequenceIndex;
+        engine->chunkIndexTraversalCount = 0;
+    }
+    engine->chunkIndexTraversalCount += (uint32_t)distance;
+    if (engine->chunkIndexTraversalCount <
+        (uint32_t)count * ASP_SEQUENCE_CHUNK_INDEX_BUILD_RATIO)
+        return false;
+    engine->chunkIndexTraversalCount = 0;
+    return true;
+}
+
+static bool IsChunkIndexedType(DataType type)
+{
+    return
+        type == DataType_Tuple ||
+        type == DataType_List;
+}
+
 static bool IsSequenceType(DataType type)
 {
     return
@@ -40,6 +40,8 @@ AspSequenceResult AspSequenceNext
      const AspDataEntry *element, bool right);
 AspRunResult AspStringAppendBuffer
     (AspEngine *, AspDataEntry *str, const char *buffer, size_t bufferSize);
+AspDataEntry *AspCharacterString(AspEngine *, uint8_t c);
+void AspReleaseSharedStrings(AspEngine *);
 
 #ifdef __cplusplus
 }
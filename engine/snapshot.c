@@ -0,0 +1,304 @@
+/*
+ * Asp engine snapshot and fork implementation.
+ */
+
+#include "asp-priv.h"
+#include "code.h"
+#include "data.h"
+#include <string.h>
+#include <stdint.h>
+
+/* Engine state captured in a snapshot. The data entries in use, i.e., those
+   below the watermark, follow the header. References to data entries are
+   stored as indices so that the header does not depend on the address of
+   the data area. */
+typedef struct
+{
+    uint32_t checkValue;
+    uint8_t version[4];
+    AspEngineState state;
+    uint32_t pc, instructionAddress;
+    uint32_t dataEndIndex, dataWatermark, freeListIndex;
+    size_t freeCount, lowFreeCount;
+    uint32_t dataTypeCounts[ASP_DATA_TYPE_SLOT_COUNT];
+    AspSequenceIndexCacheEntry sequenceIndexCache
+        [ASP_SEQUENCE_INDEX_CACHE_SIZE];
+    uint8_t sequenceIndexCacheNext;
+    uint32_t chunkIndexCandidateIndex, chunkIndexTraversalCount;
+    uint32_t localSlots[ASP_LOCAL_SLOT_COUNT];
+    uint32_t localSlotCount;
+    AspLoadCacheEntry loadCache[ASP_LOAD_CACHE_SIZE];
+    uint32_t namespaceGeneration;
+    uint32_t characterStrings[ASP_CHARACTER_STRING_CACHE_SIZE];
+    AspStringLiteralCacheEntry stringLiteralCache
+        [ASP_STRING_LITERAL_CACHE_SIZE];
+    uint32_t falseSingletonIndex, trueSingletonIndex;
+    uint32_t stackTopIndex;
+    unsigned stackCount, peakStackCount;
+    uint32_t modulesIndex, systemModuleIndex, moduleIndex;
+    uint32_t systemNamespaceIndex, globalNamespaceIndex, localNamespaceIndex;
+    int32_t nextSymbol;
+} SnapshotHeader;
+
+static bool IsSnapshotState(const AspEngine *);
+static uint32_t EntryIndex(const AspEngine *, const AspDataEntry *);
+static AspDataEntry *ForkEntry
+    (const AspEngine *, AspEngine *fork, const AspDataEntry *);
+
+size_t AspSnapshotSize(const AspEngine *engine)
+{
+    return
+        sizeof(SnapshotHeader) +
+        engine->dataWatermark * sizeof(AspDataEntry);
+}
+
+AspRunResult AspSaveSnapshot
+    (const AspEngine *engine, void *snapshot, size_t snapshotSize)
+{
+    if (!IsSnapshotState(engine) ||
+        (engine->state != AspEngineState_Ready &&
+         engine->state != AspEngineState_Running))
+        return AspRunResult_InvalidState;
+    if (snapshotSize < AspSnapshotSize(engine))
+        return AspRunResult_ValueOutOfRange;
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof header);
+    header.checkValue = engine->appSpec->checkValue;
+    memcpy(header.version, engine->version, sizeof header.version);
+    header.state = engine->state;
+    header.pc = engine->pc;
+    header.instructionAddress = engine->instructionAddress;
+    header.dataEndIndex = (uint32_t)engine->dataEndIndex;
+    header.dataWatermark = engine->dataWatermark;
+    header.freeListIndex = engine->freeListIndex;
+    header.freeCount = engine->freeCount;
+    header.lowFreeCount = engine->lowFreeCount;
+    memcpy
+        (header.dataTypeCounts, engine->dataTypeCounts,
+         sizeof header.dataTypeCounts);
+    memcpy
+        (header.sequenceIndexCache, engine->sequenceIndexCache,
+         sizeof header.sequenceIndexCache);
+    header.sequenceIndexCacheNext = engine->sequenceIndexCacheNext;
+    header.chunkIndexCandidateIndex = engine->chunkIndexCandidateIndex;
+    header.chunkIndexTraversalCount = engine->chunkIndexTraversalCount;
+    memcpy(header.localSlots, engine->localSlots, sizeof header.localSlots);
+    header.localSlotCount = engine->localSlotCount;
+    memcpy(header.loadCache, engine->loadCache, sizeof header.loadCache);
+    header.namespaceGeneration = engine->namespaceGeneration;
+    memcpy
+        (header.characterStrings, engine->characterStrings,
+         sizeof header.characterStrings);
+    memcpy
+        (header.stringLiteralCache, engine->stringLiteralCache,
+         sizeof header.stringLiteralCache);
+    header.falseSingletonIndex = EntryIndex(engine, engine->falseSingleton);
+    header.trueSingletonIndex = EntryIndex(engine, engine->trueSingleton);
+    header.stackTopIndex = EntryIndex(engine, engine->stackTop);
+    header.stackCount = engine->stackCount;
+    header.peakStackCount = engine->peakStackCount;
+    header.modulesIndex = EntryIndex(engine, engine->modules);
+    header.systemModuleIndex = EntryIndex(engine, engine->systemModule);
+    header.moduleIndex = EntryIndex(engine, engine->module);
+    header.systemNamespaceIndex = EntryIndex
+        (engine, engine->systemNamespace);
+    header.globalNamespaceIndex = EntryIndex
+        (engine, engine->globalNamespace);
+    header.localNamespaceIndex = EntryIndex(engine, engine->localNamespace);
+    header.nextSymbol = engine->nextSymbol;
+
+    uint8_t *bytes = (uint8_t *)snapshot;
+    memcpy(bytes, &header, sizeof header);
+    memcpy
+        (bytes + sizeof header, engine->data,
+         engine->dataWatermark * sizeof(AspDataEntry));
+
+    return AspRunResult_OK;
+}
+
+AspRunResult AspRestoreSnapshot
+    (AspEngine *engine, const void *snapshot, size_t snapshotSize)
+{
+    /* As with a restart, any application function call in progress is
+       abandoned. Unlike a restart, statistics are left to accumulate. The
+       engine must have the same code loaded as when the snapshot was taken,
+       which is verified as far as possible. */
+    if (engine->appSpec == 0 || engine->inApp ||
+        (engine->state != AspEngineState_Ready &&
+         engine->state != AspEngineState_Running &&
+         engine->state != AspEngineState_RunError &&
+         engine->state != AspEngineState_Ended))
+        return AspRunResult_InvalidState;
+    if (snapshotSize < sizeof(SnapshotHeader))
+        return AspRunResult_ValueOutOfRange;
+    SnapshotHeader header;
+    const uint8_t *bytes = (const uint8_t *)snapshot;
+    memcpy(&header, bytes, sizeof header);
+    if (header.checkValue != engine->appSpec->checkValue ||
+        memcmp(header.version, engine->version, sizeof header.version) != 0 ||
+        header.dataEndIndex != engine->dataEndIndex ||
+        header.dataWatermark > header.dataEndIndex)
+        return AspRunResult_InitializationError;
+    if (snapshotSize !=
+        sizeof header + header.dataWatermark * sizeof(AspDataEntry))
+        return AspRunResult_ValueOutOfRange;
+
+    memcpy
+        (engine->data, bytes + sizeof header,
+         header.dataWatermark * sizeof(AspDataEntry));
+
+    engine->state = header.state;
+    engine->runResult = AspRunResult_OK;
+    engine->pc = header.pc;
+    engine->instructionAddress = header.instructionAddress;
+    engine->dataWatermark = header.dataWatermark;
+    engine->freeListIndex = header.freeListIndex;
+    engine->freeCount = header.freeCount;
+    engine->lowFreeCount = header.lowFreeCount;
+    memcpy
+        (engine->dataTypeCounts, header.dataTypeCounts,
+         sizeof engine->dataTypeCounts);
+    memcpy
+        (engine->sequenceIndexCache, header.sequenceIndexCache,
+         sizeof engine->sequenceIndexCache);
+    engine->sequenceIndexCacheNext = header.sequenceIndexCacheNext;
+    engine->chunkIndexCandidateIndex = header.chunkIndexCandidateIndex;
+    engine->chunkIndexTraversalCount = header.chunkIndexTraversalCount;
+    memcpy(engine->localSlots, header.localSlots, sizeof engine->localSlots);
+    engine->localSlotCount = header.localSlotCount;
+    memcpy(engine->loadCache, header.loadCache, sizeof engine->loadCache);
+    engine->namespaceGeneration = header.namespaceGeneration;
+    memcpy
+        (engine->characterStrings, header.characterStrings,
+         sizeof engine->characterStrings);
+    memcpy
+        (engine->stringLiteralCache, header.stringLiteralCache,
+         sizeof engine->stringLiteralCache);
+    engine->noneSingleton = engine->data;
+    engine->falseSingleton = AspEntry(engine, header.falseSingletonIndex);
+    engine->trueSingleton = AspEntry(engine, header.trueSingletonIndex);
+    engine->stackTop = AspEntry(engine, header.stackTopIndex);
+    engine->stackCount = header.stackCount;
+    engine->peakStackCount = header.peakStackCount;
+    engine->modules = AspEntry(engine, header.modulesIndex);
+    engine->systemModule = AspEntry(engine, header.systemModuleIndex);
+    engine->module = AspEntry(engine, header.moduleIndex);
+    engine->systemNamespace = AspEntry(engine, header.systemNamespaceIndex);
+    engine->globalNamespace = AspEntry(engine, header.globalNamespaceIndex);
+    engine->localNamespace = AspEntry(engine, header.localNamespaceIndex);
+    engine->again = false;
+    engine->callFromApp = false;
+    engine->callReturning = false;
+    engine->argumentList = 0;
+    engine->appFunction = 0;
+    engine->appFunctionNamespace = 0;
+    engine->appFunctionReturnValue = 0;
+    engine->nextSymbol = header.nextSymbol;
+
+    return AspRunResult_OK;
+}
+
+AspRunResult AspFork
+    (const AspEngine *engine, AspEngine *fork,
+     void *data, size_t dataSize, void *context)
+{
+    /* Forking is supported only for engines whose code is entirely in
+       memory or in a shared code page cache, as the fork shares the code
+       with the original engine. */
+    if (!IsSnapshotState(engine) ||
+        (engine->state != AspEngineState_Ready &&
+         engine->state != AspEngineState_Running) ||
+        engine->codePageCache == &engine->ownCodePageCache)
+        return AspRunResult_InvalidState;
+    if (data == 0)
+        return AspRunResult_InitializationError;
+    size_t dataEndIndex = dataSize / sizeof(AspDataEntry);
+    if (dataEndIndex < engine->dataWatermark)
+        return AspRunResult_OutOfDataMemory;
+
+    /* Copy the engine, then give the fork its own data area. The fork has
+       no code area of its own, so it cannot be reset to load other code,
+       but it can be restarted. */
+    *fork = *engine;
+    fork->context = context;
+    fork->codeArea = 0;
+    fork->maxCodeSize = 0;
+    fork->data = (AspDataEntry *)data;
+    fork->maxDataSize = dataSize;
+    fork->dataEndIndex = dataEndIndex;
+    size_t usedCount = engine->dataEndIndex - engine->freeCount;
+    fork->freeCount = dataEndIndex - usedCount;
+    fork->lowFreeCount = fork->freeCount;
+    fork->codePageReadCount = 0;
+    fork->codePageHitCount = 0;
+    fork->characterStringShareCount = 0;
+    fork->stringLiteralShareCount = 0;
+
+    /* Share the code pages of a paged engine, pinning the same page. */
+    if (engine->codePageCache != 0)
+    {
+        fork->codePageCache = 0;
+        if (!AspAttachCodePageCache(fork, engine->codePageCache))
+        {
+            fork->codePagePinned = false;
+            return AspRunResult_InitializationError;
+        }
+    }
+
+    memcpy
+        (fork->data, engine->data,
+         engine->dataWatermark * sizeof(AspDataEntry));
+
+    /* Refer to the fork's copies of the data entries. */
+    fork->noneSingleton = fork->data;
+    fork->falseSingleton = ForkEntry(engine, fork, engine->falseSingleton);
+    fork->trueSingleton = ForkEntry(engine, fork, engine->trueSingleton);
+    fork->stackTop = ForkEntry(engine, fork, engine->stackTop);
+    fork->modules = ForkEntry(engine, fork, engine->modules);
+    fork->systemModule = ForkEntry(engine, fork, engine->systemModule);
+    fork->module = ForkEntry(engine, fork, engine->module);
+    fork->systemNamespace = ForkEntry
+        (engine, fork, engine->systemNamespace);
+    fork->globalNamespace = ForkEntry
+        (engine, fork, engine->globalNamespace);
+    fork->localNamespace = ForkEntry(engine, fork, engine->localNamespace);
+
+    /* Do not share the deadline checker, instruction profiler, or profile
+       counters, whose context is unlikely to be safe to use from more than
+       one engine at a time. */
+    fork->deadlineChecker = 0;
+    fork->deadlineCheckerContext = 0;
+    fork->deadlineCheckInterval = 0;
+    #ifdef ASP_OPCODE_PROFILE
+    fork->opCodeProfiler = 0;
+    fork->opCodeProfilerContext = 0;
+    fork->profile = 0;
+    fork->profileOpCode = 0;
+    #endif
+
+    return AspRunResult_OK;
+}
+
+static bool IsSnapshotState(const AspEngine *engine)
+{
+    /* Snapshots exclude the state of application function calls, so are
+       not supported while one is in progress. */
+    return
+        engine->appSpec != 0 &&
+        !engine->inApp && !engine->again &&
+        !engine->callFromApp && !engine->callReturning;
+}
+
+static uint32_t EntryIndex(const AspEngine *engine, const AspDataEntry *entry)
+{
+    /* Index zero is the None singleton, which is never referenced by the
+       captured fields, so it serves to represent a null reference. */
+    return entry == 0 ? 0 : AspIndex(engine, entry);
+}
+
+static AspDataEntry *ForkEntry
+    (const AspEngine *engine, AspEngine *fork, const AspDataEntry *entry)
+{
+    return entry == 0 ? 0 : fork->data + (entry - engine->data);
+}
@@ -36,7 +36,8 @@ static AspDataEntry *AspPush1(AspEngine *engine, AspDataEntry *value, bool use)
     if (use)
         AspRef(engine, value);
     engine->stackTop = newTopEntry;
-    engine->stackCount++;
+    if (++engine->stackCount > engine->peakStackCount)
+        engine->peakStackCount = engine->stackCount;
 
     return newTopEntry;
 }
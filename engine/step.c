@@ -24,7 +24,45 @@
 #include <ctype.h>
 #endif
 
-static AspRunResult Step(AspEngine *);
+/* Threaded dispatch requires the labels-as-values compiler extension. When
+   not available, fall back to dispatching via the switch statement. */
+#if defined ASP_THREADED_DISPATCH && !defined __GNUC__
+#undef ASP_THREADED_DISPATCH
+#endif
+#ifdef ASP_THREADED_DISPATCH
+#define ASP_OPCODE_LABEL(name) Label_##name:
+#else
+#define ASP_OPCODE_LABEL(name)
+#endif
+
+/* Complete the current instruction and proceed to the next one. In
+   threaded mode, each instruction fetches its successor and jumps directly
+   to its handler, giving every handler its own indirect jump, which the
+   processor can predict separately. Otherwise, leave the switch, after
+   which the step limit is checked and control returns to the common fetch
+   point. */
+#ifdef ASP_THREADED_DISPATCH
+#define DISPATCH() \
+    do \
+    { \
+        if (engine->runResult != AspRunResult_OK || engine->again || \
+            *stepCount >= stepLimit) \
+            return AspRunResult_OK; \
+        AspRunResult fetchResult = FetchInstruction \
+            (engine, stepCount, &opCode); \
+        if (fetchResult != AspRunResult_OK) \
+            return fetchResult; \
+        operandSize = 0; \
+        goto *dispatchTable[opCode]; \
+    } while (false)
+#else
+#define DISPATCH() break
+#endif
+
+static AspRunResult Step
+    (AspEngine *, uint32_t stepLimit, uint32_t *stepCount);
+static inline AspRunResult FetchInstruction
+    (AspEngine *, uint32_t *stepCount, uint8_t *opCode);
 static AspRunResult LoadUnsignedWordOperand
     (AspEngine *engine, unsigned operandSize, uint32_t *operand);
 static AspRunResult LoadSignedWordOperand
@@ -35,9 +73,27 @@ static AspRunResult LoadSignedOperand
     (AspEngine *, unsigned operandSize, int32_t *operand);
 static AspRunResult LoadFloatOperand
     (AspEngine *, double *operand);
+static AspRunResult LoadStringOperand
+    (AspEngine *, uint32_t size, AspDataEntry **str);
+static AspDataEntry *FindStringLiteral(AspEngine *);
+static void RetainStringLiteral(AspEngine *, AspDataEntry *str);
+static AspRunResult LoadVariableValue
+    (AspEngine *, int32_t symbol, bool checkLocal);
+static AspRunResult FindGlobalVariable
+    (AspEngine *, int32_t symbol, AspDataEntry **node);
+static AspRunResult LoadVariableAddress(AspEngine *, int32_t symbol);
 
 AspRunResult AspStep(AspEngine *engine)
 {
+    return AspRun(engine, 1, 0);
+}
+
+AspRunResult AspRun
+    (AspEngine *engine, uint32_t stepLimit, uint32_t *stepCount)
+{
+    if (stepCount != 0)
+        *stepCount = 0;
+
     if (engine->inApp)
         return AspRunResult_InvalidState;
     if (engine->state == AspEngineState_Ready)
@@ -45,50 +101,235 @@ AspRunResult AspStep(AspEngine *engine)
     if (engine->state != AspEngineState_Running)
         return AspRunResult_InvalidState;
 
-    if (engine->runResult == AspRunResult_OK)
+    /* Step the engine and update the run result. Note that the run result
+       can be set via a return value (normal) or directly by the code (some
+       low-level routines). Direct updates take precedence as they indicate a
+       sort of failed assertion. */
+    uint32_t count = 0;
+    if (engine->runResult == AspRunResult_OK && stepLimit != 0)
     {
-        /* Step the engine and update the run result. Note that the
-           run result can be set via a return value (normal) or directly by
-           the code (some low-level routines). Direct updates take
-           precedence as they indicate a sort of failed assertion. */
-        AspRunResult stepResult = Step(engine);
-        if (engine->runResult == AspRunResult_OK)
-            engine->runResult = stepResult;
-        if (engine->runResult != AspRunResult_OK &&
-            engine->state != AspEngineState_Ended)
+        /* With a deadline checker, execute the instructions in batches of
+           the check interval, consulting the checker between batches, so
+           that instruction dispatch itself is unaffected. */
+        AspRunResult stepResult = AspRunResult_OK;
+        while (true)
         {
-            engine->pc = engine->instructionAddress;
-            engine->state = AspEngineState_RunError;
+            uint32_t batchLimit = stepLimit - count, batchCount = 0;
+            if (engine->deadlineChecker != 0 &&
+                batchLimit > engine->deadlineCheckInterval)
+                batchLimit = engine->deadlineCheckInterval;
+            stepResult = Step(engine, batchLimit, &batchCount);
+            count += batchCount;
+            if (stepResult != AspRunResult_OK ||
+                engine->runResult != AspRunResult_OK || engine->again ||
+                count >= stepLimit || engine->deadlineChecker == 0 ||
+                !engine->deadlineChecker(engine->deadlineCheckerContext))
+                break;
         }
+        if (engine->runResult == AspRunResult_OK)
+            engine->runResult = stepResult;
+    }
+    if (engine->runResult != AspRunResult_OK &&
+        engine->state != AspEngineState_Ended)
+    {
+        engine->pc = engine->instructionAddress;
+        engine->state = AspEngineState_RunError;
     }
 
+    if (stepCount != 0)
+        *stepCount = count;
     return engine->runResult;
 }
 
-static AspRunResult Step(AspEngine *engine)
+/* Execute instructions until the step limit is reached, an instruction
+   fails or ends the run, or an application function asks to be called
+   again. The step count is incremented before each instruction executes so
+   that it includes any instruction that ends the run. */
+static AspRunResult Step
+    (AspEngine *engine, uint32_t stepLimit, uint32_t *stepCount)
 {
-    #ifdef ASP_DEBUG
-    fprintf
-        (engine->traceFile, "@0x%07zX: ",
-         AspProgramCounter(engine));
+    #ifdef ASP_THREADED_DISPATCH
+    static const void *const dispatchTable[256] =
+    {
+        [0 ... 255] = &&Label_Invalid,
+        [OpCode_PUSHN] = &&Label_PUSHN,
+        [OpCode_PUSHE] = &&Label_PUSHE,
+        [OpCode_PUSHF] = &&Label_PUSHF,
+        [OpCode_PUSHT] = &&Label_PUSHT,
+        [OpCode_PUSHI0] = &&Label_PUSHI0,
+        [OpCode_PUSHI1] = &&Label_PUSHI1,
+        [OpCode_PUSHI2] = &&Label_PUSHI2,
+        [OpCode_PUSHI4] = &&Label_PUSHI4,
+        [OpCode_PUSHD] = &&Label_PUSHD,
+        [OpCode_PUSHY1] = &&Label_PUSHY1,
+        [OpCode_PUSHY2] = &&Label_PUSHY2,
+        [OpCode_PUSHY4] = &&Label_PUSHY4,
+        [OpCode_PUSHS0] = &&Label_PUSHS0,
+        [OpCode_PUSHS1] = &&Label_PUSHS1,
+        [OpCode_PUSHS2] = &&Label_PUSHS2,
+        [OpCode_PUSHS4] = &&Label_PUSHS4,
+        [OpCode_PUSHTU] = &&Label_PUSHTU,
+        [OpCode_PUSHLI] = &&Label_PUSHLI,
+        [OpCode_PUSHSE] = &&Label_PUSHSE,
+        [OpCode_PUSHDI] = &&Label_PUSHDI,
+        [OpCode_PUSHAL] = &&Label_PUSHAL,
+        [OpCode_PUSHPL] = &&Label_PUSHPL,
+        [OpCode_PUSHCA] = &&Label_PUSHCA,
+        [OpCode_PUSHM1] = &&Label_PUSHM1,
+        [OpCode_PUSHM2] = &&Label_PUSHM2,
+        [OpCode_PUSHM4] = &&Label_PUSHM4,
+        [OpCode_POP] = &&Label_POP,
+        [OpCode_POP1] = &&Label_POP1,
+        [OpCode_LNOT] = &&Label_LNOT,
+        [OpCode_POS] = &&Label_POS,
+        [OpCode_NEG] = &&Label_NEG,
+        [OpCode_NOT] = &&Label_NOT,
+        [OpCode_OR] = &&Label_OR,
+        [OpCode_XOR] = &&Label_XOR,
+        [OpCode_AND] = &&Label_AND,
+        [OpCode_LSH] = &&Label_LSH,
+        [OpCode_RSH] = &&Label_RSH,
+        [OpCode_ADD] = &&Label_ADD,
+        [OpCode_SUB] = &&Label_SUB,
+        [OpCode_MUL] = &&Label_MUL,
+        [OpCode_DIV] = &&Label_DIV,
+        [OpCode_FDIV] = &&Label_FDIV,
+        [OpCode_MOD] = &&Label_MOD,
+        [OpCode_POW] = &&Label_POW,
+        [OpCode_NE] = &&Label_NE,
+        [OpCode_EQ] = &&Label_EQ,
+        [OpCode_LT] = &&Label_LT,
+        [OpCode_LE] = &&Label_LE,
+        [OpCode_GT] = &&Label_GT,
+        [OpCode_GE] = &&Label_GE,
+        [OpCode_NIN] = &&Label_NIN,
+        [OpCode_IN] = &&Label_IN,
+        [OpCode_NIS] = &&Label_NIS,
+        [OpCode_IS] = &&Label_IS,
+        [OpCode_ORDER] = &&Label_ORDER,
+        [OpCode_BINI1] = &&Label_BINI1,
+        [OpCode_BINI2] = &&Label_BINI2,
+        [OpCode_BINI4] = &&Label_BINI4,
+        [OpCode_BJMPF] = &&Label_BJMPF,
+        [OpCode_BIJMPF1] = &&Label_BIJMPF1,
+        [OpCode_BIJMPF2] = &&Label_BIJMPF2,
+        [OpCode_BIJMPF4] = &&Label_BIJMPF4,
+        [OpCode_LD] = &&Label_LD,
+        [OpCode_LD1] = &&Label_LD1,
+        [OpCode_LD2] = &&Label_LD2,
+        [OpCode_LD4] = &&Label_LD4,
+        [OpCode_LDA] = &&Label_LDA,
+        [OpCode_LDA1] = &&Label_LDA1,
+        [OpCode_LDA2] = &&Label_LDA2,
+        [OpCode_LDA4] = &&Label_LDA4,
+        [OpCode_SLOTS] = &&Label_SLOTS,
+        [OpCode_LDL1] = &&Label_LDL1,
+        [OpCode_LDL2] = &&Label_LDL2,
+        [OpCode_LDL4] = &&Label_LDL4,
+        [OpCode_LDLA1] = &&Label_LDLA1,
+        [OpCode_LDLA2] = &&Label_LDLA2,
+        [OpCode_LDLA4] = &&Label_LDLA4,
+        [OpCode_SET] = &&Label_SET,
+        [OpCode_SETP] = &&Label_SETP,
+        [OpCode_SETOP] = &&Label_SETOP,
+        [OpCode_ERASE] = &&Label_ERASE,
+        [OpCode_DEL1] = &&Label_DEL1,
+        [OpCode_DEL2] = &&Label_DEL2,
+        [OpCode_DEL4] = &&Label_DEL4,
+        [OpCode_GLOB1] = &&Label_GLOB1,
+        [OpCode_GLOB2] = &&Label_GLOB2,
+        [OpCode_GLOB4] = &&Label_GLOB4,
+        [OpCode_LOC1] = &&Label_LOC1,
+        [OpCode_LOC2] = &&Label_LOC2,
+        [OpCode_LOC4] = &&Label_LOC4,
+        [OpCode_SITER] = &&Label_SITER,
+        [OpCode_TITER] = &&Label_TITER,
+        [OpCode_NITER] = &&Label_NITER,
+        [OpCode_DITER] = &&Label_DITER,
+        [OpCode_NOOP] = &&Label_NOOP,
+        [OpCode_JMPF] = &&Label_JMPF,
+        [OpCode_JMPT] = &&Label_JMPT,
+        [OpCode_JMP] = &&Label_JMP,
+        [OpCode_LOR] = &&Label_LOR,
+        [OpCode_LAND] = &&Label_LAND,
+        [OpCode_CALL] = &&Label_CALL,
+        [OpCode_RET] = &&Label_RET,
+        [OpCode_ADDMOD1] = &&Label_ADDMOD1,
+        [OpCode_ADDMOD2] = &&Label_ADDMOD2,
+        [OpCode_ADDMOD4] = &&Label_ADDMOD4,
+        [OpCode_XMOD] = &&Label_XMOD,
+        [OpCode_LDMOD1] = &&Label_LDMOD1,
+        [OpCode_LDMOD2] = &&Label_LDMOD2,
+        [OpCode_LDMOD4] = &&Label_LDMOD4,
+        [OpCode_MKARG] = &&Label_MKARG,
+        [OpCode_MKNARG1] = &&Label_MKNARG1,
+        [OpCode_MKNARG2] = &&Label_MKNARG2,
+        [OpCode_MKNARG4] = &&Label_MKNARG4,
+        [OpCode_MKIGARG] = &&Label_MKIGARG,
+        [OpCode_MKDGARG] = &&Label_MKDGARG,
+        [OpCode_MKPAR1] = &&Label_MKPAR1,
+        [OpCode_MKPAR2] = &&Label_MKPAR2,
+        [OpCode_MKPAR4] = &&Label_MKPAR4,
+        [OpCode_MKDPAR1] = &&Label_MKDPAR1,
+        [OpCode_MKDPAR2] = &&Label_MKDPAR2,
+        [OpCode_MKDPAR4] = &&Label_MKDPAR4,
+        [OpCode_MKTGPAR1] = &&Label_MKTGPAR1,
+        [OpCode_MKTGPAR2] = &&Label_MKTGPAR2,
+        [OpCode_MKTGPAR4] = &&Label_MKTGPAR4,
+        [OpCode_MKDGPAR1] = &&Label_MKDGPAR1,
+        [OpCode_MKDGPAR2] = &&Label_MKDGPAR2,
+        [OpCode_MKDGPAR4] = &&Label_MKDGPAR4,
+        [OpCode_MKFUN] = &&Label_MKFUN,
+        [OpCode_MKKVP] = &&Label_MKKVP,
+        [OpCode_MKR0] = &&Label_MKR0,
+        [OpCode_MKRS] = &&Label_MKRS,
+        [OpCode_MKRE] = &&Label_MKRE,
+        [OpCode_MKRSE] = &&Label_MKRSE,
+        [OpCode_MKRT] = &&Label_MKRT,
+        [OpCode_MKRST] = &&Label_MKRST,
+        [OpCode_MKRET] = &&Label_MKRET,
+        [OpCode_MKR] = &&Label_MKR,
+        [OpCode_INS] = &&Label_INS,
+        [OpCode_INSP] = &&Label_INSP,
+        [OpCode_BLD] = &&Label_BLD,
+        [OpCode_IDX] = &&Label_IDX,
+        [OpCode_IDXA] = &&Label_IDXA,
+        [OpCode_MEM] = &&Label_MEM,
+        [OpCode_MEM1] = &&Label_MEM1,
+        [OpCode_MEM2] = &&Label_MEM2,
+        [OpCode_MEM4] = &&Label_MEM4,
+        [OpCode_MEMA] = &&Label_MEMA,
+        [OpCode_MEMA1] = &&Label_MEMA1,
+        [OpCode_MEMA2] = &&Label_MEMA2,
+        [OpCode_MEMA4] = &&Label_MEMA4,
+        [OpCode_ABORT] = &&Label_ABORT,
+        [OpCode_END] = &&Label_END,
+    };
     #endif
 
-    engine->instructionAddress = engine->pc;
     uint8_t opCode;
-    AspRunResult opCodeResult = AspLoadCodeBytes(engine, &opCode, 1);
-    if (opCodeResult != AspRunResult_OK)
-        return opCodeResult;
-    #ifdef ASP_DEBUG
-    fprintf(engine->traceFile, "0x%02X ", opCode);
-    #endif
+    unsigned operandSize;
+
+    NextInstruction:
+    {
+        AspRunResult fetchResult = FetchInstruction
+            (engine, stepCount, &opCode);
+        if (fetchResult != AspRunResult_OK)
+            return fetchResult;
+    }
 
-    unsigned operandSize = 0;
+    operandSize = 0;
+    #ifdef ASP_THREADED_DISPATCH
+    goto *dispatchTable[opCode];
+    #endif
     switch (opCode)
     {
         default:
+        ASP_OPCODE_LABEL(Invalid)
             return AspRunResult_InvalidInstruction;
 
         case OpCode_PUSHN:
+        ASP_OPCODE_LABEL(PUSHN)
         {
             #ifdef ASP_DEBUG
             fputs("PUSHN\n", engine->traceFile);
@@ -99,10 +340,11 @@ static AspRunResult Step(AspEngine *engine)
             if (stackEntry == 0)
                 return AspRunResult_OutOfDataMemory;
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_PUSHE:
+        ASP_OPCODE_LABEL(PUSHE)
         {
             #ifdef ASP_DEBUG
             fputs("PUSHE\n", engine->traceFile);
@@ -117,11 +359,13 @@ static AspRunResult Step(AspEngine *engine)
                 return AspRunResult_OutOfDataMemory;
             AspUnref(engine, valueEntry);
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_PUSHF:
+        ASP_OPCODE_LABEL(PUSHF)
         case OpCode_PUSHT:
+        ASP_OPCODE_LABEL(PUSHT)
         {
             #ifdef ASP_DEBUG
             fprintf
@@ -139,16 +383,20 @@ static AspRunResult Step(AspEngine *engine)
                 return AspRunResult_OutOfDataMemory;
             AspUnref(engine, valueEntry);
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_PUSHI4:
+        ASP_OPCODE_LABEL(PUSHI4)
             operandSize += 2;
         case OpCode_PUSHI2:
+        ASP_OPCODE_LABEL(PUSHI2)
             operandSize++;
         case OpCode_PUSHI1:
+        ASP_OPCODE_LABEL(PUSHI1)
             operandSize++;
         case OpCode_PUSHI0:
+        ASP_OPCODE_LABEL(PUSHI0)
         {
             #ifdef ASP_DEBUG
             fputs("PUSHI ", engine->traceFile);
@@ -178,10 +426,11 @@ static AspRunResult Step(AspEngine *engine)
                 return AspRunResult_OutOfDataMemory;
             AspUnref(engine, valueEntry);
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_PUSHD:
+        ASP_OPCODE_LABEL(PUSHD)
         {
             #ifdef ASP_DEBUG
             fputs("PUSHD ", engine->traceFile);
@@ -211,14 +460,17 @@ static AspRunResult Step(AspEngine *engine)
                 return AspRunResult_OutOfDataMemory;
             AspUnref(engine, valueEntry);
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_PUSHY4:
+        ASP_OPCODE_LABEL(PUSHY4)
             operandSize += 2;
         case OpCode_PUSHY2:
+        ASP_OPCODE_LABEL(PUSHY2)
             operandSize++;
         case OpCode_PUSHY1:
+        ASP_OPCODE_LABEL(PUSHY1)
             operandSize++;
         {
             #ifdef ASP_DEBUG
@@ -249,16 +501,20 @@ static AspRunResult Step(AspEngine *engine)
                 return AspRunResult_OutOfDataMemory;
             AspUnref(engine, valueEntry);
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_PUSHS4:
+        ASP_OPCODE_LABEL(PUSHS4)
             operandSize += 2;
         case OpCode_PUSHS2:
+        ASP_OPCODE_LABEL(PUSHS2)
             operandSize++;
         case OpCode_PUSHS1:
+        ASP_OPCODE_LABEL(PUSHS1)
             operandSize++;
         case OpCode_PUSHS0:
+        ASP_OPCODE_LABEL(PUSHS0)
         {
             #ifdef ASP_DEBUG
             fputs("PUSHS ", engine->traceFile);
@@ -279,54 +535,51 @@ static AspRunResult Step(AspEngine *engine)
             fprintf(engine->traceFile, "%d, ", size);
             #endif
 
-            /* Validate the bytes of the string. */
-            #ifdef ASP_DEBUG
-            fputc('\'', engine->traceFile);
-            #endif
-            AspDataEntry *stringEntry = AspNewString(engine, 0, 0);
-            if (stringEntry == 0)
-                return AspRunResult_OutOfDataMemory;
-            for (uint32_t i = 0; i < size; i++)
+            /* Push the string retained from a previous execution of this
+               instruction if there is one, skipping over its bytes. Otherwise,
+               create the string, retaining it for subsequent executions. */
+            AspDataEntry *stringEntry = 0;
+            if (size > 1)
+                stringEntry = FindStringLiteral(engine);
+            if (stringEntry != 0)
             {
-                char c;
-                AspRunResult byteResult = AspLoadCodeBytes
-                    (engine, (uint8_t *)&c, 1);
-                if (byteResult != AspRunResult_OK)
-                {
-                    #ifdef ASP_DEBUG
-                    fputc('\n', engine->traceFile);
-                    #endif
-                    return byteResult;
-                }
-                AspRunResult appendResult = AspStringAppendBuffer
-                    (engine, stringEntry, &c, 1);
-                if (appendResult != AspRunResult_OK)
-                    return appendResult;
-
                 #ifdef ASP_DEBUG
-                if (c == '\'')
-                    fputc('\\', engine->traceFile);
-                fputc(isprint(c) ? c : '.', engine->traceFile);
+                fputs("(retained)\n", engine->traceFile);
                 #endif
+                engine->pc += size;
+                if (engine->stringLiteralShareCount < SIZE_MAX)
+                    engine->stringLiteralShareCount++;
+            }
+            else
+            {
+                AspRunResult loadResult = LoadStringOperand
+                    (engine, size, &stringEntry);
+                if (loadResult != AspRunResult_OK)
+                    return loadResult;
+                if (size > 1)
+                    RetainStringLiteral(engine, stringEntry);
             }
-            #ifdef ASP_DEBUG
-            fputs("'\n", engine->traceFile);
-            #endif
 
             const AspDataEntry *stackEntry = AspPush(engine, stringEntry);
             if (stackEntry == 0)
                 return AspRunResult_OutOfDataMemory;
             AspUnref(engine, stringEntry);
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_PUSHTU:
+        ASP_OPCODE_LABEL(PUSHTU)
         case OpCode_PUSHLI:
+        ASP_OPCODE_LABEL(PUSHLI)
         case OpCode_PUSHSE:
+        ASP_OPCODE_LABEL(PUSHSE)
         case OpCode_PUSHDI:
+        ASP_OPCODE_LABEL(PUSHDI)
         case OpCode_PUSHAL:
+        ASP_OPCODE_LABEL(PUSHAL)
         case OpCode_PUSHPL:
+        ASP_OPCODE_LABEL(PUSHPL)
         {
             #ifdef ASP_DEBUG
             const char *suffix = 0;
@@ -394,10 +647,11 @@ static AspRunResult Step(AspEngine *engine)
             if (AspIsObject(valueEntry))
                 AspUnref(engine, valueEntry);
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_PUSHCA:
+        ASP_OPCODE_LABEL(PUSHCA)
         {
             #ifdef ASP_DEBUG
             fputs("PUSHCA ", engine->traceFile);
@@ -417,7 +671,7 @@ static AspRunResult Step(AspEngine *engine)
             #ifdef ASP_DEBUG
             fprintf(engine->traceFile, "@0x%07X\n", codeAddressOperand);
             #endif
-            AspRunResult validateResult = AspValidateCodeAddress
+            AspRunResult validateResult = AspValidateCodeTarget
                 (engine, codeAddressOperand);
             if (validateResult != AspRunResult_OK)
                 return validateResult;
@@ -431,14 +685,17 @@ static AspRunResult Step(AspEngine *engine)
             if (stackEntry == 0)
                 return AspRunResult_OutOfDataMemory;
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_PUSHM4:
+        ASP_OPCODE_LABEL(PUSHM4)
             operandSize += 2;
         case OpCode_PUSHM2:
+        ASP_OPCODE_LABEL(PUSHM2)
             operandSize++;
         case OpCode_PUSHM1:
+        ASP_OPCODE_LABEL(PUSHM1)
             operandSize++;
         {
             #ifdef ASP_DEBUG
@@ -476,12 +733,14 @@ static AspRunResult Step(AspEngine *engine)
             if (stackEntry == 0)
                 return AspRunResult_OutOfDataMemory;
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_POP1:
+        ASP_OPCODE_LABEL(POP1)
             operandSize++;
         case OpCode_POP:
+        ASP_OPCODE_LABEL(POP)
         {
             #ifdef ASP_DEBUG
             fputs("POP", engine->traceFile);
@@ -518,13 +777,17 @@ static AspRunResult Step(AspEngine *engine)
                 AspPop(engine);
             }
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_LNOT:
+        ASP_OPCODE_LABEL(LNOT)
         case OpCode_POS:
+        ASP_OPCODE_LABEL(POS)
         case OpCode_NEG:
+        ASP_OPCODE_LABEL(NEG)
         case OpCode_NOT:
+        ASP_OPCODE_LABEL(NOT)
         {
             #ifdef ASP_DEBUG
             fputs("Unary op\n", engine->traceFile);
@@ -555,32 +818,55 @@ static AspRunResult Step(AspEngine *engine)
                 return engine->runResult;
             AspUnref(engine, operand);
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_OR:
+        ASP_OPCODE_LABEL(OR)
         case OpCode_XOR:
+        ASP_OPCODE_LABEL(XOR)
         case OpCode_AND:
+        ASP_OPCODE_LABEL(AND)
         case OpCode_LSH:
+        ASP_OPCODE_LABEL(LSH)
         case OpCode_RSH:
+        ASP_OPCODE_LABEL(RSH)
         case OpCode_ADD:
+        ASP_OPCODE_LABEL(ADD)
         case OpCode_SUB:
+        ASP_OPCODE_LABEL(SUB)
         case OpCode_MUL:
+        ASP_OPCODE_LABEL(MUL)
         case OpCode_DIV:
+        ASP_OPCODE_LABEL(DIV)
         case OpCode_FDIV:
+        ASP_OPCODE_LABEL(FDIV)
         case OpCode_MOD:
+        ASP_OPCODE_LABEL(MOD)
         case OpCode_POW:
+        ASP_OPCODE_LABEL(POW)
         case OpCode_NE:
+        ASP_OPCODE_LABEL(NE)
         case OpCode_EQ:
+        ASP_OPCODE_LABEL(EQ)
         case OpCode_LT:
+        ASP_OPCODE_LABEL(LT)
         case OpCode_LE:
+        ASP_OPCODE_LABEL(LE)
         case OpCode_GT:
+        ASP_OPCODE_LABEL(GT)
         case OpCode_GE:
+        ASP_OPCODE_LABEL(GE)
         case OpCode_NIN:
+        ASP_OPCODE_LABEL(NIN)
         case OpCode_IN:
+        ASP_OPCODE_LABEL(IN)
         case OpCode_NIS:
+        ASP_OPCODE_LABEL(NIS)
         case OpCode_IS:
+        ASP_OPCODE_LABEL(IS)
         case OpCode_ORDER:
+        ASP_OPCODE_LABEL(ORDER)
         {
             #ifdef ASP_DEBUG
             fputs("Binary op\n", engine->traceFile);
@@ -623,16 +909,153 @@ static AspRunResult Step(AspEngine *engine)
                 return engine->runResult;
             AspUnref(engine, right);
 
-            break;
+            DISPATCH();
+        }
+
+        case OpCode_BINI4:
+        ASP_OPCODE_LABEL(BINI4)
+        case OpCode_BIJMPF4:
+        ASP_OPCODE_LABEL(BIJMPF4)
+            operandSize += 2;
+        case OpCode_BINI2:
+        ASP_OPCODE_LABEL(BINI2)
+        case OpCode_BIJMPF2:
+        ASP_OPCODE_LABEL(BIJMPF2)
+            operandSize++;
+        case OpCode_BINI1:
+        ASP_OPCODE_LABEL(BINI1)
+        case OpCode_BIJMPF1:
+        ASP_OPCODE_LABEL(BIJMPF1)
+            operandSize++;
+        case OpCode_BJMPF:
+        ASP_OPCODE_LABEL(BJMPF)
+        {
+            bool jump =
+                opCode == OpCode_BJMPF ||
+                opCode == OpCode_BIJMPF1 ||
+                opCode == OpCode_BIJMPF2 ||
+                opCode == OpCode_BIJMPF4;
+
+            #ifdef ASP_DEBUG
+            fputs
+                (!jump ? "BINI " : operandSize > 0 ? "BIJMPF " : "BJMPF ",
+                 engine->traceFile);
+            #endif
+
+            /* Fetch the operation, the immediate right operand if
+               applicable, and the code address if applicable. */
+            uint32_t operation;
+            int32_t immediateValue = 0;
+            uint32_t codeAddress = 0;
+            AspRunResult operandLoadResult = LoadUnsignedOperand
+                (engine, 1, &operation);
+            if (operandLoadResult == AspRunResult_OK && operandSize > 0)
+                operandLoadResult = LoadSignedOperand
+                    (engine, operandSize, &immediateValue);
+            if (operandLoadResult == AspRunResult_OK && jump)
+                operandLoadResult = LoadUnsignedWordOperand
+                    (engine, 4, &codeAddress);
+            if (operandLoadResult != AspRunResult_OK)
+            {
+                #ifdef ASP_DEBUG
+                fputs("?\n", engine->traceFile);
+                #endif
+                return operandLoadResult;
+            }
+            #ifdef ASP_DEBUG
+            fprintf(engine->traceFile, "0x%02X", operation);
+            if (operandSize > 0)
+                fprintf(engine->traceFile, " %d", immediateValue);
+            if (jump)
+                fprintf(engine->traceFile, " @0x%07X", codeAddress);
+            fputc('\n', engine->traceFile);
+            #endif
+            if (jump)
+            {
+                AspRunResult validateResult = AspValidateCodeTarget
+                    (engine, codeAddress);
+                if (validateResult != AspRunResult_OK)
+                    return validateResult;
+            }
+
+            /* Obtain the right value. An immediate value is held in a
+               temporary entry outside the data area, which is safe only
+               for operations that merely examine the operand's value. */
+            AspDataEntry immediateEntry;
+            AspDataEntry *right;
+            if (operandSize > 0)
+            {
+                if (operation == OpCode_NIN || operation == OpCode_IN ||
+                    operation == OpCode_NIS || operation == OpCode_IS)
+                    return AspRunResult_InvalidInstruction;
+                memset(&immediateEntry, 0, sizeof immediateEntry);
+                AspDataSetType(&immediateEntry, DataType_Integer);
+                AspDataSetInteger(&immediateEntry, immediateValue);
+                right = &immediateEntry;
+            }
+            else
+            {
+                right = AspTopValue(engine);
+                if (right == 0)
+                    return AspRunResult_StackUnderflow;
+                if (!AspIsObject(right))
+                    return AspRunResult_UnexpectedType;
+                AspRef(engine, right);
+                AspPop(engine);
+            }
+
+            /* Fetch the left value from the stack. */
+            AspDataEntry *left = AspTopValue(engine);
+            if (left == 0)
+                return AspRunResult_StackUnderflow;
+            if (!AspIsObject(left))
+                return AspRunResult_UnexpectedType;
+            AspRef(engine, left);
+            AspPop(engine);
+
+            /* Perform the operation. */
+            AspOperationResult operationResult = AspPerformBinaryOperation
+                (engine, (uint8_t)operation, left, right);
+            if (operationResult.result != AspRunResult_OK)
+                return operationResult.result;
+
+            /* Either push the result onto the stack, or transfer control
+               to the code address if the result is false. */
+            if (jump)
+            {
+                if (!AspIsTrue(engine, operationResult.value))
+                    engine->pc = codeAddress;
+            }
+            else
+            {
+                const AspDataEntry *stackEntry = AspPush
+                    (engine, operationResult.value);
+                if (stackEntry == 0)
+                    return AspRunResult_OutOfDataMemory;
+            }
+            AspUnref(engine, operationResult.value);
+            if (engine->runResult != AspRunResult_OK)
+                return engine->runResult;
+            AspUnref(engine, left);
+            if (engine->runResult != AspRunResult_OK)
+                return engine->runResult;
+            if (operandSize == 0)
+                AspUnref(engine, right);
+
+            DISPATCH();
         }
 
         case OpCode_LD4:
+        ASP_OPCODE_LABEL(LD4)
             operandSize += 2;
         case OpCode_LD2:
+        ASP_OPCODE_LABEL(LD2)
             operandSize++;
         case OpCode_LD1:
+        ASP_OPCODE_LABEL(LD1)
             operandSize++;
         case OpCode_LD:
+        ASP_OPCODE_LABEL(LD)
         {
             #ifdef ASP_DEBUG
             fputs("LD ", engine->traceFile);
@@ -670,52 +1093,25 @@ static AspRunResult Step(AspEngine *engine)
             fputc('\n', engine->traceFile);
             #endif
 
-            /* Look up the variable, trying first the local namespace, and
-               then failing that, the global and system namespaces in turn.
-               Note that a local variable can also defer to the global
-               namespace via a global override. */
-            AspTreeResult findResult = AspFindSymbol
-                (engine, engine->localNamespace, variableSymbol);
-            if (findResult.result != AspRunResult_OK)
-                return findResult.result;
-            if ((findResult.node == 0 ||
-                 AspDataGetNamespaceNodeIsGlobal(findResult.node)) &&
-                engine->globalNamespace != engine->localNamespace)
-            {
-                findResult = AspFindSymbol
-                    (engine, engine->globalNamespace, variableSymbol);
-                if (findResult.result != AspRunResult_OK)
-                    return findResult.result;
-            }
-            if (findResult.node == 0)
-            {
-                findResult = AspFindSymbol
-                    (engine, engine->systemNamespace, variableSymbol);
-                if (findResult.result != AspRunResult_OK)
-                    return findResult.result;
-            }
-            if (findResult.node == 0)
-                return AspRunResult_NameNotFound;
-
-            /* Push variable's value. */
-            AspDataEntry *object = AspValueEntry
-                (engine, AspDataGetTreeNodeValueIndex(findResult.node));
-            if (!AspIsObject(object))
-                return AspRunResult_UnexpectedType;
-            const AspDataEntry *stackEntry = AspPush(engine, object);
-            if (stackEntry == 0)
-                return AspRunResult_OutOfDataMemory;
+            AspRunResult loadResult = LoadVariableValue
+                (engine, variableSymbol, true);
+            if (loadResult != AspRunResult_OK)
+                return loadResult;
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_LDA4:
+        ASP_OPCODE_LABEL(LDA4)
             operandSize += 2;
         case OpCode_LDA2:
+        ASP_OPCODE_LABEL(LDA2)
             operandSize++;
         case OpCode_LDA1:
+        ASP_OPCODE_LABEL(LDA1)
             operandSize++;
         case OpCode_LDA:
+        ASP_OPCODE_LABEL(LDA)
         {
 
             #ifdef ASP_DEBUG
@@ -754,37 +1150,152 @@ static AspRunResult Step(AspEngine *engine)
             fputc('\n', engine->traceFile);
             #endif
 
-            /* Look up the variable, creating it if it doesn't exist. */
-            AspTreeResult insertResult = AspTreeTryInsertBySymbol
-                (engine, engine->localNamespace,
-                 variableSymbol, engine->noneSingleton);
-            if (insertResult.result != AspRunResult_OK)
-                return insertResult.result;
-            const AspDataEntry *node = insertResult.node;
+            AspRunResult loadResult = LoadVariableAddress
+                (engine, variableSymbol);
+            if (loadResult != AspRunResult_OK)
+                return loadResult;
 
-            /* Set the scope usage for the newly created variable. */
-            if (AspDataGetNamespaceNodeIsGlobal(node) &&
-                engine->localNamespace != engine->globalNamespace)
+            DISPATCH();
+        }
+
+        case OpCode_SLOTS:
+        ASP_OPCODE_LABEL(SLOTS)
+        {
+            #ifdef ASP_DEBUG
+            fputs("SLOTS ", engine->traceFile);
+            #endif
+
+            /* Fetch the number of slots from the operand. */
+            uint32_t count;
+            AspRunResult operandLoadResult = LoadUnsignedOperand
+                (engine, 1, &count);
+            if (operandLoadResult != AspRunResult_OK)
             {
-                /* Use global scope because of global override. */
-                insertResult = AspTreeTryInsertBySymbol
-                    (engine, engine->globalNamespace,
-                     variableSymbol, engine->noneSingleton);
-                if (insertResult.result != AspRunResult_OK)
-                    return insertResult.result;
+                #ifdef ASP_DEBUG
+                fputs("?\n", engine->traceFile);
+                #endif
+                return operandLoadResult;
             }
+            #ifdef ASP_DEBUG
+            fprintf(engine->traceFile, "%u\n", count);
+            #endif
 
-            /* Push the variable's tree node to serve as an address. */
-            const AspDataEntry *stackEntry = AspPush
-                (engine, insertResult.node);
+            /* Ensure we're in the context of a function. */
+            if (engine->localNamespace == engine->globalNamespace)
+                return AspRunResult_InvalidContext;
+
+            /* Reserve the call's slots all at once. Should too few remain,
+               the call's variables are looked up by symbol instead. */
+            AspReserveNamespaceSlots(engine, engine->localNamespace, count);
+
+            DISPATCH();
+        }
+
+        case OpCode_LDL4:
+        ASP_OPCODE_LABEL(LDL4)
+        case OpCode_LDLA4:
+        ASP_OPCODE_LABEL(LDLA4)
+            operandSize += 2;
+        case OpCode_LDL2:
+        ASP_OPCODE_LABEL(LDL2)
+        case OpCode_LDLA2:
+        ASP_OPCODE_LABEL(LDLA2)
+            operandSize++;
+        case OpCode_LDL1:
+        ASP_OPCODE_LABEL(LDL1)
+        case OpCode_LDLA1:
+        ASP_OPCODE_LABEL(LDLA1)
+            operandSize++;
+        {
+            bool address =
+                opCode == OpCode_LDLA1 ||
+                opCode == OpCode_LDLA2 ||
+                opCode == OpCode_LDLA4;
+
+            #ifdef ASP_DEBUG
+            fputs(address ? "LDLA " : "LDL ", engine->traceFile);
+            #endif
+
+            /* Fetch the slot number and the variable's symbol from the
+               operands. */
+            uint32_t slot;
+            int32_t variableSymbol;
+            AspRunResult operandLoadResult = LoadUnsignedOperand
+                (engine, 1, &slot);
+            if (operandLoadResult == AspRunResult_OK)
+                operandLoadResult = LoadSignedWordOperand
+                    (engine, operandSize, &variableSymbol);
+            if (operandLoadResult != AspRunResult_OK)
+            {
+                #ifdef ASP_DEBUG
+                fputs("?\n", engine->traceFile);
+                #endif
+                return operandLoadResult;
+            }
+            #ifdef ASP_DEBUG
+            fprintf(engine->traceFile, "%u %d\n", slot, variableSymbol);
+            #endif
+
+            /* Use the variable's node directly if the slot refers to it.
+               Otherwise, look up the variable in the local namespace and
+               record its node in the slot for subsequent use, provided the
+               call was able to reserve its slots. Variables with a global
+               override are never recorded. */
+            AspDataEntry *ns = engine->localNamespace;
+            AspDataEntry *node = 0;
+            if (ns != engine->globalNamespace)
+            {
+                node = AspNamespaceSlotNode(engine, ns, slot);
+                if (node != 0 &&
+                    AspDataGetNamespaceNodeSymbol(node) != variableSymbol)
+                    node = 0;
+                if (node == 0)
+                {
+                    AspTreeResult findResult = AspFindSymbol
+                        (engine, ns, variableSymbol);
+                    if (findResult.result != AspRunResult_OK)
+                        return findResult.result;
+                    node = findResult.node;
+                    if (node != 0 && !AspDataGetNamespaceNodeIsGlobal(node))
+                        AspSetNamespaceSlotNode(engine, ns, slot, node);
+                }
+                if (node != 0 && AspDataGetNamespaceNodeIsGlobal(node))
+                    node = 0;
+            }
+
+            /* Fall back to the usual lookup rules when the variable is not
+               a local one. */
+            if (node == 0)
+            {
+                AspRunResult loadResult = address ?
+                    LoadVariableAddress(engine, variableSymbol) :
+                    LoadVariableValue(engine, variableSymbol, false);
+                if (loadResult != AspRunResult_OK)
+                    return loadResult;
+                DISPATCH();
+            }
+
+            /* Push the variable's value, or its node to serve as an
+               address. */
+            AspDataEntry *object = node;
+            if (!address)
+            {
+                object = AspValueEntry
+                    (engine, AspDataGetTreeNodeValueIndex(node));
+                if (!AspIsObject(object))
+                    return AspRunResult_UnexpectedType;
+            }
+            const AspDataEntry *stackEntry = AspPush(engine, object);
             if (stackEntry == 0)
                 return AspRunResult_OutOfDataMemory;
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_SET:
+        ASP_OPCODE_LABEL(SET)
         case OpCode_SETP:
+        ASP_OPCODE_LABEL(SETP)
         {
             #ifdef ASP_DEBUG
             fprintf
@@ -814,10 +1325,95 @@ static AspRunResult Step(AspEngine *engine)
                 return assignResult;
             if (opCode == OpCode_SETP)
                 AspPop(engine);
-            break;
+            DISPATCH();
+        }
+
+        case OpCode_SETOP:
+        ASP_OPCODE_LABEL(SETOP)
+        {
+            #ifdef ASP_DEBUG
+            fputs("SETOP ", engine->traceFile);
+            #endif
+
+            /* Fetch the operation. */
+            uint32_t operation;
+            AspRunResult operandLoadResult = LoadUnsignedOperand
+                (engine, 1, &operation);
+            if (operandLoadResult != AspRunResult_OK)
+            {
+                #ifdef ASP_DEBUG
+                fputs("?\n", engine->traceFile);
+                #endif
+                return operandLoadResult;
+            }
+            #ifdef ASP_DEBUG
+            fprintf(engine->traceFile, "0x%02X\n", operation);
+            #endif
+
+            /* Obtain destination from the stack. */
+            AspDataEntry *address = AspTopValue(engine);
+            if (address == 0)
+                return AspRunResult_StackUnderflow;
+            uint8_t addressType = AspDataGetType(address);
+            if (addressType != DataType_Element &&
+                addressType != DataType_DictionaryNode &&
+                addressType != DataType_NamespaceNode)
+                return AspRunResult_UnexpectedType;
+            AspPop(engine);
+
+            /* Access the right value from the stack. */
+            AspDataEntry *right = AspTopValue(engine);
+            if (right == 0)
+                return AspRunResult_StackUnderflow;
+            if (!AspIsObject(right))
+                return AspRunResult_UnexpectedType;
+            AspRef(engine, right);
+            AspPop(engine);
+
+            /* Fetch the left value from the stack. */
+            AspDataEntry *left = AspTopValue(engine);
+            if (left == 0)
+                return AspRunResult_StackUnderflow;
+            if (!AspIsObject(left))
+                return AspRunResult_UnexpectedType;
+            AspRef(engine, left);
+            AspPop(engine);
+
+            /* Perform the operation, updating the left value in place if
+               the only references to it are the one held by the
+               destination and the one just taken from the stack. */
+            uint32_t currentValueIndex = addressType == DataType_Element ?
+                AspDataGetElementValueIndex(address) :
+                AspDataGetTreeNodeValueIndex(address);
+            bool inPlace =
+                currentValueIndex == AspIndex(engine, left) &&
+                AspDataGetUseCount(left) == 2;
+            AspOperationResult operationResult = inPlace ?
+                AspPerformInPlaceBinaryOperation
+                    (engine, (uint8_t)operation, left, right) :
+                AspPerformBinaryOperation
+                    (engine, (uint8_t)operation, left, right);
+            if (operationResult.result != AspRunResult_OK)
+                return operationResult.result;
+
+            /* Assign the result. */
+            AspRunResult assignResult = AspAssignSimple
+                (engine, address, operationResult.value);
+            if (assignResult != AspRunResult_OK)
+                return assignResult;
+            AspUnref(engine, operationResult.value);
+            if (engine->runResult != AspRunResult_OK)
+                return engine->runResult;
+            AspUnref(engine, left);
+            if (engine->runResult != AspRunResult_OK)
+                return engine->runResult;
+            AspUnref(engine, right);
+
+            DISPATCH();
         }
 
         case OpCode_ERASE:
+        ASP_OPCODE_LABEL(ERASE)
         {
             #ifdef ASP_DEBUG
             fputs("ERASE\n", engine->traceFile);
@@ -993,14 +1589,17 @@ static AspRunResult Step(AspEngine *engine)
                 return engine->runResult;
             AspUnref(engine, container);
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_DEL4:
+        ASP_OPCODE_LABEL(DEL4)
             operandSize += 2;
         case OpCode_DEL2:
+        ASP_OPCODE_LABEL(DEL2)
             operandSize++;
         case OpCode_DEL1:
+        ASP_OPCODE_LABEL(DEL1)
             operandSize++;
         {
             #ifdef ASP_DEBUG
@@ -1052,14 +1651,17 @@ static AspRunResult Step(AspEngine *engine)
             if (eraseResult != AspRunResult_OK)
                 return eraseResult;
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_GLOB4:
+        ASP_OPCODE_LABEL(GLOB4)
             operandSize += 2;
         case OpCode_GLOB2:
+        ASP_OPCODE_LABEL(GLOB2)
             operandSize++;
         case OpCode_GLOB1:
+        ASP_OPCODE_LABEL(GLOB1)
             operandSize++;
         {
             #ifdef ASP_DEBUG
@@ -1113,14 +1715,17 @@ static AspRunResult Step(AspEngine *engine)
             /* Mark the variable with a global override. */
             AspDataSetNamespaceNodeIsGlobal(node, true);
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_LOC4:
+        ASP_OPCODE_LABEL(LOC4)
             operandSize += 2;
         case OpCode_LOC2:
+        ASP_OPCODE_LABEL(LOC2)
             operandSize++;
         case OpCode_LOC1:
+        ASP_OPCODE_LABEL(LOC1)
             operandSize++;
         {
             #ifdef ASP_DEBUG
@@ -1171,10 +1776,11 @@ static AspRunResult Step(AspEngine *engine)
             else
                 AspDataSetNamespaceNodeIsGlobal(node, false);
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_SITER:
+        ASP_OPCODE_LABEL(SITER)
         {
             #ifdef ASP_DEBUG
             fputs("SITER\n", engine->traceFile);
@@ -1198,10 +1804,11 @@ static AspRunResult Step(AspEngine *engine)
                 (engine->stackTop, AspIndex(engine, iteratorResult.value));
             AspUnref(engine, iterable);
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_TITER:
+        ASP_OPCODE_LABEL(TITER)
         {
             #ifdef ASP_DEBUG
             fputs("TITER\n", engine->traceFile);
@@ -1224,10 +1831,11 @@ static AspRunResult Step(AspEngine *engine)
                 return AspRunResult_OutOfDataMemory;
             AspUnref(engine, testResult);
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_NITER:
+        ASP_OPCODE_LABEL(NITER)
         {
             #ifdef ASP_DEBUG
             fputs("NITER\n", engine->traceFile);
@@ -1246,10 +1854,11 @@ static AspRunResult Step(AspEngine *engine)
             if (iteratorResult != AspRunResult_OK)
                 return iteratorResult;
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_DITER:
+        ASP_OPCODE_LABEL(DITER)
         {
             #ifdef ASP_DEBUG
             fputs("DITER\n", engine->traceFile);
@@ -1275,21 +1884,27 @@ static AspRunResult Step(AspEngine *engine)
             if (AspIsObject(iteratorResult.value))
                 AspUnref(engine, iteratorResult.value);
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_NOOP:
+        ASP_OPCODE_LABEL(NOOP)
             #ifdef ASP_DEBUG
             fputs("NOOP\n", engine->traceFile);
             #endif
 
-            break;
+            DISPATCH();
 
         case OpCode_JMPF:
+        ASP_OPCODE_LABEL(JMPF)
         case OpCode_JMPT:
+        ASP_OPCODE_LABEL(JMPT)
         case OpCode_JMP:
+        ASP_OPCODE_LABEL(JMP)
         case OpCode_LOR:
+        ASP_OPCODE_LABEL(LOR)
         case OpCode_LAND:
+        ASP_OPCODE_LABEL(LAND)
         {
             #ifdef ASP_DEBUG
             fprintf
@@ -1314,7 +1929,7 @@ static AspRunResult Step(AspEngine *engine)
             #ifdef ASP_DEBUG
             fprintf(engine->traceFile, "@0x%07X\n", codeAddress);
             #endif
-            AspRunResult validateResult = AspValidateCodeAddress
+            AspRunResult validateResult = AspValidateCodeTarget
                 (engine, codeAddress);
             if (validateResult != AspRunResult_OK)
                 return validateResult;
@@ -1341,10 +1956,11 @@ static AspRunResult Step(AspEngine *engine)
             if (condition == (opCode != OpCode_JMPF && opCode != OpCode_LAND))
                 engine->pc = codeAddress;
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_CALL:
+        ASP_OPCODE_LABEL(CALL)
         {
             #ifdef ASP_DEBUG
             fputs("CALL\n", engine->traceFile);
@@ -1379,10 +1995,11 @@ static AspRunResult Step(AspEngine *engine)
             if (function != 0)
                 AspUnref(engine, function);
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_RET:
+        ASP_OPCODE_LABEL(RET)
         {
             #ifdef ASP_DEBUG
             fputs("RET\n", engine->traceFile);
@@ -1401,7 +2018,9 @@ static AspRunResult Step(AspEngine *engine)
             AspRef(engine, returnValue);
             AspPop(engine);
 
-            /* Discard the function's local namespace. */
+            /* Discard the function's local namespace, giving up its
+               variable slots. */
+            AspReleaseNamespaceSlots(engine, engine->localNamespace);
             AspUnref(engine, engine->localNamespace);
             if (engine->runResult != AspRunResult_OK)
                 return engine->runResult;
@@ -1418,14 +2037,17 @@ static AspRunResult Step(AspEngine *engine)
             if (engine->runResult != AspRunResult_OK)
                 return engine->runResult;
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_ADDMOD4:
+        ASP_OPCODE_LABEL(ADDMOD4)
             operandSize += 2;
         case OpCode_ADDMOD2:
+        ASP_OPCODE_LABEL(ADDMOD2)
             operandSize++;
         case OpCode_ADDMOD1:
+        ASP_OPCODE_LABEL(ADDMOD1)
             operandSize++;
         {
             #ifdef ASP_DEBUG
@@ -1461,7 +2083,7 @@ static AspRunResult Step(AspEngine *engine)
             #ifdef ASP_DEBUG
             fprintf(engine->traceFile, "0x%07X\n", codeAddress);
             #endif
-            AspRunResult validateResult = AspValidateCodeAddress
+            AspRunResult validateResult = AspValidateCodeTarget
                 (engine, codeAddress);
             if (validateResult != AspRunResult_OK)
                 return validateResult;
@@ -1495,10 +2117,11 @@ static AspRunResult Step(AspEngine *engine)
             if (addResult.inserted)
                 AspUnref(engine, module);
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_XMOD:
+        ASP_OPCODE_LABEL(XMOD)
         {
             #ifdef ASP_DEBUG
             fputs("XMOD\n", engine->traceFile);
@@ -1534,14 +2157,17 @@ static AspRunResult Step(AspEngine *engine)
             /* Return control to the caller. */
             engine->pc = returnAddress;
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_LDMOD4:
+        ASP_OPCODE_LABEL(LDMOD4)
             operandSize += 2;
         case OpCode_LDMOD2:
+        ASP_OPCODE_LABEL(LDMOD2)
             operandSize++;
         case OpCode_LDMOD1:
+        ASP_OPCODE_LABEL(LDMOD1)
             operandSize++;
         {
             #ifdef ASP_DEBUG
@@ -1576,7 +2202,7 @@ static AspRunResult Step(AspEngine *engine)
 
             /* Run the module on first load. */
             if (AspDataGetModuleIsLoaded(module))
-                break;
+                DISPATCH();
             AspDataSetModuleIsLoaded(module, true);
 
             /* Set the system __main__ variable to the first loaded module. */
@@ -1611,12 +2237,15 @@ static AspRunResult Step(AspEngine *engine)
             /* Transfer control to the module's code. */
             engine->pc = AspDataGetModuleCodeAddress(module);
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_MKARG:
+        ASP_OPCODE_LABEL(MKARG)
         case OpCode_MKIGARG:
+        ASP_OPCODE_LABEL(MKIGARG)
         case OpCode_MKDGARG:
+        ASP_OPCODE_LABEL(MKDGARG)
         {
             bool isIterableGroup = opCode == OpCode_MKIGARG;
             bool isDictionaryGroup = opCode == OpCode_MKDGARG;
@@ -1654,14 +2283,17 @@ static AspRunResult Step(AspEngine *engine)
             AspDataSetStackEntryValueIndex
                 (engine->stackTop, AspIndex(engine, argument));
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_MKNARG4:
+        ASP_OPCODE_LABEL(MKNARG4)
             operandSize += 2;
         case OpCode_MKNARG2:
+        ASP_OPCODE_LABEL(MKNARG2)
             operandSize++;
         case OpCode_MKNARG1:
+        ASP_OPCODE_LABEL(MKNARG1)
             operandSize++;
         {
             #ifdef ASP_DEBUG
@@ -1700,20 +2332,29 @@ static AspRunResult Step(AspEngine *engine)
             AspDataSetStackEntryValueIndex
                 (engine->stackTop, AspIndex(engine, argument));
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_MKPAR4:
+        ASP_OPCODE_LABEL(MKPAR4)
         case OpCode_MKTGPAR4:
+        ASP_OPCODE_LABEL(MKTGPAR4)
         case OpCode_MKDGPAR4:
+        ASP_OPCODE_LABEL(MKDGPAR4)
             operandSize += 2;
         case OpCode_MKPAR2:
+        ASP_OPCODE_LABEL(MKPAR2)
         case OpCode_MKTGPAR2:
+        ASP_OPCODE_LABEL(MKTGPAR2)
         case OpCode_MKDGPAR2:
+        ASP_OPCODE_LABEL(MKDGPAR2)
             operandSize++;
         case OpCode_MKPAR1:
+        ASP_OPCODE_LABEL(MKPAR1)
         case OpCode_MKTGPAR1:
+        ASP_OPCODE_LABEL(MKTGPAR1)
         case OpCode_MKDGPAR1:
+        ASP_OPCODE_LABEL(MKDGPAR1)
             operandSize++;
         {
             bool isTupleGroup =
@@ -1760,14 +2401,17 @@ static AspRunResult Step(AspEngine *engine)
             if (stackEntry == 0)
                 return AspRunResult_OutOfDataMemory;
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_MKDPAR4:
+        ASP_OPCODE_LABEL(MKDPAR4)
             operandSize += 2;
         case OpCode_MKDPAR2:
+        ASP_OPCODE_LABEL(MKDPAR2)
             operandSize++;
         case OpCode_MKDPAR1:
+        ASP_OPCODE_LABEL(MKDPAR1)
             operandSize++;
         {
             #ifdef ASP_DEBUG
@@ -1809,10 +2453,11 @@ static AspRunResult Step(AspEngine *engine)
             AspDataSetStackEntryValueIndex
                 (engine->stackTop, AspIndex(engine, parameter));
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_MKFUN:
+        ASP_OPCODE_LABEL(MKFUN)
         {
             #ifdef ASP_DEBUG
             fputs("MKFUN @", engine->traceFile);
@@ -1838,7 +2483,7 @@ static AspRunResult Step(AspEngine *engine)
             #ifdef ASP_DEBUG
             fprintf(engine->traceFile, "0x%07X\n", codeAddress);
             #endif
-            AspRunResult validateResult = AspValidateCodeAddress
+            AspRunResult validateResult = AspValidateCodeTarget
                 (engine, codeAddress);
             if (validateResult != AspRunResult_OK)
                 return validateResult;
@@ -1869,10 +2514,11 @@ static AspRunResult Step(AspEngine *engine)
             AspDataSetStackEntryValueIndex
                 (engine->stackTop, AspIndex(engine, function));
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_MKKVP:
+        ASP_OPCODE_LABEL(MKKVP)
         {
             #ifdef ASP_DEBUG
             fputs("MKKVP\n", engine->traceFile);
@@ -1908,17 +2554,25 @@ static AspRunResult Step(AspEngine *engine)
             AspDataSetStackEntryValueIndex
                 (engine->stackTop, AspIndex(engine, keyValuePairEntry));
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_MKR0:
+        ASP_OPCODE_LABEL(MKR0)
         case OpCode_MKRS:
+        ASP_OPCODE_LABEL(MKRS)
         case OpCode_MKRE:
+        ASP_OPCODE_LABEL(MKRE)
         case OpCode_MKRSE:
+        ASP_OPCODE_LABEL(MKRSE)
         case OpCode_MKRT:
+        ASP_OPCODE_LABEL(MKRT)
         case OpCode_MKRST:
+        ASP_OPCODE_LABEL(MKRST)
         case OpCode_MKRET:
+        ASP_OPCODE_LABEL(MKRET)
         case OpCode_MKR:
+        ASP_OPCODE_LABEL(MKR)
         {
             bool hasStart =
                 opCode == OpCode_MKRS ||
@@ -2062,12 +2716,15 @@ static AspRunResult Step(AspEngine *engine)
                 return AspRunResult_OutOfDataMemory;
             AspUnref(engine, range);
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_INS:
+        ASP_OPCODE_LABEL(INS)
         case OpCode_INSP:
+        ASP_OPCODE_LABEL(INSP)
         case OpCode_BLD:
+        ASP_OPCODE_LABEL(BLD)
         {
             #ifdef ASP_DEBUG
             fprintf
@@ -2299,11 +2956,13 @@ static AspRunResult Step(AspEngine *engine)
             if (opCode == OpCode_INSP)
                 AspPop(engine);
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_IDX:
+        ASP_OPCODE_LABEL(IDX)
         case OpCode_IDXA:
+        ASP_OPCODE_LABEL(IDXA)
         {
             #ifdef ASP_DEBUG
             fprintf
@@ -2422,9 +3081,9 @@ static AspRunResult Step(AspEngine *engine)
                                     return AspRunResult_ValueOutOfRange;
                             }
 
-                            /* Create a single-character string. */
-                            AspDataEntry *element = AspNewString
-                                (engine, &c, 1);
+                            /* Obtain a single-character string. */
+                            AspDataEntry *element = AspCharacterString
+                                (engine, (uint8_t)c);
                             if (element == 0)
                                 return AspRunResult_OutOfDataMemory;
 
@@ -2687,20 +3346,28 @@ static AspRunResult Step(AspEngine *engine)
                 return engine->runResult;
             AspUnref(engine, container);
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_MEM4:
+        ASP_OPCODE_LABEL(MEM4)
         case OpCode_MEMA4:
+        ASP_OPCODE_LABEL(MEMA4)
             operandSize += 2;
         case OpCode_MEM2:
+        ASP_OPCODE_LABEL(MEM2)
         case OpCode_MEMA2:
+        ASP_OPCODE_LABEL(MEMA2)
             operandSize++;
         case OpCode_MEM1:
+        ASP_OPCODE_LABEL(MEM1)
         case OpCode_MEMA1:
+        ASP_OPCODE_LABEL(MEMA1)
             operandSize++;
         case OpCode_MEM:
+        ASP_OPCODE_LABEL(MEM)
         case OpCode_MEMA:
+        ASP_OPCODE_LABEL(MEMA)
         {
             bool isAddressInstruction =
                 opCode == OpCode_MEMA ||
@@ -2784,13 +3451,15 @@ static AspRunResult Step(AspEngine *engine)
 
             AspUnref(engine, module);
 
-            break;
+            DISPATCH();
         }
 
         case OpCode_ABORT:
+        ASP_OPCODE_LABEL(ABORT)
             return AspRunResult_Abort;
 
         case OpCode_END:
+        ASP_OPCODE_LABEL(END)
         {
             #ifdef ASP_DEBUG
             fputs("END\n", engine->traceFile);
@@ -2804,6 +3473,50 @@ static AspRunResult Step(AspEngine *engine)
         }
     }
 
+    /* Proceed to the next instruction if applicable. */
+    if (engine->runResult != AspRunResult_OK || engine->again ||
+        *stepCount >= stepLimit)
+        return AspRunResult_OK;
+    goto NextInstruction;
+}
+
+/* Fetch the op code of the next instruction, counting it as a step. */
+static inline AspRunResult FetchInstruction
+    (AspEngine *engine, uint32_t *stepCount, uint8_t *opCode)
+{
+    (*stepCount)++;
+
+    #ifdef ASP_DEBUG
+    fprintf
+        (engine->traceFile, "@0x%07zX: ",
+         AspProgramCounter(engine));
+    #endif
+
+    engine->instructionAddress = engine->pc;
+    uint8_t opCodeBuffer;
+    const uint8_t *opCodePtr;
+    AspRunResult result = AspFetchCodeBytes
+        (engine, 1, &opCodeBuffer, &opCodePtr);
+    if (result != AspRunResult_OK)
+        return result;
+    *opCode = *opCodePtr;
+    #ifdef ASP_DEBUG
+    fprintf(engine->traceFile, "0x%02X ", *opCode);
+    #endif
+    #ifdef ASP_OPCODE_PROFILE
+    if (engine->opCodeProfiler != 0)
+        engine->opCodeProfiler(engine->opCodeProfilerContext, *opCode);
+    if (engine->profile != 0)
+    {
+        AspProfile *profile = engine->profile;
+        size_t address = (size_t)engine->instructionAddress;
+        engine->profileOpCode = *opCode;
+        profile->opCodeCounts[*opCode]++;
+        if (profile->pcCounts != 0 && address < profile->pcCountsSize)
+            profile->pcCounts[address]++;
+    }
+    #endif
+
     return AspRunResult_OK;
 }
 
@@ -2832,15 +3545,18 @@ static AspRunResult LoadSignedWordOperand
 static AspRunResult LoadUnsignedOperand
     (AspEngine *engine, unsigned operandSize, uint32_t *operand)
 {
+    uint8_t buffer[4];
+    const uint8_t *bytes;
+    AspRunResult fetchResult = AspFetchCodeBytes
+        (engine, operandSize, buffer, &bytes);
+    if (fetchResult != AspRunResult_OK)
+        return fetchResult;
+
     *operand = 0;
     for (unsigned i = 0; i < operandSize; i++)
     {
-        uint8_t c;
-        AspRunResult byteResult = AspLoadCodeBytes(engine, &c, 1);
-        if (byteResult != AspRunResult_OK)
-            return byteResult;
         *operand <<= 8;
-        *operand |= c;
+        *operand |= bytes[i];
     }
     return AspRunResult_OK;
 }
@@ -2851,25 +3567,20 @@ static AspRunResult LoadSignedOperand
     uint32_t unsignedOperand = 0;
     if (operandSize != 0)
     {
-        /* Peek at the most significant byte to determine the sign. */
-        uint8_t c;
-        AspRunResult byteResult = AspLoadCodeBytes(engine, &c, 1);
-        if (byteResult != AspRunResult_OK)
-            return byteResult;
-        bool negative = operandSize != 0 && (c & 0x80) != 0;
-        engine->pc--;
-
-        AspRunResult loadResult = LoadUnsignedOperand
-            (engine, operandSize, &unsignedOperand);
-        if (loadResult != AspRunResult_OK)
-            return loadResult;
-
-        /* Sign extend if applicable. */
-        if (negative)
+        uint8_t buffer[4];
+        const uint8_t *bytes;
+        AspRunResult fetchResult = AspFetchCodeBytes
+            (engine, operandSize, buffer, &bytes);
+        if (fetchResult != AspRunResult_OK)
+            return fetchResult;
+
+        /* Sign extend based on the most significant byte. */
+        if ((bytes[0] & 0x80) != 0)
+            unsignedOperand = UINT32_MAX;
+        for (unsigned i = 0; i < operandSize; i++)
         {
-            unsigned i = operandSize;
-            for (; i < 4; i++)
-                unsignedOperand |= 0xFFU << (i << 3);
+            unsignedOperand <<= 8;
+            unsignedOperand |= bytes[i];
         }
     }
 
@@ -2883,22 +3594,222 @@ static AspRunResult LoadFloatOperand
     static const uint16_t word = 1;
     bool be = *(const char *)&word == 0;
 
+    uint8_t buffer[8];
+    const uint8_t *bytes;
+    AspRunResult fetchResult = AspFetchCodeBytes
+        (engine, sizeof buffer, buffer, &bytes);
+    if (fetchResult != AspRunResult_OK)
+        return fetchResult;
     uint8_t data[8];
-    AspRunResult loadResult = AspLoadCodeBytes(engine, data, sizeof data);
-    if (loadResult != AspRunResult_OK)
-        return loadResult;
-    if (!be)
+    for (unsigned i = 0; i < sizeof data; i++)
+        data[i] = bytes[be ? i : 7 - i];
+
+    /* Convert IEEE 754 binary64 to the native format. */
+    *operand = engine->floatConverter != 0 ?
+        engine->floatConverter(data) : *(double *)data;
+    return AspRunResult_OK;
+}
+
+static AspRunResult LoadStringOperand
+    (AspEngine *engine, uint32_t size, AspDataEntry **str)
+{
+    #ifdef ASP_DEBUG
+    fputc('\'', engine->traceFile);
+    #endif
+
+    /* Single-character strings are shared rather than built. */
+    *str = size == 1 ? 0 : AspNewString(engine, 0, 0);
+    if (size != 1 && *str == 0)
+        return AspRunResult_OutOfDataMemory;
+    for (uint32_t i = 0; i < size; )
     {
-        for (unsigned i = 0; i < 4; i++)
+        /* Fetch the next chunk of bytes. */
+        uint8_t buffer[16];
+        const uint8_t *bytes;
+        uint32_t chunkSize = size - i;
+        if (chunkSize > sizeof buffer)
+            chunkSize = sizeof buffer;
+        AspRunResult fetchResult = AspFetchCodeBytes
+            (engine, chunkSize, buffer, &bytes);
+        if (fetchResult != AspRunResult_OK)
+        {
+            #ifdef ASP_DEBUG
+            fputc('\n', engine->traceFile);
+            #endif
+            return fetchResult;
+        }
+        if (size == 1)
+        {
+            *str = AspCharacterString(engine, bytes[0]);
+            if (*str == 0)
+                return AspRunResult_OutOfDataMemory;
+        }
+        else
+        {
+            AspRunResult appendResult = AspStringAppendBuffer
+                (engine, *str, (const char *)bytes, chunkSize);
+            if (appendResult != AspRunResult_OK)
+                return appendResult;
+        }
+        i += chunkSize;
+
+        #ifdef ASP_DEBUG
+        for (uint32_t j = 0; j < chunkSize; j++)
         {
-            data[i] ^= data[7 - i];
-            data[7 - i] ^= data[i];
-            data[i] ^= data[7 - i];
+            char c = (char)bytes[j];
+            if (c == '\'')
+                fputc('\\', engine->traceFile);
+            fputc(isprint(c) ? c : '.', engine->traceFile);
         }
+        #endif
     }
+    #ifdef ASP_DEBUG
+    fputs("'\n", engine->traceFile);
+    #endif
+
+    return AspRunResult_OK;
+}
+
+static AspDataEntry *FindStringLiteral(AspEngine *engine)
+{
+    /* Return the string retained by the current instruction, if any. */
+    uint32_t address = engine->instructionAddress;
+    const AspStringLiteralCacheEntry *cacheEntry =
+        engine->stringLiteralCache + address % ASP_STRING_LITERAL_CACHE_SIZE;
+    if (cacheEntry->stringIndex == 0 || cacheEntry->address != address)
+        return 0;
+    AspDataEntry *str = AspEntry(engine, cacheEntry->stringIndex);
+    AspRef(engine, str);
+    return str;
+}
+
+static void RetainStringLiteral(AspEngine *engine, AspDataEntry *str)
+{
+    /* Replace the entry selected by the instruction's address, releasing
+       any string retained by another instruction. */
+    uint32_t address = engine->instructionAddress;
+    AspStringLiteralCacheEntry *cacheEntry =
+        engine->stringLiteralCache + address % ASP_STRING_LITERAL_CACHE_SIZE;
+    if (cacheEntry->stringIndex != 0)
+        AspUnref(engine, AspEntry(engine, cacheEntry->stringIndex));
+
+    AspRef(engine, str);
+    cacheEntry->address = address;
+    cacheEntry->stringIndex = AspIndex(engine, str);
+}
+
+static AspRunResult LoadVariableValue
+    (AspEngine *engine, int32_t symbol, bool checkLocal)
+{
+    /* Look up the variable, trying first the local namespace, and then
+       failing that, the global and system namespaces in turn. Note that a
+       local variable can also defer to the global namespace via a global
+       override. The local look-up is skipped if the caller has already
+       performed it. */
+    AspDataEntry *node = 0;
+    if (checkLocal && engine->localNamespace != engine->globalNamespace)
+    {
+        AspTreeResult findResult = AspFindSymbol
+            (engine, engine->localNamespace, symbol);
+        if (findResult.result != AspRunResult_OK)
+            return findResult.result;
+        node = findResult.node;
+        if (node != 0 && AspDataGetNamespaceNodeIsGlobal(node))
+            node = 0;
+    }
+    if (node == 0)
+    {
+        AspRunResult findResult = FindGlobalVariable(engine, symbol, &node);
+        if (findResult != AspRunResult_OK)
+            return findResult;
+    }
+    if (node == 0)
+        return AspRunResult_NameNotFound;
+
+    /* Push variable's value. */
+    AspDataEntry *object = AspValueEntry
+        (engine, AspDataGetTreeNodeValueIndex(node));
+    if (!AspIsObject(object))
+        return AspRunResult_UnexpectedType;
+    const AspDataEntry *stackEntry = AspPush(engine, object);
+    if (stackEntry == 0)
+        return AspRunResult_OutOfDataMemory;
+
+    return AspRunResult_OK;
+}
+
+static AspRunResult FindGlobalVariable
+    (AspEngine *engine, int32_t symbol, AspDataEntry **node)
+{
+    /* Use the node resolved the last time the current instruction was
+       executed, provided no global or system variable has been added or
+       removed since. */
+    uint32_t address = engine->instructionAddress;
+    uint32_t namespaceIndex = AspIndex(engine, engine->globalNamespace);
+    AspLoadCacheEntry *cacheEntry =
+        engine->loadCache + address % ASP_LOAD_CACHE_SIZE;
+    if (cacheEntry->nodeIndex != 0 &&
+        cacheEntry->address == address &&
+        cacheEntry->symbol == symbol &&
+        cacheEntry->namespaceIndex == namespaceIndex &&
+        cacheEntry->generation == engine->namespaceGeneration)
+    {
+        *node = AspEntry(engine, cacheEntry->nodeIndex);
+        return AspRunResult_OK;
+    }
+
+    /* Look up the variable in the global namespace, and then the system
+       namespace. */
+    AspTreeResult findResult = AspFindSymbol
+        (engine, engine->globalNamespace, symbol);
+    if (findResult.result != AspRunResult_OK)
+        return findResult.result;
+    if (findResult.node == 0)
+    {
+        findResult = AspFindSymbol(engine, engine->systemNamespace, symbol);
+        if (findResult.result != AspRunResult_OK)
+            return findResult.result;
+    }
+    *node = findResult.node;
+
+    /* Remember the resolved node for subsequent executions of the current
+       instruction. */
+    if (findResult.node != 0)
+    {
+        cacheEntry->address = address;
+        cacheEntry->symbol = symbol;
+        cacheEntry->namespaceIndex = namespaceIndex;
+        cacheEntry->generation = engine->namespaceGeneration;
+        cacheEntry->nodeIndex = AspIndex(engine, findResult.node);
+    }
+
+    return AspRunResult_OK;
+}
+
+static AspRunResult LoadVariableAddress(AspEngine *engine, int32_t symbol)
+{
+    /* Look up the variable, creating it if it doesn't exist. */
+    AspTreeResult insertResult = AspTreeTryInsertBySymbol
+        (engine, engine->localNamespace, symbol, engine->noneSingleton);
+    if (insertResult.result != AspRunResult_OK)
+        return insertResult.result;
+    const AspDataEntry *node = insertResult.node;
+
+    /* Set the scope usage for the newly created variable. */
+    if (AspDataGetNamespaceNodeIsGlobal(node) &&
+        engine->localNamespace != engine->globalNamespace)
+    {
+        /* Use global scope because of global override. */
+        insertResult = AspTreeTryInsertBySymbol
+            (engine, engine->globalNamespace, symbol, engine->noneSingleton);
+        if (insertResult.result != AspRunResult_OK)
+            return insertResult.result;
+    }
+
+    /* Push the variable's tree node to serve as an address. */
+    const AspDataEntry *stackEntry = AspPush(engine, insertResult.node);
+    if (stackEntry == 0)
+        return AspRunResult_OutOfDataMemory;
 
-    /* Convert IEEE 754 binary64 to the native format. */
-    *operand = engine->floatConverter != 0 ?
-        engine->floatConverter(data) : *(double *)data;
     return AspRunResult_OK;
 }
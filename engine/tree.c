@@ -8,11 +8,15 @@
 #include "tree.h"
 #include "data.h"
 #include "compare.h"
+#include <string.h>
+
+static const uint32_t NoKeyHash = UINT32_MAX;
 
 static AspRunResult Insert
     (AspEngine *, AspDataEntry *tree, AspDataEntry *node);
 static AspDataEntry *FindNode
-    (AspEngine *, const AspDataEntry *tree, const AspDataEntry *keyNode);
+    (AspEngine *, const AspDataEntry *tree, const AspDataEntry *keyNode,
+     uint32_t *keyHash);
 static AspDataEntry *GetLimitNode
     (AspEngine *, const AspDataEntry *tree, AspDataEntry *node, bool right);
 static AspRunResult Shift
@@ -29,10 +33,42 @@ static AspRunResult SetChildIndex
 static uint32_t GetChildIndex
     (AspEngine *, const AspDataEntry *node, bool right);
 static void PruneLinks(AspEngine *, AspDataEntry *node);
+static void ForgetSlotNode
+    (AspEngine *, const AspDataEntry *ns, const AspDataEntry *node);
+static void NoteNamespaceChange(AspEngine *, const AspDataEntry *tree);
 static bool IsTreeType(DataType type);
 static bool IsNodeType(DataType type);
 static AspRunResult NotFoundResult(const AspDataEntry *tree);
 
+#ifdef ASP_HASHED_COLLECTIONS
+static const unsigned HashChunkSlotBitSize = 2U;
+static const unsigned MinHashBitSize = 5U;
+static const unsigned MaxHashBitSize = AspWordBitSize;
+
+static AspRunResult KeyNodeHash
+    (AspEngine *, const AspDataEntry *keyNode, uint32_t *hash);
+static AspDataEntry *FindHashedNode
+    (AspEngine *, const AspDataEntry *tree, const AspDataEntry *keyNode,
+     uint32_t hash);
+static void IndexInsertedNode
+    (AspEngine *, AspDataEntry *tree, const AspDataEntry *node,
+     uint32_t hash);
+static void UnindexErasedNode
+    (AspEngine *, AspDataEntry *tree, const AspDataEntry *node,
+     uint32_t hash);
+static bool ResizeHashIndex
+    (AspEngine *, AspDataEntry *tree, unsigned bitSize);
+static bool AddHashSlot
+    (AspEngine *, AspDataEntry *root, uint32_t nodeIndex, uint32_t hash);
+static AspDataEntry *HashSlotChunk
+    (AspEngine *, AspDataEntry *root, uint32_t position, bool extend);
+static unsigned HashIndexBitSize(const AspDataEntry *root);
+static unsigned HashBitSizeForCount(int32_t count);
+static AspDataEntry *NewHashChunk(AspEngine *, unsigned level);
+static bool CanAllocateHashChunks(AspEngine *, size_t count);
+static void FreeHashChunks(AspEngine *, uint32_t rootIndex);
+#endif
+
 #ifdef ASP_TEST
 static bool IsRedBlack
     (AspEngine *, const AspDataEntry *node,
@@ -90,7 +126,8 @@ AspTreeResult AspTreeInsert
     AspDataSetTreeNodeKeyIndex(result.node, AspIndex(engine, key));
 
     /* Determine whether the key already exists. */
-    AspDataEntry *foundNode = FindNode(engine, tree, result.node);
+    uint32_t keyHash;
+    AspDataEntry *foundNode = FindNode(engine, tree, result.node, &keyHash);
     if (engine->runResult != AspRunResult_OK)
     {
         result.result = engine->runResult;
@@ -144,6 +181,12 @@ AspTreeResult AspTreeInsert
     result.inserted = true;
 
     result.result = Insert(engine, tree, result.node);
+    NoteNamespaceChange(engine, tree);
+
+    #ifdef ASP_HASHED_COLLECTIONS
+    if (result.result == AspRunResult_OK)
+        IndexInsertedNode(engine, tree, result.node, keyHash);
+    #endif
 
     return result;
 }
@@ -183,6 +226,7 @@ AspTreeResult AspTreeTryInsertBySymbol
     result.inserted = true;
 
     result.result = Insert(engine, tree, result.node);
+    NoteNamespaceChange(engine, tree);
 
     return result;
 }
@@ -200,12 +244,25 @@ AspRunResult AspTreeEraseNode
     if (result != AspRunResult_OK)
         return result;
 
-    AspDataEntry *node = FindNode(engine, tree, keyNode);
+    uint32_t keyHash;
+    AspDataEntry *node = FindNode(engine, tree, keyNode, &keyHash);
     if (engine->runResult != AspRunResult_OK)
         return engine->runResult;
     if (node == 0)
         return NotFoundResult(tree);
 
+    #ifdef ASP_HASHED_COLLECTIONS
+    if (AspDataGetType(tree) != DataType_Namespace)
+        UnindexErasedNode(engine, tree, node, keyHash);
+    #endif
+
+    /* Ensure no namespace slot or cached load continues to refer to the
+       node. */
+    if (AspDataGetType(tree) == DataType_Namespace &&
+        AspDataGetNamespaceSlotCount(tree) != 0)
+        ForgetSlotNode(engine, tree, node);
+    NoteNamespaceChange(engine, tree);
+
     /* Remove node from tree and determine whether rebalancing is required. */
     bool rebalance = AspDataGetTreeNodeIsBlack(node);
     uint32_t nodeIndex = AspIndex(engine, node);
@@ -471,7 +528,7 @@ AspTreeResult AspTreeFind
         return result;
     }
     AspDataSetTreeNodeKeyIndex(keyNode, AspIndex(engine, key));
-    result.node = FindNode(engine, tree, keyNode);
+    result.node = FindNode(engine, tree, keyNode, 0);
     if (engine->runResult != AspRunResult_OK)
     {
         result.result = engine->runResult;
@@ -509,7 +566,7 @@ AspTreeResult AspFindSymbol
         return result;
     }
     AspDataSetNamespaceNodeSymbol(keyNode, symbol);
-    result.node = FindNode(engine, tree, keyNode);
+    result.node = FindNode(engine, tree, keyNode, 0);
     if (engine->runResult != AspRunResult_OK)
     {
         result.result = engine->runResult;
@@ -710,8 +767,11 @@ static AspRunResult Insert
 }
 
 static AspDataEntry *FindNode
-    (AspEngine *engine, const AspDataEntry *tree, const AspDataEntry *keyNode)
+    (AspEngine *engine, const AspDataEntry *tree, const AspDataEntry *keyNode,
+     uint32_t *keyHash)
 {
+    if (keyHash != 0)
+        *keyHash = NoKeyHash;
     AspAssert
         (engine, tree != 0 && IsTreeType(AspDataGetType(tree)));
     AspRunResult assertResult = AspAssert
@@ -719,6 +779,22 @@ static AspDataEntry *FindNode
     if (assertResult != AspRunResult_OK)
         return 0;
 
+    #ifdef ASP_HASHED_COLLECTIONS
+    /* Look the key up through the hash index if there is one, reporting
+       the key's hash for use in updating the index. */
+    if (AspDataGetType(tree) != DataType_Namespace &&
+        AspDataGetTreeHashIndex(tree) != 0)
+    {
+        uint32_t hash;
+        if (KeyNodeHash(engine, keyNode, &hash) == AspRunResult_OK)
+        {
+            if (keyHash != 0)
+                *keyHash = hash;
+            return FindHashedNode(engine, tree, keyNode, hash);
+        }
+    }
+    #endif
+
     AspDataEntry *node = AspEntry(engine, AspDataGetTreeRootIndex(tree));
     uint32_t iterationCount = 0;
     for (;
@@ -964,6 +1040,76 @@ static uint32_t GetChildIndex
     return index;
 }
 
+void AspReserveNamespaceSlots
+    (AspEngine *engine, AspDataEntry *ns, unsigned count)
+{
+    /* Reserve the slots following those in use, leaving the namespace
+       without slots if too few remain. */
+    if (count == 0 || AspDataGetNamespaceSlotCount(ns) != 0 ||
+        count > ASP_LOCAL_SLOT_COUNT - engine->localSlotCount)
+        return;
+    uint32_t base = engine->localSlotCount;
+    memset
+        (engine->localSlots + base, 0,
+         count * sizeof *engine->localSlots);
+    engine->localSlotCount += count;
+    AspDataSetNamespaceSlotBase(ns, base);
+    AspDataSetNamespaceSlotCount(ns, count);
+}
+
+AspDataEntry *AspNamespaceSlotNode
+    (AspEngine *engine, const AspDataEntry *ns, unsigned slot)
+{
+    if (slot >= AspDataGetNamespaceSlotCount(ns))
+        return 0;
+    return AspEntry
+        (engine,
+         engine->localSlots[AspDataGetNamespaceSlotBase(ns) + slot]);
+}
+
+void AspSetNamespaceSlotNode
+    (AspEngine *engine, const AspDataEntry *ns, unsigned slot,
+     const AspDataEntry *node)
+{
+    if (slot < AspDataGetNamespaceSlotCount(ns))
+        engine->localSlots[AspDataGetNamespaceSlotBase(ns) + slot] =
+            AspIndex(engine, node);
+}
+
+void AspReleaseNamespaceSlots(AspEngine *engine, AspDataEntry *ns)
+{
+    /* Calls end in the reverse order in which they were made, so the
+       namespace's slots are the last ones in use. */
+    if (AspDataGetNamespaceSlotCount(ns) == 0)
+        return;
+    engine->localSlotCount = AspDataGetNamespaceSlotBase(ns);
+    AspDataSetNamespaceSlotBase(ns, 0);
+    AspDataSetNamespaceSlotCount(ns, 0);
+}
+
+static void ForgetSlotNode
+    (AspEngine *engine, const AspDataEntry *ns, const AspDataEntry *node)
+{
+    uint32_t nodeIndex = AspIndex(engine, node);
+    uint32_t *slots = engine->localSlots + AspDataGetNamespaceSlotBase(ns);
+    unsigned count = AspDataGetNamespaceSlotCount(ns);
+    for (unsigned slot = 0; slot < count; slot++)
+    {
+        if (slots[slot] == nodeIndex)
+            slots[slot] = 0;
+    }
+}
+
+static void NoteNamespaceChange(AspEngine *engine, const AspDataEntry *tree)
+{
+    /* Invalidate cached variable loads when a global or system variable
+       is added or removed. Local namespaces are excluded, as lookups in
+       them are never cached. */
+    if (AspDataGetType(tree) == DataType_Namespace &&
+        !AspDataGetNamespaceIsLocal(tree))
+        engine->namespaceGeneration++;
+}
+
 static void PruneLinks(AspEngine *engine, AspDataEntry *node)
 {
     AspRunResult assertResult = AspAssert
@@ -1007,6 +1153,396 @@ static AspRunResult NotFoundResult(const AspDataEntry *tree)
         AspRunResult_NameNotFound : AspRunResult_KeyNotFound;
 }
 
+#ifdef ASP_HASHED_COLLECTIONS
+
+void AspTreeDropHashIndex(AspEngine *engine, AspDataEntry *tree)
+{
+    uint32_t rootIndex = AspDataGetTreeHashIndex(tree);
+    if (rootIndex == 0)
+        return;
+    AspDataSetTreeHashIndex(tree, 0);
+    FreeHashChunks(engine, rootIndex);
+}
+
+static AspRunResult KeyNodeHash
+    (AspEngine *engine, const AspDataEntry *keyNode, uint32_t *hash)
+{
+    /* Keep only as many bits of the hash as a chunk slot holds. */
+    uint32_t keyHash;
+    AspRunResult result = AspHashKey
+        (engine,
+         AspValueEntry(engine, AspDataGetTreeNodeKeyIndex(keyNode)),
+         &keyHash);
+    *hash = keyHash & AspWordMax;
+    return result;
+}
+
+static AspDataEntry *FindHashedNode
+    (AspEngine *engine, const AspDataEntry *tree, const AspDataEntry *keyNode,
+     uint32_t hash)
+{
+    /* Probe successive slots from the one the hash selects until the key
+       is found or an empty slot is reached. Keys are only compared when
+       their hashes match. */
+    AspDataEntry *root = AspEntry(engine, AspDataGetTreeHashIndex(tree));
+    uint32_t mask = (1U << HashIndexBitSize(root)) - 1U;
+    uint32_t position = hash & mask;
+    AspDataEntry *chunk = 0;
+    for (uint32_t probeCount = 0; probeCount <= mask;
+         probeCount++, position = (position + 1U) & mask)
+    {
+        unsigned slot = position % AspDataGetTreeHashChunkSlotCapacity();
+        if (chunk == 0 || slot == 0)
+            chunk = HashSlotChunk(engine, root, position, false);
+        uint32_t nodeIndex = chunk == 0 ? 0 :
+            AspDataGetTreeHashChunkNodeIndex(chunk, slot);
+        if (nodeIndex == 0)
+            return 0;
+        if (AspDataGetTreeHashChunkHash(chunk, slot) != hash)
+            continue;
+
+        AspDataEntry *node = AspEntry(engine, nodeIndex);
+        int comparison;
+        AspRunResult compareResult = CompareKeys
+            (engine, tree, keyNode, node, &comparison);
+        AspRunResult assertResult = AspAssert
+            (engine, compareResult == AspRunResult_OK);
+        if (assertResult != AspRunResult_OK)
+            return 0;
+        if (comparison == 0)
+            return node;
+    }
+
+    return 0;
+}
+
+static void IndexInsertedNode
+    (AspEngine *engine, AspDataEntry *tree, const AspDataEntry *node,
+     uint32_t hash)
+{
+    /* Build the index once the tree reaches the minimum size. Should that
+       fail for lack of memory, try again each time the size doubles, so
+       that repeated attempts cost no more than the insertions between
+       them. */
+    int32_t count = AspDataGetTreeCount(tree);
+    AspDataEntry *root = AspEntry(engine, AspDataGetTreeHashIndex(tree));
+    if (root == 0)
+    {
+        if (count >= ASP_TREE_HASH_INDEX_MIN_COUNT &&
+            (count & (count - 1)) == 0)
+            ResizeHashIndex(engine, tree, HashBitSizeForCount(count));
+        return;
+    }
+
+    /* Add the node, giving up the index if it cannot be extended. Grow the
+       table once it is more than half full. */
+    if (hash == NoKeyHash &&
+        KeyNodeHash(engine, node, &hash) != AspRunResult_OK)
+    {
+        AspTreeDropHashIndex(engine, tree);
+        return;
+    }
+    if (!AddHashSlot(engine, root, AspIndex(engine, node), hash))
+    {
+        AspTreeDropHashIndex(engine, tree);
+        return;
+    }
+    unsigned bitSize = HashIndexBitSize(root);
+    if ((uint32_t)count > (1U << bitSize) / 2U)
+        ResizeHashIndex(engine, tree, bitSize + 1U);
+}
+
+static void UnindexErasedNode
+    (AspEngine *engine, AspDataEntry *tree, const AspDataEntry *node,
+     uint32_t hash)
+{
+    AspDataEntry *root = AspEntry(engine, AspDataGetTreeHashIndex(tree));
+    if (root == 0)
+        return;
+    int32_t count = AspDataGetTreeCount(tree) - 1;
+    if (hash == NoKeyHash || count < ASP_TREE_HASH_INDEX_MIN_COUNT / 2)
+    {
+        AspTreeDropHashIndex(engine, tree);
+        return;
+    }
+
+    /* Locate the node's slot. */
+    uint32_t nodeIndex = AspIndex(engine, node);
+    unsigned bitSize = HashIndexBitSize(root);
+    uint32_t mask = (1U << bitSize) - 1U;
+    unsigned slotCapacity = AspDataGetTreeHashChunkSlotCapacity();
+    uint32_t holePosition = hash & mask;
+    AspDataEntry *holeChunk = 0;
+    uint32_t probeCount = 0;
+    for (; probeCount <= mask;
+         probeCount++, holePosition = (holePosition + 1U) & mask)
+    {
+        holeChunk = HashSlotChunk(engine, root, holePosition, false);
+        uint32_t slotNodeIndex = holeChunk == 0 ? 0 :
+            AspDataGetTreeHashChunkNodeIndex
+                (holeChunk, holePosition % slotCapacity);
+        if (slotNodeIndex == nodeIndex || slotNodeIndex == 0)
+            break;
+    }
+    if (probeCount > mask || holeChunk == 0 ||
+        AspDataGetTreeHashChunkNodeIndex
+            (holeChunk, holePosition % slotCapacity) != nodeIndex)
+    {
+        AspTreeDropHashIndex(engine, tree);
+        return;
+    }
+
+    /* Close the gap by moving back any later slot in the same run whose
+       preferred position does not lie after the hole, so that no probe
+       sequence passes through an empty slot. */
+    uint32_t position = holePosition;
+    for (probeCount = 0; probeCount < mask; probeCount++)
+    {
+        position = (position + 1U) & mask;
+        AspDataEntry *chunk = HashSlotChunk(engine, root, position, false);
+        unsigned slot = position % slotCapacity;
+        uint32_t slotNodeIndex = chunk == 0 ? 0 :
+            AspDataGetTreeHashChunkNodeIndex(chunk, slot);
+        if (slotNodeIndex == 0)
+            break;
+        uint32_t slotHash = AspDataGetTreeHashChunkHash(chunk, slot);
+        uint32_t home = slotHash & mask;
+        bool stay = holePosition <= position ?
+            holePosition < home && home <= position :
+            holePosition < home || home <= position;
+        if (stay)
+            continue;
+
+        unsigned holeSlot = holePosition % slotCapacity;
+        AspDataSetTreeHashChunkNodeIndex(holeChunk, holeSlot, slotNodeIndex);
+        AspDataSetTreeHashChunkHash(holeChunk, holeSlot, slotHash);
+        holePosition = position;
+        holeChunk = chunk;
+    }
+    unsigned holeSlot = holePosition % slotCapacity;
+    AspDataSetTreeHashChunkNodeIndex(holeChunk, holeSlot, 0);
+    AspDataSetTreeHashChunkHash(holeChunk, holeSlot, 0);
+
+    /* Shrink the table once it is less than an eighth full. */
+    if (bitSize > MinHashBitSize && (uint32_t)count < (1U << bitSize) / 8U)
+        ResizeHashIndex(engine, tree, HashBitSizeForCount(count));
+}
+
+static bool ResizeHashIndex
+    (AspEngine *engine, AspDataEntry *tree, unsigned bitSize)
+{
+    uint32_t oldRootIndex = AspDataGetTreeHashIndex(tree);
+    AspDataSetTreeHashIndex(tree, 0);
+
+    /* Only build the table if there is ample memory for all of it. */
+    size_t chunkCount = 0;
+    size_t levelCount = ((size_t)1 << bitSize) /
+        AspDataGetTreeHashChunkSlotCapacity();
+    unsigned capacity = AspDataGetTreeHashChunkCapacity();
+    do
+    {
+        chunkCount += levelCount;
+        levelCount = (levelCount + capacity - 1U) / capacity;
+    } while (levelCount > 1);
+    AspDataEntry *root = 0;
+    if (bitSize <= MaxHashBitSize &&
+        CanAllocateHashChunks(engine, chunkCount + 1U))
+        root = NewHashChunk(engine, bitSize / HashChunkSlotBitSize);
+    if (root == 0)
+    {
+        if (oldRootIndex != 0)
+            FreeHashChunks(engine, oldRootIndex);
+        return false;
+    }
+    AspDataSetTreeHashChunkIsHalf(root, bitSize % HashChunkSlotBitSize == 0);
+    uint32_t rootIndex = AspIndex(engine, root);
+
+    /* Fill the new table from the old one's slots, reusing their hashes,
+       or from the tree if there is no old table. */
+    bool filled = true;
+    if (oldRootIndex != 0)
+    {
+        AspDataEntry *oldRoot = AspEntry(engine, oldRootIndex);
+        uint32_t oldCapacity = 1U << HashIndexBitSize(oldRoot);
+        unsigned slotCapacity = AspDataGetTreeHashChunkSlotCapacity();
+        for (uint32_t position = 0; filled && position < oldCapacity;
+             position += slotCapacity)
+        {
+            AspDataEntry *chunk = HashSlotChunk
+                (engine, oldRoot, position, false);
+            for (unsigned slot = 0;
+                 filled && chunk != 0 && slot < slotCapacity; slot++)
+            {
+                uint32_t nodeIndex = AspDataGetTreeHashChunkNodeIndex
+                    (chunk, slot);
+                if (nodeIndex != 0)
+                    filled = AddHashSlot
+                        (engine, root, nodeIndex,
+                         AspDataGetTreeHashChunkHash(chunk, slot));
+            }
+        }
+        FreeHashChunks(engine, oldRootIndex);
+    }
+    else
+    {
+        AspTreeResult nextResult = {AspRunResult_OK, 0, 0, 0, false};
+        uint32_t iterationCount = 0;
+        for (;
+             filled &&
+             iterationCount < engine->cycleDetectionLimit &&
+             (nextResult = AspTreeNext
+                (engine, tree, nextResult.node, true)).node != 0;
+             iterationCount++)
+        {
+            uint32_t hash;
+            filled =
+                KeyNodeHash(engine, nextResult.node, &hash) ==
+                AspRunResult_OK &&
+                AddHashSlot
+                    (engine, root, AspIndex(engine, nextResult.node), hash);
+        }
+        if (iterationCount >= engine->cycleDetectionLimit)
+            filled = false;
+    }
+    if (!filled)
+    {
+        FreeHashChunks(engine, rootIndex);
+        return false;
+    }
+
+    AspDataSetTreeHashIndex(tree, rootIndex);
+    return true;
+}
+
+static bool AddHashSlot
+    (AspEngine *engine, AspDataEntry *root, uint32_t nodeIndex, uint32_t hash)
+{
+    uint32_t mask = (1U << HashIndexBitSize(root)) - 1U;
+    uint32_t position = hash & mask;
+    for (uint32_t probeCount = 0; probeCount <= mask;
+         probeCount++, position = (position + 1U) & mask)
+    {
+        AspDataEntry *chunk = HashSlotChunk(engine, root, position, true);
+        if (chunk == 0)
+            return false;
+        unsigned slot = position % AspDataGetTreeHashChunkSlotCapacity();
+        if (AspDataGetTreeHashChunkNodeIndex(chunk, slot) == 0)
+        {
+            AspDataSetTreeHashChunkNodeIndex(chunk, slot, nodeIndex);
+            AspDataSetTreeHashChunkHash(chunk, slot, hash);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static AspDataEntry *HashSlotChunk
+    (AspEngine *engine, AspDataEntry *root, uint32_t position, bool extend)
+{
+    /* Descend to the level zero chunk holding the slot at the given
+       position, adding chunks along the way if requested. Return null if
+       the chunk does not exist and could not be added. */
+    uint32_t offset = position / AspDataGetTreeHashChunkSlotCapacity();
+    unsigned slotMask = AspDataGetTreeHashChunkCapacity() - 1U;
+    AspDataEntry *chunk = root;
+    for (unsigned level = AspDataGetTreeHashChunkLevel(root);
+         level > 0; level--)
+    {
+        unsigned slot =
+            (offset >> (HashChunkSlotBitSize * (level - 1U))) & slotMask;
+        uint32_t childIndex = AspDataGetTreeHashChunkChildIndex(chunk, slot);
+        if (childIndex == 0)
+        {
+            AspDataEntry *child = extend ?
+                NewHashChunk(engine, level - 1U) : 0;
+            if (child == 0)
+                return 0;
+            childIndex = AspIndex(engine, child);
+            AspDataSetTreeHashChunkChildIndex(chunk, slot, childIndex);
+        }
+        chunk = AspEntry(engine, childIndex);
+    }
+
+    return chunk;
+}
+
+static unsigned HashIndexBitSize(const AspDataEntry *root)
+{
+    /* The root chunk spans twice four slots per level below it, of which
+       only half are used if so marked. */
+    return
+        HashChunkSlotBitSize * AspDataGetTreeHashChunkLevel(root) +
+        (AspDataGetTreeHashChunkIsHalf(root) ? 0U : 1U);
+}
+
+static unsigned HashBitSizeForCount(int32_t count)
+{
+    /* Leave the table no more than a quarter full. */
+    unsigned bitSize = MinHashBitSize;
+    while (bitSize < MaxHashBitSize && (1U << bitSize) / 4U < (uint32_t)count)
+        bitSize++;
+    return bitSize;
+}
+
+static AspDataEntry *NewHashChunk(AspEngine *engine, unsigned level)
+{
+    if (!CanAllocateHashChunks(engine, 1))
+        return 0;
+    AspDataEntry *chunk = AspAllocEntry(engine, DataType_TreeHashChunk);
+    if (chunk == 0)
+        return 0;
+    AspDataSetTreeHashChunkLevel(chunk, level);
+    return chunk;
+}
+
+static bool CanAllocateHashChunks(AspEngine *engine, size_t count)
+{
+    /* Leave a good part of the data area for everything else, as the index
+       is merely an optimization. */
+    return engine->freeCount > count +
+        engine->dataEndIndex / ASP_TREE_HASH_INDEX_FREE_DIVISOR;
+}
+
+static void FreeHashChunks(AspEngine *engine, uint32_t rootIndex)
+{
+    /* Free the chunks depth first, remembering the path from the root. */
+    uint32_t pathIndices[AspWordBitSize / 2U + 1U];
+    unsigned pathSlots[AspWordBitSize / 2U + 1U];
+    unsigned capacity = AspDataGetTreeHashChunkCapacity();
+    unsigned depth = 0;
+    pathIndices[0] = rootIndex;
+    pathSlots[0] = 0;
+    for (;;)
+    {
+        AspDataEntry *chunk = AspEntry(engine, pathIndices[depth]);
+        uint32_t childIndex = 0;
+        if (AspDataGetTreeHashChunkLevel(chunk) != 0)
+        {
+            for (; childIndex == 0 && pathSlots[depth] < capacity;
+                 pathSlots[depth]++)
+            {
+                unsigned slot = pathSlots[depth];
+                childIndex = AspDataGetTreeHashChunkChildIndex(chunk, slot);
+            }
+        }
+        if (childIndex != 0 && depth < AspWordBitSize / 2U)
+        {
+            depth++;
+            pathIndices[depth] = childIndex;
+            pathSlots[depth] = 0;
+            continue;
+        }
+
+        AspUnref(engine, chunk);
+        if (engine->runResult != AspRunResult_OK || depth == 0)
+            break;
+        depth--;
+    }
+}
+
+#endif /* ASP_HASHED_COLLECTIONS */
+
 #ifdef ASP_TEST
 
 bool AspTreeIsRedBlack(AspEngine *engine, const AspDataEntry *tree)
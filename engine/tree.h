@@ -38,6 +38,21 @@ AspTreeResult AspTreeNext
     (AspEngine *, const AspDataEntry *tree,
      const AspDataEntry *node, bool right);
 
+/* Namespace slots, used for direct access to local variables. */
+void AspReserveNamespaceSlots
+    (AspEngine *, AspDataEntry *ns, unsigned count);
+AspDataEntry *AspNamespaceSlotNode
+    (AspEngine *, const AspDataEntry *ns, unsigned slot);
+void AspSetNamespaceSlotNode
+    (AspEngine *, const AspDataEntry *ns, unsigned slot,
+     const AspDataEntry *node);
+void AspReleaseNamespaceSlots(AspEngine *, AspDataEntry *ns);
+
+#ifdef ASP_HASHED_COLLECTIONS
+/* Hash index of a set or dictionary, kept alongside its tree. */
+void AspTreeDropHashIndex(AspEngine *, AspDataEntry *tree);
+#endif
+
 #ifdef ASP_TEST
 bool AspTreeIsRedBlack(AspEngine *, const AspDataEntry *tree);
 unsigned AspTreeTally(AspEngine *, const AspDataEntry *tree);
@@ -24,6 +24,12 @@ typedef struct AspSourceLocation
     unsigned line, column;
 } AspSourceLocation;
 
+typedef struct AspFunctionLocation
+{
+    const char *name;
+    AspSourceLocation location;
+} AspFunctionLocation;
+
 ASP_API const char *AspAddCodeResultToString(int result);
 ASP_API const char *AspRunResultToString(int result);
 ASP_API AspSourceInfo *AspLoadSourceInfoFromFile
@@ -37,6 +43,8 @@ ASP_API const char *AspGetSourceFileName
     (const AspSourceInfo *, unsigned index);
 ASP_API const char *AspGetSymbolName
     (const AspSourceInfo *, int32_t symbol);
+ASP_API AspFunctionLocation AspGetFunctionLocation
+    (const AspSourceInfo *, size_t pc);
 
 #ifdef __cplusplus
 }
@@ -7,13 +7,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <limits.h>
 #include <stdint.h>
 #include <stdbool.h>
 
 static bool FinishLoad(AspSourceInfo *);
-static unsigned long ScanSourceFileNames
-    (const AspSourceInfo *, unsigned index, bool init);
+static const char **IndexNames
+    (const char *names, const char *end, unsigned *count,
+     const char **next);
 static uint32_t LoadValue(const uint8_t *p);
 
 #define SourceInfoHeaderSize 8
@@ -22,6 +22,11 @@ static const unsigned SourceInfo_ProgramCounterOffset = 0 * 4;
 static const unsigned SourceInfo_SourceIndexOffset = 1 * 4;
 static const unsigned SourceInfo_LineOffset = 2 * 4;
 static const unsigned SourceInfo_ColumnOffset = 3 * 4;
+static const size_t CodeRangeRecordSize = 4 * 4;
+static const unsigned CodeRange_StartOffset = 0 * 4;
+static const unsigned CodeRange_EndOffset = 1 * 4;
+static const unsigned CodeRange_SymbolOffset = 2 * 4;
+static const unsigned CodeRange_LineOffset = 3 * 4;
 
 struct AspSourceInfo
 {
@@ -29,8 +34,15 @@ struct AspSourceInfo
     char version;
     size_t size;
     char *data;
+    const char **sourceFileNames;
+    unsigned sourceFileNameCount;
     const uint8_t *sourceInfos;
+    size_t sourceInfoCount;
     const char *symbolNames;
+    const char **symbolNameIndex;
+    unsigned symbolNameCount;
+    const uint8_t *codeRanges;
+    size_t codeRangeCount;
 };
 
 AspSourceInfo *AspLoadSourceInfoFromFile(const char *fileName)
@@ -93,6 +105,8 @@ AspSourceInfo *AspLoadSourceInfoFromFile(const char *fileName)
         fclose(fp);
         return 0;
     }
+    info->sourceFileNames = 0;
+    info->symbolNameIndex = 0;
     info->version = version;
     info->size = (size_t)tellResult - SourceInfoHeaderSize;
     if (version >= 0x01)
@@ -141,6 +155,8 @@ AspSourceInfo *AspLoadSourceInfo(const char *data, size_t size)
     AspSourceInfo *info = (AspSourceInfo *)malloc(sizeof(AspSourceInfo));
     if (info == 0)
         return 0;
+    info->sourceFileNames = 0;
+    info->symbolNameIndex = 0;
     info->version = version;
     info->size = size - SourceInfoHeaderSize;
     info->data = (char *)data + SourceInfoHeaderSize;
@@ -163,97 +179,96 @@ AspSourceInfo *AspLoadSourceInfo(const char *data, size_t size)
 
 static bool FinishLoad(AspSourceInfo *info)
 {
-    /* Locate the end of the list of source file names. */
-    unsigned long offset = ScanSourceFileNames(info, UINT_MAX, true);
-    if (offset == ULONG_MAX)
+    /* Index the source file names, so that each may be looked up
+       directly. */
+    const char *end = info->data + info->size;
+    const char *next;
+    info->sourceFileNames = IndexNames
+        (info->data, end, &info->sourceFileNameCount, &next);
+    if (info->sourceFileNames == 0)
         return false;
 
-    /* Mark the start of the source info records. */
-    info->sourceInfos = (uint8_t *)info->data + offset + 1;
-
-    /* Mark the start of the symbol names, if present. */
+    /* Count the source info records, which are in order of program
+       counter, including any final out of bounds record. */
+    info->sourceInfos = (const uint8_t *)next;
+    info->sourceInfoCount = 0;
     info->symbolNames = 0;
-    if (info->version >= 0x01)
+    for (const uint8_t *p = info->sourceInfos;
+         p + SourceInfoRecordSize <= (const uint8_t *)end;
+         p += SourceInfoRecordSize)
     {
-        /* Locate the end of the list of source info records. */
-        for (const uint8_t *p = info->sourceInfos;
-             p < (const uint8_t *)info->data + info->size;
-             p += SourceInfoRecordSize)
+        info->sourceInfoCount++;
+
+        /* In newer formats, the final record precedes the symbol names. */
+        if (info->version >= 0x01 &&
+            LoadValue(p + SourceInfo_SourceIndexOffset) == UINT32_MAX)
         {
-            uint32_t sourceIndex = LoadValue
-                (p + SourceInfo_SourceIndexOffset);
-            if (sourceIndex == UINT32_MAX)
-            {
-                info->symbolNames = (const char *)p + SourceInfoRecordSize;
-                break;
-            }
+            info->symbolNames = (const char *)p + SourceInfoRecordSize;
+            break;
         }
     }
 
+    /* Index the symbol names, if present. */
+    info->symbolNameCount = 0;
+    info->codeRanges = 0;
+    info->codeRangeCount = 0;
+    if (info->symbolNames == 0)
+        return true;
+    info->symbolNameIndex = IndexNames
+        (info->symbolNames, end, &info->symbolNameCount, &next);
+    if (info->symbolNameIndex == 0)
+        return false;
+
+    /* Count the code address ranges, if present, which are in order of
+       address. */
+    if (info->version >= 0x02)
+    {
+        info->codeRanges = (const uint8_t *)next;
+        for (const uint8_t *p = info->codeRanges;
+             p + CodeRangeRecordSize <= (const uint8_t *)end &&
+             LoadValue(p + CodeRange_StartOffset) != UINT32_MAX;
+             p += CodeRangeRecordSize)
+            info->codeRangeCount++;
+    }
+
     return true;
 }
 
 void AspUnloadSourceInfo(AspSourceInfo *info)
 {
+    free(info->sourceFileNames);
+    free(info->symbolNameIndex);
     if (info->owned)
         free(info->data);
     free(info);
 }
 
-static unsigned long ScanSourceFileNames
-    (const AspSourceInfo *info, unsigned index, bool init)
-{
-    /* Scan through the appropriate number of source file names. */
-    unsigned count = 0;
-    unsigned long offset = 0;
-    while (count < index)
-    {
-        unsigned long offset2 = offset;
-        while (info->data[offset2] != '\0')
-        {
-            offset2++;
-            if (offset2 >= info->size)
-                return ULONG_MAX;
-        }
-        if (offset2 == offset)
-        {
-            if (!init)
-                return ULONG_MAX;
-            break;
-        }
-        offset = offset2 + 1;
-        count++;
-    }
-
-    /* For initialization, return the offset of the ending null file name.
-       Otherwise, indicate that the index is out of range. */
-    return init || info->data[offset] != '\0' ? offset : ULONG_MAX;
-}
-
 AspSourceLocation AspGetSourceLocation
     (const AspSourceInfo *info, size_t pc)
 {
-    /* Locate the applicable source info record. */
-    const uint8_t *p = info->sourceInfos, *pp = p;
-    uint32_t infoProgramCounter = 0;
-    bool found = false;
-    for (; p < (const uint8_t *)info->data + info->size;
-         p += SourceInfoRecordSize)
+    AspSourceLocation result;
+    result.fileName = 0;
+    result.line = result.column = 0;
+    if (info->sourceInfoCount == 0)
+        return result;
+
+    /* Locate the last source info record at or before the given program
+       counter, or the first record if there is none. */
+    size_t low = 0, high = info->sourceInfoCount;
+    while (high - low > 1)
     {
-        infoProgramCounter = LoadValue
-            (p + SourceInfo_ProgramCounterOffset);
-        if (infoProgramCounter >= pc)
-        {
-            found = true;
-            break;
-        }
-        pp = p;
+        size_t middle = low + (high - low) / 2;
+        uint32_t infoProgramCounter = LoadValue
+            (info->sourceInfos + middle * SourceInfoRecordSize +
+             SourceInfo_ProgramCounterOffset);
+        if (infoProgramCounter <= pc)
+            low = middle;
+        else
+            high = middle;
     }
-    if (!found || infoProgramCounter > pc)
-        p = pp;
+    const uint8_t *p = info->sourceInfos + low * SourceInfoRecordSize;
 
     /* Look up the source file name. */
-    AspSourceLocation result;
     uint32_t sourceIndex = LoadValue(p + SourceInfo_SourceIndexOffset);
     result.fileName = AspGetSourceFileName(info, (unsigned)sourceIndex);
 
@@ -266,8 +281,8 @@ AspSourceLocation AspGetSourceLocation
 const char *AspGetSourceFileName
     (const AspSourceInfo *info, unsigned index)
 {
-    unsigned long offset = ScanSourceFileNames(info, index, false);
-    return offset == ULONG_MAX ? 0 : info->data + offset;
+    return index < info->sourceFileNameCount ?
+        info->sourceFileNames[index] : 0;
 }
 
 const char *AspGetSymbolName
@@ -284,14 +299,80 @@ const char *AspGetSymbolName
     if (symbol == AspSystemMainModuleSymbol)
         return AspSystemMainModuleName;
     symbol -= AspScriptSymbolBase;
-    for (const char *p = info->symbolNames;
-         p < info->data + info->size && *p != '\0';
-         p += strlen(p) + 1, symbol--)
+    return symbol >= 0 && (uint32_t)symbol < info->symbolNameCount ?
+        info->symbolNameIndex[symbol] : "";
+}
+
+AspFunctionLocation AspGetFunctionLocation
+    (const AspSourceInfo *info, size_t pc)
+{
+    AspFunctionLocation result;
+    result.name = 0;
+    result.location.fileName = 0;
+    result.location.line = result.location.column = 0;
+    if (info->codeRangeCount == 0)
+        return result;
+
+    /* Locate the last code address range starting at or before the given
+       address, and check that the range contains it. */
+    size_t low = 0, high = info->codeRangeCount;
+    while (high - low > 1)
     {
-        if (symbol == 0)
-            return p;
+        size_t middle = low + (high - low) / 2;
+        uint32_t start = LoadValue
+            (info->codeRanges + middle * CodeRangeRecordSize +
+             CodeRange_StartOffset);
+        if (start <= pc)
+            low = middle;
+        else
+            high = middle;
     }
-    return "";
+    const uint8_t *p = info->codeRanges + low * CodeRangeRecordSize;
+    uint32_t start = LoadValue(p + CodeRange_StartOffset);
+    uint32_t end = LoadValue(p + CodeRange_EndOffset);
+    if (pc < start || pc >= end)
+        return result;
+
+    /* Identify the module or function, which is defined in the same source
+       file as its code. */
+    int32_t symbol = (int32_t)LoadValue(p + CodeRange_SymbolOffset);
+    result.name = AspGetSymbolName(info, symbol);
+    result.location.fileName = AspGetSourceLocation(info, start).fileName;
+    result.location.line = (unsigned)LoadValue(p + CodeRange_LineOffset);
+    return result;
+}
+
+static const char **IndexNames
+    (const char *names, const char *end, unsigned *count,
+     const char **next)
+{
+    /* Count the names, which are terminated by an empty name. */
+    *count = 0;
+    const char *p = names;
+    for (; p < end && *p != '\0'; (*count)++)
+    {
+        const char *nameEnd = memchr(p, '\0', (size_t)(end - p));
+        if (nameEnd == 0)
+            return 0;
+        p = nameEnd + 1;
+    }
+    if (p >= end)
+        return 0;
+    *next = p + 1;
+
+    /* Note where each name starts. */
+    const char **index = (const char **)malloc
+        ((*count == 0 ? 1 : *count) * sizeof *index);
+    if (index == 0)
+        return 0;
+    p = names;
+    for (unsigned i = 0; i < *count; i++)
+    {
+        index[i] = p;
+        p += strlen(p) + 1;
+    }
+
+    return index;
 }
 
 static uint32_t LoadValue(const uint8_t *buffer)
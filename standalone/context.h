@@ -6,11 +6,13 @@
 #define ASPS_CONTEXT_H
 
 #include <ctime>
+#include <string>
 
 typedef struct
 {
     bool sleeping;
     clock_t expiry;
+    std::string *output; /* Printed output, or null for standard output. */
 } StandaloneAspContext;
 
 #endif
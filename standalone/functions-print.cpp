@@ -4,12 +4,14 @@
 
 #include "asp.h"
 #include "standalone.h"
+#include "context.h"
 #include <stdio.h>
 
 static AspRunResult asp_print1(AspEngine *, AspDataEntry *);
 
 /* print(*values, sep, end)
- * Print values to standard output.
+ * Print values to standard output, or to the engine's output buffer if it
+ * has one (e.g., when running on a worker thread).
  * Separate individual items with the sep value and finish with the end value.
  */
 extern "C" AspRunResult asp_print
@@ -49,6 +51,9 @@ extern "C" AspRunResult asp_print
 static AspRunResult asp_print1
     (AspEngine *engine, AspDataEntry *value)
 {
+    auto context = static_cast<StandaloneAspContext *>
+        (AspContext(engine));
+
     AspDataEntry *valueString = AspToString(engine, value);
     if (valueString == nullptr)
         return AspRunResult_OutOfDataMemory;
@@ -63,8 +68,13 @@ static AspRunResult asp_print1
             bufferLen = size - index;
         AspStringValue
             (engine, valueString, nullptr, buffer, index, sizeof buffer);
-        for (size_t byteIndex = 0; byteIndex < bufferLen; byteIndex++)
-            putchar(buffer[byteIndex]);
+        if (context->output != nullptr)
+            context->output->append(buffer, bufferLen);
+        else
+        {
+            for (size_t byteIndex = 0; byteIndex < bufferLen; byteIndex++)
+                putchar(buffer[byteIndex]);
+        }
     }
 
     AspUnref(engine, valueString);
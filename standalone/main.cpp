@@ -7,15 +7,33 @@
 #include "standalone.h"
 #include "context.h"
 #include <ctime>
+#include <chrono>
 #include <iostream>
 #include <iomanip>
+#include <fstream>
+#include <sstream>
 #include <set>
+#include <map>
+#include <vector>
+#include <memory>
 #include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
 #include <cstring>
 #include <cstdio>
 #include <cstdlib>
 #include <cerrno>
 #include <climits>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+#ifdef HAVE_POSIX_FADVISE
+#include <fcntl.h>
+#endif
+#ifdef ASP_OPCODE_PROFILE
+#include <algorithm>
+#endif
 
 #ifndef COMMAND_OPTION_PREFIXES
 #error COMMAND_OPTION_PREFIXES macro undefined
@@ -24,9 +42,73 @@
 using namespace std;
 
 static const size_t DEFAULT_DATA_ENTRY_COUNT = 2048;
+static const uint32_t RUN_STEP_LIMIT = 10000;
+static const uint32_t DEFAULT_SAMPLE_INTERVAL = 1000;
+static const uint32_t DEADLINE_CHECK_INTERVAL = 1000;
+
+// Distance beyond which an advance of the program counter is taken to be a
+// jump rather than the execution of the next instruction.
+static const size_t CODE_TRACE_ADVANCE_LIMIT = 16;
 
 static AspRunResult LoadCodePage
     (void *, uint32_t offset, size_t *size, void *codePage);
+static mutex sharedCodePageMutex;
+static AspRunResult LoadSharedCodePage
+    (void *, uint32_t offset, size_t *size, void *codePage);
+static void LockCodePageCache(void *, bool lock);
+#ifdef HAVE_POSIX_FADVISE
+static atomic<size_t> codePagePrefetchCount(0);
+static void PrefetchCodePage(void *, uint32_t offset, size_t size);
+#endif
+
+// The outcome of running the script with one set of arguments.
+struct ArgumentSetRun
+{
+    string output;
+    AspRunResult result = AspRunResult_OK;
+    size_t programCounter = 0;
+    unsigned long long stepCount = 0;
+    size_t codePageReadCount = 0, codePageHitCount = 0;
+};
+static void RunArgumentSets
+    (const AspEngine *, size_t dataByteSize,
+     const vector<string> &argumentSets, unsigned threadCount,
+     vector<ArgumentSetRun> &runs);
+static void ReportRunError
+    (FILE *, AspRunResult, size_t programCounter,
+     const string &sourceInfoFileName);
+static void ReportDataStatistics(FILE *, const AspEngine *);
+
+// Wall-clock deadline of a run, checked by the engine between instructions.
+struct RunDeadline
+{
+    chrono::steady_clock::time_point time;
+    bool expired = false;
+};
+static bool CheckDeadline(void *);
+
+// Counts of sampled script call stacks, keyed by the code addresses within
+// each frame of the stack, innermost first.
+using CallStackSamples = map<vector<size_t>, unsigned long long>;
+static void SampleCallStack(const AspEngine *, CallStackSamples &);
+static void WriteCallStackSamples
+    (FILE *, const CallStackSamples &, const string &sourceInfoFileName);
+
+#ifdef ASP_OPCODE_PROFILE
+// Counts of executed instruction sequences (n-grams), keyed by the op codes
+// of the sequence packed into an integer, first op code most significant.
+struct OpCodeProfile
+{
+    static const unsigned MAX_LENGTH = 3;
+    uint32_t history = 0;
+    unsigned historySize = 0;
+    map<uint32_t, unsigned long long> counts[MAX_LENGTH];
+};
+static void ProfileOpCode(void *, uint8_t opCode);
+static void ReportOpCodeProfile
+    (FILE *, const OpCodeProfile &, unsigned topCount);
+static void WriteProfile(FILE *, const AspProfile &);
+#endif
 
 static void Usage()
 {
@@ -62,6 +144,11 @@ static void Usage()
         << COMMAND_OPTION_PREFIXES[0]
         << "v          Verbose. Output version and statistical information.\n"
         << COMMAND_OPTION_PREFIXES[0]
+        << "M          Report data area usage on exit: the number of entries"
+        << " of each type\n"
+        << "            in use, the free and low free counts, and the peak"
+        << " stack depth.\n"
+        << COMMAND_OPTION_PREFIXES[0]
         << "c n        Code size, in bytes."
         << " The default behaviour is to determine the size\n"
         << "            from the SCRIPT file."
@@ -76,6 +163,82 @@ static void Usage()
         << " disables paging\n"
         << "            mode. The number of pages is this value divided by the"
         << " code size.\n"
+        << COMMAND_OPTION_PREFIXES[0]
+        << "e policy   Code page replacement policy, either lru (least"
+        << " recently used) or\n"
+        << "            clock. Default is lru.\n"
+        << COMMAND_OPTION_PREFIXES[0]
+        << "k address  In paging mode, keep the code page containing the"
+        << " given code\n"
+        << "            address (e.g., of a frequently called function) in"
+        << " memory. May be\n"
+        << "            repeated.\n"
+        << COMMAND_OPTION_PREFIXES[0]
+        << "g file     Write a trace of the code addresses visited to file,"
+        << " for use with\n"
+        << "            the compiler's " << COMMAND_OPTION_PREFIXES[0]
+        << "g option. Each time control is transferred, the\n"
+        << "            addresses of the last instruction executed and of"
+        << " the next one\n"
+        << "            are written, one per line. Instructions are executed"
+        << " one at a time\n"
+        << "            while tracing.\n"
+        << COMMAND_OPTION_PREFIXES[0]
+        << "S file     Sample the script's call stack periodically and write"
+        << " the number of\n"
+        << "            times each stack was seen to file in folded form,"
+        << " for use with\n"
+        << "            flame graph tools.\n"
+        << COMMAND_OPTION_PREFIXES[0]
+        << "i n        Number of instructions between call stack samples."
+        << " Default is "
+        << DEFAULT_SAMPLE_INTERVAL << ".\n"
+        << COMMAND_OPTION_PREFIXES[0]
+        << "l s        Stop the script once it has run for s seconds of"
+        << " wall-clock time.\n"
+        << "            The time is checked every "
+        << DEADLINE_CHECK_INTERVAL << " instructions.\n"
+        << COMMAND_OPTION_PREFIXES[0]
+        << "r n        Run the script n times. Before each run after the first,"
+        << " the engine\n"
+        << "            state is restored from a snapshot taken before the"
+        << " first run.\n"
+        << "            Default is 1.\n"
+        << COMMAND_OPTION_PREFIXES[0]
+        << "a file     Run the script once for each line of file, which gives"
+        << " the\n"
+        << "            arguments for that run. Runs are distributed across"
+        << " worker threads,\n"
+        << "            each using a fork of the loaded engine."
+        << " Output is reported in\n"
+        << "            order once all runs are done."
+        << " In paging mode, the engines\n"
+        << "            share one code page cache, and the number of worker"
+        << " threads is\n"
+        << "            limited to one less than the number of pages.\n"
+        << COMMAND_OPTION_PREFIXES[0]
+        << "j n        Number of worker threads used with the "
+        << COMMAND_OPTION_PREFIXES[0] << "a option.\n"
+        << "            Default is the number of hardware threads.\n"
+        #ifdef HAVE_POSIX_FADVISE
+        << COMMAND_OPTION_PREFIXES[0]
+        << "f n        Code page read-ahead offset, in bytes. In paging mode,"
+        << " ask the system\n"
+        << "            to read the next page once execution passes this"
+        << " offset within a\n"
+        << "            page, and to read pages containing jump and call"
+        << " targets. An offset\n"
+        << "            of at least the page size disables only the former."
+        << " By default,\n"
+        << "            pages are read only when needed.\n"
+        #endif
+        #ifdef HAVE_MMAP
+        << COMMAND_OPTION_PREFIXES[0]
+        << "m          Read the SCRIPT file into memory instead of mapping it."
+        << " Applies only\n"
+        << "            when the code size is determined from the SCRIPT"
+        << " file.\n"
+        #endif
         #ifdef ASP_DEBUG
         << COMMAND_OPTION_PREFIXES[0]
         << "n n        Number of instructions to execute before exiting."
@@ -109,6 +272,21 @@ static void Usage()
         << "            " << COMMAND_OPTION_PREFIXES[0] << "u or "
         << COMMAND_OPTION_PREFIXES[0] << "U option.\n"
         #endif
+        #ifdef ASP_OPCODE_PROFILE
+        << COMMAND_OPTION_PREFIXES[0]
+        << "P n        Report the n most frequently executed instruction"
+        << " sequences of\n"
+        << "            each length up to " << OpCodeProfile::MAX_LENGTH
+        << ". Available only in profiling builds.\n"
+        << COMMAND_OPTION_PREFIXES[0]
+        << "F file     Write execution counts to file, for use with aspinfo's "
+        << COMMAND_OPTION_PREFIXES[0] << "f\n"
+        << "            option. Gives the number of executions and data"
+        << " allocations of each\n"
+        << "            op code, and the number of executions of each"
+        << " instruction by code\n"
+        << "            address. Available only in profiling builds.\n"
+        #endif
         ;
 }
 
@@ -128,14 +306,35 @@ template<class C> static void CloseFiles(C files)
 int main(int argc, char **argv)
 {
     // Process command line options.
-    bool verbose = false;
+    bool verbose = false, reportData = false;
     size_t codeByteCount = 0, codePageByteCount = 0;
+    AspCodePagePolicy codePagePolicy = AspCodePagePolicy_LRU;
+    vector<uint32_t> pinnedCodeAddresses;
+    string codeTraceFileName;
+    string callStackFileName;
+    uint32_t sampleInterval = DEFAULT_SAMPLE_INTERVAL;
     size_t dataEntryCount = DEFAULT_DATA_ENTRY_COUNT;
+    unsigned runCount = 1;
+    double timeLimit = 0.0;
+    string argumentSetsFileName;
+    unsigned threadCount = thread::hardware_concurrency();
+    #ifdef HAVE_POSIX_FADVISE
+    bool prefetchCode = false;
+    size_t readAheadOffset = 0;
+    #endif
+    #ifdef HAVE_MMAP
+    bool mapExecutable = true;
+    #endif
     #ifdef ASP_DEBUG
     unsigned stepCountLimit = UINT_MAX;
     string traceFileName, dumpFileName;
     int traceFileDescriptor = 0, dumpFileDescriptor = 0;
     #endif
+    #ifdef ASP_OPCODE_PROFILE
+    unsigned profileTopCount = 0;
+    OpCodeProfile opCodeProfile;
+    string profileFileName;
+    #endif
     for (; argc >= 2; argc--, argv++)
     {
         string arg1 = argv[1];
@@ -174,6 +373,70 @@ int main(int argc, char **argv)
             argc--;
             codePageByteCount = static_cast<size_t>(atoi(value.c_str()));
         }
+        else if (option == "e")
+        {
+            string value = (++argv)[1];
+            argc--;
+            if (value == "lru")
+                codePagePolicy = AspCodePagePolicy_LRU;
+            else if (value == "clock")
+                codePagePolicy = AspCodePagePolicy_Clock;
+            else
+            {
+                cerr << "Invalid code page policy " << value << endl;
+                return 1;
+            }
+        }
+        else if (option == "k")
+        {
+            string value = (++argv)[1];
+            argc--;
+            pinnedCodeAddresses.push_back
+                (static_cast<uint32_t>(strtoul(value.c_str(), 0, 0)));
+        }
+        else if (option == "g")
+        {
+            codeTraceFileName = (++argv)[1];
+            argc--;
+        }
+        else if (option == "S")
+        {
+            callStackFileName = (++argv)[1];
+            argc--;
+        }
+        else if (option == "i")
+        {
+            string value = (++argv)[1];
+            argc--;
+            sampleInterval = static_cast<uint32_t>(atoi(value.c_str()));
+            if (sampleInterval == 0)
+                sampleInterval = 1;
+        }
+        else if (option == "l")
+        {
+            string value = (++argv)[1];
+            argc--;
+            timeLimit = atof(value.c_str());
+        }
+        else if (option == "r")
+        {
+            string value = (++argv)[1];
+            argc--;
+            runCount = static_cast<unsigned>(atoi(value.c_str()));
+            if (runCount == 0)
+                runCount = 1;
+        }
+        else if (option == "a")
+        {
+            argumentSetsFileName = (++argv)[1];
+            argc--;
+        }
+        else if (option == "j")
+        {
+            string value = (++argv)[1];
+            argc--;
+            threadCount = static_cast<unsigned>(atoi(value.c_str()));
+        }
         #ifdef ASP_DEBUG
         else if (option == "n")
         {
@@ -220,8 +483,36 @@ int main(int argc, char **argv)
             dumpFileName.clear();
         }
         #endif
+        #ifdef HAVE_POSIX_FADVISE
+        else if (option == "f")
+        {
+            string value = (++argv)[1];
+            argc--;
+            prefetchCode = true;
+            readAheadOffset = static_cast<size_t>(atoi(value.c_str()));
+        }
+        #endif
+        #ifdef HAVE_MMAP
+        else if (option == "m")
+            mapExecutable = false;
+        #endif
+        #ifdef ASP_OPCODE_PROFILE
+        else if (option == "P")
+        {
+            string value = (++argv)[1];
+            argc--;
+            profileTopCount = static_cast<unsigned>(atoi(value.c_str()));
+        }
+        else if (option == "F")
+        {
+            profileFileName = (++argv)[1];
+            argc--;
+        }
+        #endif
         else if (option == "v")
             verbose = true;
+        else if (option == "M")
+            reportData = true;
         else
         {
             cerr << "Invalid option: " << arg1 << endl;
@@ -265,6 +556,109 @@ int main(int argc, char **argv)
     set<FILE *> openedFiles;
     openedFiles.insert(executableFile);
 
+    if (timeLimit > 0.0 && !argumentSetsFileName.empty())
+    {
+        cerr
+            << "Time limit not supported with "
+            << COMMAND_OPTION_PREFIXES[0] << 'a' << endl;
+        CloseFiles(openedFiles);
+        return 1;
+    }
+
+    // Open the code address trace file.
+    FILE *codeTraceFile = nullptr;
+    if (!codeTraceFileName.empty())
+    {
+        if (!argumentSetsFileName.empty())
+        {
+            cerr
+                << "Code address trace not supported with "
+                << COMMAND_OPTION_PREFIXES[0] << 'a' << endl;
+            CloseFiles(openedFiles);
+            return 1;
+        }
+        codeTraceFile = fopen(codeTraceFileName.c_str(), "w");
+        if (codeTraceFile == nullptr)
+        {
+            cerr
+                << "Error opening code address trace file "
+                << codeTraceFileName << ": " << strerror(errno) << endl;
+            CloseFiles(openedFiles);
+            return 1;
+        }
+        openedFiles.insert(codeTraceFile);
+    }
+
+    // Open the call stack sample file.
+    FILE *callStackFile = nullptr;
+    CallStackSamples callStackSamples;
+    if (!callStackFileName.empty())
+    {
+        if (!argumentSetsFileName.empty())
+        {
+            cerr
+                << "Call stack sampling not supported with "
+                << COMMAND_OPTION_PREFIXES[0] << 'a' << endl;
+            CloseFiles(openedFiles);
+            return 1;
+        }
+        callStackFile = fopen(callStackFileName.c_str(), "w");
+        if (callStackFile == nullptr)
+        {
+            cerr
+                << "Error opening call stack sample file "
+                << callStackFileName << ": " << strerror(errno) << endl;
+            CloseFiles(openedFiles);
+            return 1;
+        }
+        openedFiles.insert(callStackFile);
+    }
+
+    // Open the execution profile file.
+    #ifdef ASP_OPCODE_PROFILE
+    FILE *profileFile = nullptr;
+    AspProfile profile = {};
+    vector<uint32_t> profileCounts;
+    if (!profileFileName.empty())
+    {
+        if (!argumentSetsFileName.empty())
+        {
+            cerr
+                << "Execution profile not supported with "
+                << COMMAND_OPTION_PREFIXES[0] << 'a' << endl;
+            CloseFiles(openedFiles);
+            return 1;
+        }
+        profileFile = fopen(profileFileName.c_str(), "w");
+        if (profileFile == nullptr)
+        {
+            cerr
+                << "Error opening execution profile file "
+                << profileFileName << ": " << strerror(errno) << endl;
+            CloseFiles(openedFiles);
+            return 1;
+        }
+        openedFiles.insert(profileFile);
+
+        // Provide a count for each code address in the executable.
+        long tellResult = -1;
+        if (fseek(executableFile, 0, SEEK_END) == 0)
+            tellResult = ftell(executableFile);
+        rewind(executableFile);
+        if (tellResult < 0)
+        {
+            cerr
+                << "Error determining size of " << executableFileName
+                << ": " << strerror(errno) << endl;
+            CloseFiles(openedFiles);
+            return 1;
+        }
+        profileCounts.resize(static_cast<size_t>(tellResult));
+        profile.pcCounts = profileCounts.data();
+        profile.pcCountsSize = profileCounts.size();
+    }
+    #endif
+
     // Open the trace and dump files.
     #ifdef ASP_DEBUG
     FILE *stdFiles[] = {nullptr, stdout, stderr};
@@ -353,8 +747,35 @@ int main(int argc, char **argv)
     AspTraceFile(&engine, traceFile);
     #endif
 
-    // Load the executable using one of three methods.
+    // Install the instruction profiler if requested.
+    #ifdef ASP_OPCODE_PROFILE
+    if (profileTopCount != 0)
+        AspSetOpCodeProfiler(&engine, ProfileOpCode, &opCodeProfile);
+    if (profileFile != nullptr)
+        AspSetProfile(&engine, &profile);
+    #endif
+
+    // Load the executable using one of several methods.
+    auto loadStartTime = chrono::steady_clock::now();
+    const char *loadMethod;
     auto externalCode = unique_ptr<char[]>();
+    uint16_t codePageCount = 0, pinnedCodePageCount = 0;
+    AspCodePageCache codePageCache;
+    auto codePageCacheArea = unique_ptr<char[]>();
+    mutex codePageCacheMutex;
+    #ifdef HAVE_MMAP
+    struct MappedCode
+    {
+        ~MappedCode()
+        {
+            if (address != MAP_FAILED)
+                munmap(address, size);
+        }
+
+        void *address = MAP_FAILED;
+        size_t size = 0;
+    } mappedCode;
+    #endif
     if (codeByteCount == 0)
     {
         if (codePageByteCount != 0)
@@ -377,32 +798,60 @@ int main(int argc, char **argv)
             return 2;
         }
         auto externalCodeSize = static_cast<size_t>(tellResult);
-        externalCode.reset(new char[externalCodeSize]);
-        if (externalCode == nullptr)
+        const char *externalCodeAddress = nullptr;
+
+        // Map the executable into memory if possible, allowing the engine
+        // to run the code directly from the file without copying it.
+        #ifdef HAVE_MMAP
+        if (mapExecutable && externalCodeSize != 0)
         {
-            cerr << "Error allocating memory for executable code" << endl;
-            CloseFiles(openedFiles);
-            return 2;
+            mappedCode.address = mmap
+                (nullptr, externalCodeSize, PROT_READ, MAP_PRIVATE,
+                 fileno(executableFile), 0);
+            if (mappedCode.address != MAP_FAILED)
+            {
+                mappedCode.size = externalCodeSize;
+                externalCodeAddress =
+                    static_cast<const char *>(mappedCode.address);
+                loadMethod = "mapped";
+            }
         }
-        rewind(executableFile);
+        #endif
 
-        // Read the entire executable into memory.
-        size_t readResult = fread
-            (externalCode.get(), externalCodeSize, 1U, executableFile);
-        if (readResult != 1U || feof(executableFile) || ferror(executableFile))
+        // Otherwise, read the entire executable into memory.
+        if (externalCodeAddress == nullptr)
         {
-            cerr
-                << "Error reading " << executableFileName
-                << ": " << strerror(errno) << endl;
-            CloseFiles(openedFiles);
-            return 2;
+            externalCode.reset(new char[externalCodeSize]);
+            if (externalCode == nullptr)
+            {
+                cerr
+                    << "Error allocating memory for executable code"
+                    << endl;
+                CloseFiles(openedFiles);
+                return 2;
+            }
+            rewind(executableFile);
+
+            size_t readResult = fread
+                (externalCode.get(), externalCodeSize, 1U, executableFile);
+            if (readResult != 1U ||
+                feof(executableFile) || ferror(executableFile))
+            {
+                cerr
+                    << "Error reading " << executableFileName
+                    << ": " << strerror(errno) << endl;
+                CloseFiles(openedFiles);
+                return 2;
+            }
+            externalCodeAddress = externalCode.get();
+            loadMethod = "read";
         }
         openedFiles.erase(executableFile);
         fclose(executableFile);
         executableFile = nullptr;
 
         AspAddCodeResult sealResult = AspSealCode
-            (&engine, externalCode.get(), externalCodeSize);
+            (&engine, externalCodeAddress, externalCodeSize);
         if (sealResult != AspAddCodeResult_OK)
         {
             cerr
@@ -416,11 +865,14 @@ int main(int argc, char **argv)
     }
     else if (codePageByteCount == 0)
     {
+        // Stream the executable into the engine's code area a block at a
+        // time.
+        loadMethod = "streamed";
+        char buffer[BUFSIZ];
         while (true)
         {
-            auto c = static_cast<char>(fgetc(executableFile));
-            if (feof(executableFile))
-                break;
+            size_t readCount = fread
+                (buffer, 1, sizeof buffer, executableFile);
             if (ferror(executableFile))
             {
                 cerr
@@ -429,7 +881,10 @@ int main(int argc, char **argv)
                 CloseFiles(openedFiles);
                 return 2;
             }
-            AspAddCodeResult addResult = AspAddCode(&engine, &c, 1);
+            if (readCount == 0)
+                break;
+            AspAddCodeResult addResult = AspAddCode
+                (&engine, buffer, readCount);
             if (addResult != AspAddCodeResult_OK)
             {
                 cerr
@@ -459,6 +914,7 @@ int main(int argc, char **argv)
     }
     else
     {
+        loadMethod = "paged";
         size_t computedCodePageCount = codeByteCount / codePageByteCount;
         if (computedCodePageCount == 0)
         {
@@ -468,14 +924,31 @@ int main(int argc, char **argv)
             CloseFiles(openedFiles);
             return 2;
         }
-        auto codePageCount = static_cast<uint8_t>(computedCodePageCount);
+        codePageCount = computedCodePageCount > UINT16_MAX ?
+            static_cast<uint16_t>(UINT16_MAX) :
+            static_cast<uint16_t>(computedCodePageCount);
         if (codePageCount != computedCodePageCount)
             cerr
                 << "WARNING: Number of code pages limited to "
-                << static_cast<unsigned>(codePageCount) << endl;
+                << codePageCount << endl;
 
-        AspRunResult setPagingResult = AspSetCodePaging
-            (&engine, codePageCount, codePageByteCount, LoadCodePage);
+        // When running argument sets, the engines forked from this one
+        // share a code page cache instead of each having their own pages.
+        AspRunResult setPagingResult;
+        if (argumentSetsFileName.empty())
+            setPagingResult = AspSetCodePaging
+                (&engine, codePageCount, codePageByteCount, LoadCodePage);
+        else
+        {
+            size_t codePageCacheSize = AspCodePageCacheSize
+                (codePageCount, codePageByteCount);
+            codePageCacheArea.reset(new char[codePageCacheSize]);
+            setPagingResult = AspInitializeCodePageCache
+                (&codePageCache, codePageCacheArea.get(), codePageCacheSize,
+                 codePageCount, codePageByteCount,
+                 LoadSharedCodePage, executableFile,
+                 LockCodePageCache, &codePageCacheMutex);
+        }
         if (setPagingResult != AspRunResult_OK)
         {
             cerr
@@ -487,7 +960,14 @@ int main(int argc, char **argv)
             return 2;
         }
 
-        AspAddCodeResult pageResult = AspPageCode(&engine, executableFile);
+        #ifdef HAVE_POSIX_FADVISE
+        if (prefetchCode)
+            AspSetCodePrefetcher(&engine, PrefetchCodePage, readAheadOffset);
+        #endif
+
+        AspAddCodeResult pageResult = argumentSetsFileName.empty() ?
+            AspPageCode(&engine, executableFile) :
+            AspShareCodePages(&engine, &codePageCache);
         if (pageResult != AspAddCodeResult_OK)
         {
             cerr
@@ -498,7 +978,29 @@ int main(int argc, char **argv)
             CloseFiles(openedFiles);
             return 2;
         }
+
+        // Apply the page replacement policy and pin the requested pages,
+        // which requires the code header to have been loaded.
+        AspSetCodePagePolicy(&engine, codePagePolicy);
+        for (auto address: pinnedCodeAddresses)
+        {
+            AspRunResult pinResult = AspPinCodePage(&engine, address);
+            if (pinResult != AspRunResult_OK)
+                cerr
+                    << "WARNING: Error 0x" << hex << uppercase
+                    << setfill('0') << setw(2) << pinResult
+                    << " pinning code page at 0x" << setw(7) << address
+                    << dec << setfill(' ') << ": "
+                    << AspRunResultToString(static_cast<int>(pinResult))
+                    << endl;
+            else
+                pinnedCodePageCount++;
+        }
     }
+    if (codePageCount == 0 && !pinnedCodeAddresses.empty())
+        cerr << "WARNING: Pinned code addresses ignored" << endl;
+    auto loadTime = chrono::duration<double>
+        (chrono::steady_clock::now() - loadStartTime).count();
 
     // Report version information.
     FILE *reportFile;
@@ -529,6 +1031,120 @@ int main(int argc, char **argv)
         fputc('\n', reportFile);
     }
 
+    // Determine the name of the source info file used to report the source
+    // location of errors.
+    size_t suffixPos = executableFileName.size() - executableSuffix.size();
+    static const string sourceInfoSuffix = ".aspd";
+    string sourceInfoFileName =
+        executableFileName.substr(0, suffixPos) + sourceInfoSuffix;
+
+    // Run the script once per argument set if requested.
+    if (!argumentSetsFileName.empty())
+    {
+        if (runCount > 1)
+            cerr << "WARNING: Run count ignored" << endl;
+        if (threadCount == 0)
+            threadCount = 1;
+        unsigned availableCodePageCount =
+            static_cast<unsigned>(codePageCount - pinnedCodePageCount);
+        if (codePageCount != 0 && threadCount >= availableCodePageCount)
+        {
+            if (availableCodePageCount <= 1)
+            {
+                cerr
+                    << "Argument sets require at least two unpinned"
+                    << " code pages" << endl;
+                CloseFiles(openedFiles);
+                return 1;
+            }
+            threadCount = availableCodePageCount - 1U;
+            cerr
+                << "WARNING: Number of threads limited to " << threadCount
+                << endl;
+        }
+
+        ifstream argumentSetsFile(argumentSetsFileName);
+        if (!argumentSetsFile)
+        {
+            cerr
+                << "Error opening " << argumentSetsFileName
+                << ": " << strerror(errno) << endl;
+            CloseFiles(openedFiles);
+            return 1;
+        }
+        vector<string> argumentSets;
+        string line;
+        while (getline(argumentSetsFile, line))
+            argumentSets.push_back(line);
+        argumentSetsFile.close();
+
+        vector<ArgumentSetRun> runs(argumentSets.size());
+        auto runStartTime = chrono::steady_clock::now();
+        RunArgumentSets
+            (&engine, dataByteSize, argumentSets, threadCount, runs);
+        auto runTime = chrono::duration<double>
+            (chrono::steady_clock::now() - runStartTime).count();
+        AspUnshareCodePages(&engine);
+
+        // Output the results of each run in order.
+        unsigned long long stepCount = 0;
+        size_t failedRunCount = 0;
+        size_t codePageReadCount = 0, codePageHitCount = 0;
+        for (size_t i = 0; i < runs.size(); i++)
+        {
+            const auto &run = runs[i];
+            fwrite(run.output.data(), 1, run.output.size(), stdout);
+            stepCount += run.stepCount;
+            codePageReadCount += run.codePageReadCount;
+            codePageHitCount += run.codePageHitCount;
+            if (run.result != AspRunResult_Complete)
+            {
+                failedRunCount++;
+                fflush(stdout);
+                fprintf(stderr, "Argument set %zu: ", i + 1);
+                ReportRunError
+                    (stderr, run.result, run.programCounter,
+                     sourceInfoFileName);
+            }
+        }
+
+        if (verbose)
+        {
+            fprintf
+                (reportFile, "Load time: %.6f s (%s)\n", loadTime, loadMethod);
+            fprintf
+                (reportFile, "Argument set count: %zu (%zu failed)\n",
+                 runs.size(), failedRunCount);
+            fprintf(reportFile, "Thread count: %u\n", threadCount);
+            fprintf
+                (reportFile, "Instruction count: %llu\n", stepCount);
+            fprintf
+                (reportFile,
+                 "Run time: %.6f s (%.0f runs/s, %.0f instructions/s)\n",
+                 runTime,
+                 runTime > 0.0 ? runs.size() / runTime : 0.0,
+                 runTime > 0.0 ? stepCount / runTime : 0.0);
+            if (codePageByteCount != 0)
+            {
+                fprintf
+                    (reportFile, "Code page read count: %zu\n",
+                     codePageReadCount);
+                fprintf
+                    (reportFile, "Code page hit count: %zu\n",
+                     codePageHitCount);
+                #ifdef HAVE_POSIX_FADVISE
+                if (prefetchCode)
+                    fprintf
+                        (reportFile, "Code page prefetch count: %zu\n",
+                         codePagePrefetchCount.load());
+                #endif
+            }
+        }
+
+        CloseFiles(openedFiles);
+        return failedRunCount == 0 ? 0 : 2;
+    }
+
     // Set arguments.
     AspRunResult argumentResult = AspSetArguments(&engine, argv + 2);
     if (argumentResult != AspRunResult_OK)
@@ -542,31 +1158,114 @@ int main(int argc, char **argv)
         return 2;
     }
 
+    // Capture the initial state if the script is to be run more than once.
+    auto snapshot = unique_ptr<char[]>();
+    size_t snapshotSize = 0;
+    if (runCount > 1)
+    {
+        snapshotSize = AspSnapshotSize(&engine);
+        snapshot.reset(new char[snapshotSize]);
+        AspRunResult snapshotResult = AspSaveSnapshot
+            (&engine, snapshot.get(), snapshotSize);
+        if (snapshotResult != AspRunResult_OK)
+        {
+            cerr
+                << "Snapshot error 0x" << hex << uppercase << setfill('0')
+                << setw(2) << snapshotResult << ": "
+                << AspRunResultToString(static_cast<int>(snapshotResult))
+                << endl;
+            CloseFiles(openedFiles);
+            return 2;
+        }
+    }
+
     // Run the code.
     context.sleeping = false;
+    context.output = nullptr;
     AspRunResult runResult = AspRunResult_OK;
-    unsigned stepCount = 0;
+    unsigned stepCount = 0, completedRunCount = 0;
+    uint32_t sampleStepCount = 0;
     #ifdef ASP_DEBUG
     if (stepCountLimit == UINT_MAX)
         fputs("Executing instructions indefinitely...\n", reportFile);
     else
         fprintf(reportFile, "Executing %u instructions...\n", stepCountLimit);
     #endif
-    for (;
-         runResult == AspRunResult_OK
-         #ifdef ASP_DEBUG
-         && (stepCountLimit == UINT_MAX || stepCount < stepCountLimit)
-         #endif
-         ; stepCount++)
-    {
-        runResult = AspStep(&engine);
+    auto runStartTime = chrono::steady_clock::now();
+    RunDeadline deadline;
+    if (timeLimit > 0.0)
+    {
+        deadline.time = runStartTime +
+            chrono::duration_cast<chrono::steady_clock::duration>
+                (chrono::duration<double>(timeLimit));
+        AspSetDeadlineChecker
+            (&engine, CheckDeadline, &deadline, DEADLINE_CHECK_INTERVAL);
+    }
+    if (codeTraceFile != nullptr)
+        fprintf(codeTraceFile, "0x%07zX\n", AspProgramCounter(&engine));
+    while (runResult == AspRunResult_OK && !deadline.expired
+           #ifdef ASP_DEBUG
+           && (stepCountLimit == UINT_MAX || stepCount < stepCountLimit)
+           #endif
+           )
+    {
+        // Execute a batch of instructions. The engine returns early if an
+        // application function (e.g., sleep) needs to be called again.
+        uint32_t stepLimit = codeTraceFile == nullptr ? RUN_STEP_LIMIT : 1;
+        if (callStackFile != nullptr &&
+            sampleInterval - sampleStepCount < stepLimit)
+            stepLimit = sampleInterval - sampleStepCount;
+        #ifdef ASP_DEBUG
+        if (stepCountLimit != UINT_MAX &&
+            stepCountLimit - stepCount < stepLimit)
+            stepLimit = stepCountLimit - stepCount;
+        #endif
+        uint32_t runStepCount;
+        size_t programCounter = AspProgramCounter(&engine);
+        runResult = AspRun(&engine, stepLimit, &runStepCount);
+        stepCount += runStepCount;
+
+        // Sample the call stack once enough instructions have executed.
+        if (callStackFile != nullptr)
+        {
+            sampleStepCount += runStepCount;
+            if (sampleStepCount >= sampleInterval)
+            {
+                sampleStepCount = 0;
+                if (runResult == AspRunResult_OK)
+                    SampleCallStack(&engine, callStackSamples);
+            }
+        }
+
+        // Record any transfer of control.
+        if (codeTraceFile != nullptr)
+        {
+            size_t nextProgramCounter = AspProgramCounter(&engine);
+            if (nextProgramCounter < programCounter ||
+                nextProgramCounter >
+                programCounter + CODE_TRACE_ADVANCE_LIMIT)
+                fprintf
+                    (codeTraceFile, "0x%07zX\n0x%07zX\n",
+                     programCounter, nextProgramCounter);
+        }
         if (context.sleeping)
         {
             while (clock() < context.expiry) ;
             context.sleeping = false;
         }
+
+        // Start the next run, if any, from the initial state.
+        if (runResult == AspRunResult_Complete &&
+            ++completedRunCount < runCount)
+        {
+            runResult = AspRestoreSnapshot
+                (&engine, snapshot.get(), snapshotSize);
+        }
     }
 
+    auto runTime = chrono::duration<double>
+        (chrono::steady_clock::now() - runStartTime).count();
+
     // Close the executable if not already done (e.g., in code paging mode).
     if (executableFile != nullptr)
     {
@@ -601,54 +1300,71 @@ int main(int argc, char **argv)
     if (runResult != AspRunResult_Complete)
     #endif
     {
-        fprintf
-            (statusFile,
-             "Run error 0x%02X: %s\n",
-             runResult, AspRunResultToString(static_cast<int>(runResult)));
-
-        // Report the program counter.
-        auto programCounter = AspProgramCounter(&engine);
-        fprintf(statusFile, "Program counter: 0x%07zX", programCounter);
-
-        // Attempt to translate the program counter into a source location
-        // using the associated source info file.
-        size_t suffixPos =
-            executableFileName.size() - executableSuffix.size();
-        static const string sourceInfoSuffix = ".aspd";
-        string sourceInfoFileName =
-            executableFileName.substr(0, suffixPos) + sourceInfoSuffix;
-        AspSourceInfo *sourceInfo = AspLoadSourceInfoFromFile
-            (sourceInfoFileName.c_str());
-        if (sourceInfo != nullptr)
-        {
-            AspSourceLocation sourceLocation = AspGetSourceLocation
-                (sourceInfo, programCounter);
-            if (sourceLocation.fileName != nullptr)
-            {
-                fprintf
-                    (statusFile, "; %s:%u:%u",
-                     sourceLocation.fileName,
-                     sourceLocation.line, sourceLocation.column);
-            }
-            AspUnloadSourceInfo(sourceInfo);
-        }
-        fputc('\n', statusFile);
+        if (deadline.expired)
+            fprintf
+                (statusFile,
+                 "Time limit of %g s reached at program counter 0x%07zX\n",
+                 timeLimit, AspProgramCounter(&engine));
+        else
+            ReportRunError
+                (statusFile, runResult, AspProgramCounter(&engine),
+                 sourceInfoFileName);
     }
 
-    // Report low free count.
+    // Report execution statistics.
     if (verbose)
     {
+        fprintf
+            (reportFile, "Load time: %.6f s (%s)\n", loadTime, loadMethod);
+        if (runCount > 1)
+            fprintf
+                (reportFile, "Run count: %u (snapshot %zu bytes)\n",
+                 completedRunCount, snapshotSize);
+        fprintf
+            (reportFile, "Instruction count: %u\n", stepCount);
+        fprintf
+            (reportFile, "Run time: %.6f s (%.0f instructions/s)\n",
+             runTime, runTime > 0.0 ? stepCount / runTime : 0.0);
         fprintf
             (reportFile, "Low free count: %zu (max %zu)\n",
              AspLowFreeCount(&engine), AspMaxDataSize(&engine));
+        fprintf
+            (reportFile, "Shared character string count: %zu\n",
+             AspCharacterStringShareCount(&engine, false));
+        fprintf
+            (reportFile, "Shared string literal count: %zu\n",
+             AspStringLiteralShareCount(&engine, false));
         if (codePageByteCount != 0)
         {
             fprintf
                 (reportFile, "Code page read count: %zu\n",
                  AspCodePageReadCount(&engine, false));
+            fprintf
+                (reportFile, "Code page hit count: %zu\n",
+                 AspCodePageHitCount(&engine, false));
+            #ifdef HAVE_POSIX_FADVISE
+            if (prefetchCode)
+                fprintf
+                    (reportFile, "Code page prefetch count: %zu\n",
+                     codePagePrefetchCount.load());
+            #endif
         }
     }
 
+    if (reportData)
+        ReportDataStatistics(reportFile, &engine);
+
+    if (callStackFile != nullptr)
+        WriteCallStackSamples
+            (callStackFile, callStackSamples, sourceInfoFileName);
+
+    #ifdef ASP_OPCODE_PROFILE
+    if (profileTopCount != 0)
+        ReportOpCodeProfile(reportFile, opCodeProfile, profileTopCount);
+    if (profileFile != nullptr)
+        WriteProfile(profileFile, profile);
+    #endif
+
     CloseFiles(openedFiles);
 
     return runResult == AspRunResult_Complete ? 0 : 2;
@@ -671,3 +1387,313 @@ static AspRunResult LoadCodePage
 
     return AspRunResult_OK;
 }
+
+static AspRunResult LoadSharedCodePage
+    (void *id, uint32_t offset, size_t *size, void *codePage)
+{
+    // The shared cache reads pages without holding its lock, so engines
+    // may call this at the same time. Keep each seek and read together.
+    lock_guard<mutex> lock(sharedCodePageMutex);
+    return LoadCodePage(id, offset, size, codePage);
+}
+
+#ifdef HAVE_POSIX_FADVISE
+static void PrefetchCodePage(void *id, uint32_t offset, size_t size)
+{
+    // Let the system read the page in the background, so that the
+    // subsequent read by LoadCodePage is satisfied from memory.
+    auto executableFile = static_cast<FILE *>(id);
+    codePagePrefetchCount++;
+    posix_fadvise
+        (fileno(executableFile), static_cast<off_t>(offset),
+         static_cast<off_t>(size), POSIX_FADV_WILLNEED);
+}
+#endif
+
+static void LockCodePageCache(void *context, bool lock)
+{
+    auto &codePageCacheMutex = *static_cast<mutex *>(context);
+    if (lock)
+        codePageCacheMutex.lock();
+    else
+        codePageCacheMutex.unlock();
+}
+
+static void RunArgumentSets
+    (const AspEngine *engine, size_t dataByteSize,
+     const vector<string> &argumentSets, unsigned threadCount,
+     vector<ArgumentSetRun> &runs)
+{
+    // Each worker runs a fork of the loaded engine for each argument set it
+    // takes, reusing its own data area. The forks share the engine's code,
+    // or its code page cache in paging mode.
+    atomic<size_t> nextIndex(0);
+    auto work = [&]()
+    {
+        auto data = unique_ptr<char[]>(new char[dataByteSize]);
+        StandaloneAspContext context;
+        AspEngine fork;
+        size_t index;
+        while ((index = nextIndex++) < argumentSets.size())
+        {
+            auto &run = runs[index];
+            context.sleeping = false;
+            context.output = &run.output;
+            run.result = AspFork
+                (engine, &fork, data.get(), dataByteSize, &context);
+            if (run.result != AspRunResult_OK)
+                continue;
+            run.result = AspSetArgumentsString
+                (&fork, argumentSets[index].c_str());
+            while (run.result == AspRunResult_OK)
+            {
+                uint32_t runStepCount;
+                run.result = AspRun(&fork, RUN_STEP_LIMIT, &runStepCount);
+                run.stepCount += runStepCount;
+                if (context.sleeping)
+                {
+                    while (clock() < context.expiry) ;
+                    context.sleeping = false;
+                }
+            }
+            run.programCounter = AspProgramCounter(&fork);
+            run.codePageReadCount = AspCodePageReadCount(&fork, false);
+            run.codePageHitCount = AspCodePageHitCount(&fork, false);
+            AspUnshareCodePages(&fork);
+        }
+    };
+
+    vector<thread> workers;
+    for (unsigned i = 1; i < threadCount && i < argumentSets.size(); i++)
+        workers.emplace_back(work);
+    work();
+    for (auto &worker: workers)
+        worker.join();
+}
+
+static void ReportRunError
+    (FILE *statusFile, AspRunResult runResult, size_t programCounter,
+     const string &sourceInfoFileName)
+{
+    fprintf
+        (statusFile,
+         "Run error 0x%02X: %s\n",
+         runResult, AspRunResultToString(static_cast<int>(runResult)));
+
+    // Report the program counter.
+    fprintf(statusFile, "Program counter: 0x%07zX", programCounter);
+
+    // Attempt to translate the program counter into a source location
+    // using the associated source info file.
+    AspSourceInfo *sourceInfo = AspLoadSourceInfoFromFile
+        (sourceInfoFileName.c_str());
+    if (sourceInfo != nullptr)
+    {
+        AspSourceLocation sourceLocation = AspGetSourceLocation
+            (sourceInfo, programCounter);
+        if (sourceLocation.fileName != nullptr)
+        {
+            fprintf
+                (statusFile, "; %s:%u:%u",
+                 sourceLocation.fileName,
+                 sourceLocation.line, sourceLocation.column);
+        }
+        AspUnloadSourceInfo(sourceInfo);
+    }
+    fputc('\n', statusFile);
+}
+
+static bool CheckDeadline(void *context)
+{
+    auto deadline = static_cast<RunDeadline *>(context);
+    if (chrono::steady_clock::now() >= deadline->time)
+        deadline->expired = true;
+    return !deadline->expired;
+}
+
+static void ReportDataStatistics(FILE *reportFile, const AspEngine *engine)
+{
+    AspDataStatistics statistics;
+    AspGetDataStatistics(engine, &statistics);
+
+    fputs("Data entries in use by type:\n", reportFile);
+    size_t totalCount = 0;
+    for (unsigned type = 0; type < 256; type++)
+    {
+        auto count = statistics.entryCounts[type];
+        if (count == 0)
+            continue;
+        const char *name = AspDataTypeName(static_cast<uint8_t>(type));
+        fprintf
+            (reportFile, "%12lu  0x%02X %s\n",
+             static_cast<unsigned long>(count), type,
+             name == nullptr ? "?" : name);
+        totalCount += count;
+    }
+    fprintf(reportFile, "%12zu  total\n", totalCount);
+    fprintf
+        (reportFile, "Free count: %zu (low %zu, max %zu)\n",
+         statistics.freeCount, statistics.lowFreeCount,
+         AspMaxDataSize(engine));
+    fprintf
+        (reportFile, "Stack depth: %u (peak %u)\n",
+         statistics.stackDepth, statistics.peakStackDepth);
+}
+
+static void SampleCallStack
+    (const AspEngine *engine, CallStackSamples &samples)
+{
+    // Record the current program counter followed by the return address
+    // of each frame.
+    vector<size_t> addresses(1, AspProgramCounter(engine));
+    size_t frameCount = AspCallStack(engine, nullptr, 0);
+    addresses.resize(1 + frameCount);
+    AspCallStack(engine, addresses.data() + 1, frameCount);
+    samples[addresses]++;
+}
+
+static void WriteCallStackSamples
+    (FILE *callStackFile, const CallStackSamples &samples,
+     const string &sourceInfoFileName)
+{
+    // Name each frame after the module or function containing the code
+    // address if known, or else after the address's source location. Code
+    // without a source location is the top-level code that loads the main
+    // module.
+    AspSourceInfo *sourceInfo = AspLoadSourceInfoFromFile
+        (sourceInfoFileName.c_str());
+    map<size_t, string> frameNames;
+    auto frameName = [&](size_t address) -> const string &
+    {
+        auto iter = frameNames.find(address);
+        if (iter != frameNames.end())
+            return iter->second;
+
+        ostringstream oss;
+        AspFunctionLocation functionLocation = {};
+        AspSourceLocation sourceLocation = {};
+        if (sourceInfo != nullptr)
+        {
+            functionLocation = AspGetFunctionLocation(sourceInfo, address);
+            sourceLocation = AspGetSourceLocation(sourceInfo, address);
+        }
+        if (functionLocation.name != nullptr)
+        {
+            if (functionLocation.location.line == 0)
+                oss
+                    << "module " << functionLocation.name << " ("
+                    << functionLocation.location.fileName << ')';
+            else
+                oss
+                    << functionLocation.name << " ("
+                    << functionLocation.location.fileName << ':'
+                    << functionLocation.location.line << ')';
+        }
+        else if (sourceLocation.fileName != nullptr &&
+                 sourceLocation.line != 0)
+            oss << sourceLocation.fileName << ':' << sourceLocation.line;
+        else if (sourceInfo != nullptr)
+            oss << "(top level)";
+        else
+            oss
+                << "0x" << hex << uppercase << setfill('0') << setw(7)
+                << address;
+        return frameNames[address] = oss.str();
+    };
+
+    // Fold identical stacks of frame names together, writing each with
+    // the outermost frame first.
+    map<string, unsigned long long> foldedSamples;
+    for (const auto &sample: samples)
+    {
+        string stack;
+        const auto &addresses = sample.first;
+        for (auto iter = addresses.rbegin(); iter != addresses.rend(); iter++)
+        {
+            if (!stack.empty())
+                stack += ';';
+            stack += frameName(*iter);
+        }
+        foldedSamples[stack] += sample.second;
+    }
+    for (const auto &foldedSample: foldedSamples)
+        fprintf
+            (callStackFile, "%s %llu\n",
+             foldedSample.first.c_str(), foldedSample.second);
+
+    if (sourceInfo != nullptr)
+        AspUnloadSourceInfo(sourceInfo);
+}
+
+#ifdef ASP_OPCODE_PROFILE
+static void ProfileOpCode(void *context, uint8_t opCode)
+{
+    auto &profile = *static_cast<OpCodeProfile *>(context);
+
+    // Count the sequences of each length that end with this instruction.
+    profile.history = (profile.history << 8) | opCode;
+    if (profile.historySize < OpCodeProfile::MAX_LENGTH)
+        profile.historySize++;
+    for (unsigned length = 1; length <= profile.historySize; length++)
+    {
+        uint32_t key = profile.history & ((1U << (length * 8)) - 1U);
+        profile.counts[length - 1][key]++;
+    }
+}
+
+static void ReportOpCodeProfile
+    (FILE *reportFile, const OpCodeProfile &profile, unsigned topCount)
+{
+    for (unsigned length = 1; length <= OpCodeProfile::MAX_LENGTH; length++)
+    {
+        const auto &counts = profile.counts[length - 1];
+        vector<pair<uint32_t, unsigned long long> > sorted
+            (counts.begin(), counts.end());
+        stable_sort
+            (sorted.begin(), sorted.end(),
+             [](const pair<uint32_t, unsigned long long> &left,
+                const pair<uint32_t, unsigned long long> &right)
+             {
+                 return left.second > right.second;
+             });
+        if (sorted.size() > topCount)
+            sorted.resize(topCount);
+
+        fprintf
+            (reportFile, "Most frequent %u-instruction sequences:\n", length);
+        for (const auto &entry: sorted)
+        {
+            fprintf(reportFile, "%12llu ", entry.second);
+            for (unsigned i = length; i-- > 0;)
+                fprintf
+                    (reportFile, " 0x%02X",
+                     static_cast<unsigned>((entry.first >> (i * 8)) & 0xFF));
+            fputc('\n', reportFile);
+        }
+    }
+}
+
+static void WriteProfile(FILE *profileFile, const AspProfile &profile)
+{
+    // Write the counts for each op code executed, then those for each code
+    // address executed.
+    for (unsigned opCode = 0; opCode < 256; opCode++)
+    {
+        if (profile.opCodeCounts[opCode] == 0 &&
+            profile.allocationCounts[opCode] == 0)
+            continue;
+        fprintf
+            (profileFile, "op 0x%02X %lu %lu\n", opCode,
+             static_cast<unsigned long>(profile.opCodeCounts[opCode]),
+             static_cast<unsigned long>(profile.allocationCounts[opCode]));
+    }
+    for (size_t address = 0; address < profile.pcCountsSize; address++)
+    {
+        if (profile.pcCounts[address] == 0)
+            continue;
+        fprintf
+            (profileFile, "pc 0x%07zX %lu\n", address,
+             static_cast<unsigned long>(profile.pcCounts[address]));
+    }
+}
+#endif
@@ -0,0 +1,128 @@
+//
+// Source info lookup benchmark main.
+//
+
+#include "asp-info.h"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+static const unsigned DEFAULT_LOOKUP_COUNT = 1000000;
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        cerr << "Usage: bench-info SCRIPT [LOOKUPS]" << endl;
+        return 1;
+    }
+    string scriptName = argv[1];
+    unsigned lookupCount = argc == 3 ?
+        static_cast<unsigned>(atoi(argv[2])) : DEFAULT_LOOKUP_COUNT;
+    if (lookupCount == 0)
+        lookupCount = 1;
+
+    // Determine the code size from the executable, whose header precedes
+    // the code.
+    string executableFileName = scriptName + ".aspe";
+    FILE *file = fopen(executableFileName.c_str(), "rb");
+    if (file == nullptr)
+    {
+        cerr << "Error opening " << executableFileName << endl;
+        return 2;
+    }
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fclose(file);
+    static const long headerSize = 12;
+    if (fileSize <= headerSize)
+    {
+        cerr << "Error reading " << executableFileName << endl;
+        return 2;
+    }
+    auto codeSize = static_cast<size_t>(fileSize - headerSize);
+
+    // Load the source info.
+    string sourceInfoFileName = scriptName + ".aspd";
+    auto loadStartTime = chrono::steady_clock::now();
+    AspSourceInfo *sourceInfo = AspLoadSourceInfoFromFile
+        (sourceInfoFileName.c_str());
+    auto loadTime = chrono::duration<double, micro>
+        (chrono::steady_clock::now() - loadStartTime).count();
+    if (sourceInfo == nullptr)
+    {
+        cerr << "Error loading " << sourceInfoFileName << endl;
+        return 2;
+    }
+    int32_t symbolLimit = 0;
+    for (;; symbolLimit++)
+    {
+        const char *name = AspGetSymbolName(sourceInfo, symbolLimit);
+        if (name == nullptr || *name == '\0')
+            break;
+    }
+
+    // Choose the code addresses and symbols to look up in advance, so that
+    // only the lookups are timed.
+    mt19937 generator(1);
+    uniform_int_distribution<size_t> pcDistribution(0, codeSize - 1);
+    uniform_int_distribution<int32_t> symbolDistribution
+        (0, symbolLimit == 0 ? 0 : symbolLimit - 1);
+    vector<size_t> pcs(lookupCount);
+    vector<int32_t> symbols(lookupCount);
+    for (unsigned i = 0; i < lookupCount; i++)
+    {
+        pcs[i] = pcDistribution(generator);
+        symbols[i] = symbolDistribution(generator);
+    }
+
+    cout
+        << "Looking up " << lookupCount << " values in "
+        << sourceInfoFileName << " (" << codeSize << " bytes of code, "
+        << symbolLimit << " symbols, loaded in "
+        << fixed << setprecision(2) << loadTime << " us):" << endl;
+    unsigned long long checksum = 0;
+
+    auto startTime = chrono::steady_clock::now();
+    for (auto pc: pcs)
+        checksum += AspGetSourceLocation(sourceInfo, pc).line;
+    auto time = chrono::duration<double, nano>
+        (chrono::steady_clock::now() - startTime).count();
+    cout
+        << setw(20) << left << "source location" << right
+        << setw(10) << time / lookupCount << " ns" << endl;
+
+    startTime = chrono::steady_clock::now();
+    for (auto pc: pcs)
+        checksum += AspGetFunctionLocation(sourceInfo, pc).location.line;
+    time = chrono::duration<double, nano>
+        (chrono::steady_clock::now() - startTime).count();
+    cout
+        << setw(20) << left << "function location" << right
+        << setw(10) << time / lookupCount << " ns" << endl;
+
+    startTime = chrono::steady_clock::now();
+    for (auto symbol: symbols)
+    {
+        const char *name = AspGetSymbolName(sourceInfo, symbol);
+        if (name != nullptr)
+            checksum += static_cast<unsigned char>(*name);
+    }
+    time = chrono::duration<double, nano>
+        (chrono::steady_clock::now() - startTime).count();
+    cout
+        << setw(20) << left << "symbol name" << right
+        << setw(10) << time / lookupCount << " ns" << endl;
+
+    cout << "Checksum: " << checksum << endl;
+
+    AspUnloadSourceInfo(sourceInfo);
+    return 0;
+}
@@ -0,0 +1,192 @@
+//
+// Executable loading benchmark main.
+//
+
+#include "asp.h"
+#include "asp-priv.h"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+enum class LoadMethod
+{
+    Mapped,
+    Read,
+    Streamed,
+    ByteByByte,
+};
+
+static bool Load
+    (LoadMethod, const char *fileName, size_t fileSize, AspEngine *,
+     const AspAppSpec *, char *code, char *data);
+
+static const size_t DATA_ENTRY_COUNT = 256;
+static const unsigned DEFAULT_ITERATION_COUNT = 1000;
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        cerr << "Usage: bench-load SCRIPT.aspe [ITERATIONS]" << endl;
+        return 1;
+    }
+    const char *fileName = argv[1];
+    unsigned iterationCount = argc == 3 ?
+        static_cast<unsigned>(atoi(argv[2])) : DEFAULT_ITERATION_COUNT;
+    if (iterationCount == 0)
+        iterationCount = 1;
+
+    // Determine the size of the executable and its check value. Loading
+    // does not involve the application's functions, so an empty
+    // specification with a matching check value suffices.
+    FILE *file = fopen(fileName, "rb");
+    if (file == nullptr)
+    {
+        cerr << "Error opening " << fileName << endl;
+        return 2;
+    }
+    unsigned char header[12];
+    bool headerRead = fread(header, sizeof header, 1, file) == 1;
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fclose(file);
+    if (!headerRead || fileSize < 0)
+    {
+        cerr << "Error reading " << fileName << endl;
+        return 2;
+    }
+    uint32_t checkValue = 0;
+    for (unsigned i = 8; i < 12; i++)
+        checkValue = (checkValue << 8) | header[i];
+    AspAppSpec appSpec = {"", 0, checkValue, nullptr};
+
+    auto code = unique_ptr<char[]>(new char[fileSize]);
+    auto data = unique_ptr<char[]>
+        (new char[DATA_ENTRY_COUNT * AspDataEntrySize()]);
+
+    static const struct
+    {
+        LoadMethod method;
+        const char *name;
+    } methods[] =
+    {
+        #ifdef HAVE_MMAP
+        {LoadMethod::Mapped, "mapped"},
+        #endif
+        {LoadMethod::Read, "read"},
+        {LoadMethod::Streamed, "streamed"},
+        {LoadMethod::ByteByByte, "byte-by-byte"},
+    };
+
+    cout
+        << "Loading " << fileName << " (" << fileSize << " bytes) "
+        << iterationCount << " times:" << endl;
+    for (const auto &method: methods)
+    {
+        auto startTime = chrono::steady_clock::now();
+        for (unsigned i = 0; i < iterationCount; i++)
+        {
+            AspEngine engine;
+            if (!Load
+                    (method.method, fileName, static_cast<size_t>(fileSize),
+                     &engine, &appSpec, code.get(), data.get()))
+            {
+                cerr << "Error loading using " << method.name << endl;
+                return 2;
+            }
+        }
+        auto time = chrono::duration<double, micro>
+            (chrono::steady_clock::now() - startTime).count();
+        cout
+            << setw(14) << left << method.name << right
+            << fixed << setprecision(2) << setw(10)
+            << time / iterationCount << " us" << endl;
+    }
+
+    return 0;
+}
+
+static bool Load
+    (LoadMethod method, const char *fileName, size_t fileSize,
+     AspEngine *engine, const AspAppSpec *appSpec, char *code, char *data)
+{
+    bool external = method == LoadMethod::Mapped || method == LoadMethod::Read;
+    AspRunResult initializeResult = AspInitialize
+        (engine,
+         external ? nullptr : code, external ? 0 : fileSize,
+         data, DATA_ENTRY_COUNT * AspDataEntrySize(),
+         appSpec, nullptr);
+    if (initializeResult != AspRunResult_OK)
+        return false;
+
+    FILE *file = fopen(fileName, "rb");
+    if (file == nullptr)
+        return false;
+
+    AspAddCodeResult result = AspAddCodeResult_OK;
+    switch (method)
+    {
+        case LoadMethod::Mapped:
+        {
+            #ifdef HAVE_MMAP
+            void *address = mmap
+                (nullptr, fileSize, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+            fclose(file);
+            if (address == MAP_FAILED)
+                return false;
+            result = AspSealCode(engine, address, fileSize);
+            munmap(address, fileSize);
+            return result == AspAddCodeResult_OK;
+            #else
+            fclose(file);
+            return false;
+            #endif
+        }
+
+        case LoadMethod::Read:
+        {
+            auto externalCode = unique_ptr<char[]>(new char[fileSize]);
+            bool readOK = fread(externalCode.get(), fileSize, 1, file) == 1;
+            fclose(file);
+            if (!readOK)
+                return false;
+            result = AspSealCode(engine, externalCode.get(), fileSize);
+            return result == AspAddCodeResult_OK;
+        }
+
+        case LoadMethod::Streamed:
+        {
+            char buffer[BUFSIZ];
+            size_t readCount;
+            while (result == AspAddCodeResult_OK &&
+                   (readCount = fread(buffer, 1, sizeof buffer, file)) != 0)
+                result = AspAddCode(engine, buffer, readCount);
+            break;
+        }
+
+        case LoadMethod::ByteByByte:
+        {
+            int c;
+            while (result == AspAddCodeResult_OK && (c = fgetc(file)) != EOF)
+            {
+                auto byte = static_cast<char>(c);
+                result = AspAddCode(engine, &byte, 1);
+            }
+            break;
+        }
+    }
+
+    fclose(file);
+    if (result == AspAddCodeResult_OK)
+        result = AspSeal(engine);
+    return result == AspAddCodeResult_OK;
+}
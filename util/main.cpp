@@ -5,8 +5,14 @@
 #include "asp-info.h"
 #include <iostream>
 #include <iomanip>
+#include <fstream>
+#include <sstream>
 #include <stdexcept>
+#include <algorithm>
+#include <map>
+#include <vector>
 #include <string>
+#include <tuple>
 #include <cstring>
 #include <cerrno>
 
@@ -16,6 +22,9 @@ using namespace std;
 #error COMMAND_OPTION_PREFIXES macro undefined
 #endif
 
+static bool ReportProfile
+    (const AspSourceInfo *, const string &profileFileName);
+
 static void Usage()
 {
     cerr
@@ -27,8 +36,10 @@ static void Usage()
         << " Some options require INFO, the Asp\n"
         << "source info file (*.aspd). The suffix may be omitted."
         << " The INFO argument may be\n"
-        << "omitted if neither " << COMMAND_OPTION_PREFIXES[0] << "l nor "
-        << COMMAND_OPTION_PREFIXES[0] << "p is used.\n"
+        << "omitted if none of " << COMMAND_OPTION_PREFIXES[0] << "f, "
+        << COMMAND_OPTION_PREFIXES[0] << "l, "
+        << COMMAND_OPTION_PREFIXES[0] << "p, or "
+        << COMMAND_OPTION_PREFIXES[0] << "s is used.\n"
         << "\n"
         << "Use " << COMMAND_OPTION_PREFIXES[0] << COMMAND_OPTION_PREFIXES[0]
         << " before the INFO argument if it starts with an option prefix.\n"
@@ -52,6 +63,11 @@ static void Usage()
         << COMMAND_OPTION_PREFIXES[0]
         << "e code     Translate the run result to descriptive text.\n"
         << COMMAND_OPTION_PREFIXES[0]
+        << "f file     Report the execution counts in the given profile"
+        << " (written by\n"
+        << "            asps " << COMMAND_OPTION_PREFIXES[0]
+        << "F) by source line and by function.\n"
+        << COMMAND_OPTION_PREFIXES[0]
         << "l          List all source files.\n"
         << COMMAND_OPTION_PREFIXES[0]
         << "p pc       Translate program counter source location.\n"
@@ -84,7 +100,8 @@ int main(int argc, char **argv)
         }
 
         string option = arg.substr(1);
-        if (option == "e" || option == "a" || option == "p" || option == "s")
+        if (option == "e" || option == "a" || option == "f" ||
+            option == "p" || option == "s")
             argIndex++;
     }
 
@@ -130,14 +147,15 @@ int main(int argc, char **argv)
         string option = arg.substr(1);
 
         if (sourceInfo == nullptr &&
-            (option == "l" || option == "p" || option == "s"))
+            (option == "f" || option == "l" || option == "p" ||
+             option == "s"))
         {
             cerr
                 << arg
                 << " option ignored in absence of source info file"
                 << endl;
 
-            if (option == "p")
+            if (option == "f" || option == "p" || option == "s")
                 ++optionIndex;
 
             continue;
@@ -232,6 +250,11 @@ int main(int argc, char **argv)
                 cout << endl;
             }
         }
+        else if (option == "f")
+        {
+            if (!ReportProfile(sourceInfo, argv[++optionIndex]))
+                break;
+        }
         else if (option == "l")
         {
             cout << "Source file names:" << endl;
@@ -251,3 +274,127 @@ int main(int argc, char **argv)
 
     return 0;
 }
+
+static bool ReportProfile
+    (const AspSourceInfo *sourceInfo, const string &profileFileName)
+{
+    ifstream profileFile(profileFileName);
+    if (!profileFile)
+    {
+        cerr
+            << "Error opening " << profileFileName << ": "
+            << strerror(errno) << endl;
+        return false;
+    }
+
+    // Fold the execution count of each code address into those of its
+    // source line and of the module or function containing it.
+    using Line = tuple<string, unsigned>;
+    using Function = tuple<string, unsigned, string>;
+    map<Line, unsigned long long> lineCounts;
+    map<Function, unsigned long long> functionCounts;
+    unsigned long long totalCount = 0;
+    string profileLine;
+    for (unsigned lineNumber = 1; getline(profileFile, profileLine);
+         lineNumber++)
+    {
+        istringstream iss(profileLine);
+        string kind, address;
+        unsigned long long count;
+        iss >> kind;
+        if (kind != "pc")
+            continue;
+        iss >> address >> count;
+        size_t pc = 0;
+        size_t scannedSize = 0;
+        try
+        {
+            pc = static_cast<size_t>(stoul(address, &scannedSize, 0));
+        }
+        catch (const logic_error &)
+        {
+            scannedSize = 0;
+        }
+        if (!iss || scannedSize != address.size())
+        {
+            cerr
+                << profileFileName << ':' << lineNumber
+                << ": Invalid profile entry" << endl;
+            return false;
+        }
+
+        auto sourceLocation = AspGetSourceLocation(sourceInfo, pc);
+        auto fileName = sourceLocation.fileName == nullptr ?
+            string("?") : string(sourceLocation.fileName);
+        lineCounts[Line(fileName, sourceLocation.line)] += count;
+
+        auto functionLocation = AspGetFunctionLocation(sourceInfo, pc);
+        auto functionFileName = functionLocation.location.fileName == nullptr ?
+            string() : string(functionLocation.location.fileName);
+        auto functionName = functionLocation.name == nullptr ?
+            string() : string(functionLocation.name);
+        functionCounts[Function
+            (functionFileName, functionLocation.location.line,
+             functionName)] += count;
+
+        totalCount += count;
+    }
+
+    // Report the counts in descending order.
+    auto percent = [totalCount](unsigned long long count)
+    {
+        return totalCount == 0 ? 0.0 : 100.0 * count / totalCount;
+    };
+    auto oldFlags = cout.flags();
+    cout << fixed << setprecision(2);
+
+    vector<pair<Line, unsigned long long> > sortedLineCounts
+        (lineCounts.begin(), lineCounts.end());
+    stable_sort
+        (sortedLineCounts.begin(), sortedLineCounts.end(),
+         [](const pair<Line, unsigned long long> &left,
+            const pair<Line, unsigned long long> &right)
+         {
+             return left.second > right.second;
+         });
+    cout << "Instructions executed by source line:" << endl;
+    for (const auto &entry: sortedLineCounts)
+    {
+        cout
+            << setw(12) << entry.second << ' '
+            << setw(6) << percent(entry.second) << "%  "
+            << get<0>(entry.first) << ':' << get<1>(entry.first) << endl;
+    }
+    cout << '-' << endl;
+
+    vector<pair<Function, unsigned long long> > sortedFunctionCounts
+        (functionCounts.begin(), functionCounts.end());
+    stable_sort
+        (sortedFunctionCounts.begin(), sortedFunctionCounts.end(),
+         [](const pair<Function, unsigned long long> &left,
+            const pair<Function, unsigned long long> &right)
+         {
+             return left.second > right.second;
+         });
+    cout << "Instructions executed by function:" << endl;
+    for (const auto &entry: sortedFunctionCounts)
+    {
+        const auto &fileName = get<0>(entry.first);
+        auto line = get<1>(entry.first);
+        const auto &name = get<2>(entry.first);
+        cout
+            << setw(12) << entry.second << ' '
+            << setw(6) << percent(entry.second) << "%  ";
+        if (name.empty())
+            cout << "(top level)";
+        else if (line == 0)
+            cout << "module " << name << " (" << fileName << ')';
+        else
+            cout << name << " (" << fileName << ':' << line << ')';
+        cout << endl;
+    }
+    cout << '-' << endl;
+
+    cout.flags(oldFlags);
+    return true;
+}